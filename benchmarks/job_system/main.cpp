@@ -0,0 +1,228 @@
+#include "core/job_system.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <iostream>
+
+using namespace time_kill;
+using namespace time_kill::core;
+
+namespace {
+    constexpr auto USAGE =
+        "Usage: time_kill_job_bench [options]\n"
+        "Compares core::JobSystem with std::async and core::ThreadPool on fine-grained tasks.\n"
+        "\n"
+        "Options:\n"
+        "  --tasks=<n>     Tasks per scenario (default: 100000)\n"
+        "  --work=<n>      Busy-loop iterations per task (default: 200)\n"
+        "  --runs=<n>      Runs per measurement, the median is reported (default: 5)\n"
+        "  --threads=<n>   Worker threads besides the main thread (default: cores - 1)\n";
+
+    struct Options {
+        usize tasks = 100000;
+        usize work = 200;
+        usize runs = 5;
+        usize threads = JobSystem::defaultWorkerCount();
+    };
+
+    Optional<Options> parseOptions(const int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const String arg = argv[i];
+            const auto number = [&](const StringView prefix) -> Optional<usize> {
+                if (!arg.starts_with(prefix)) {
+                    return std::nullopt;
+                }
+                try {
+                    return static_cast<usize>(std::stoull(arg.substr(prefix.size())));
+                } catch (const std::exception&) {
+                    return std::nullopt;
+                }
+            };
+
+            if (const auto value = number("--tasks=")) {
+                options.tasks = std::max<usize>(*value, 1);
+            } else if (const auto value = number("--work=")) {
+                options.work = *value;
+            } else if (const auto value = number("--runs=")) {
+                options.runs = std::max<usize>(*value, 1);
+            } else if (const auto value = number("--threads=")) {
+                options.threads = *value;
+            } else {
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    // Stand-in for a small engine task (a transform update, a culling test, ...)
+    u64 busyWork(const usize iterations, u64 seed) {
+        for (usize i = 0; i < iterations; ++i) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+        }
+        return seed;
+    }
+
+    // Results are summed so the work cannot be optimized away
+    std::atomic<u64> Sink = 0;
+
+    template<typename Function>
+    f64 medianMilliseconds(const usize runs, const Function& function) {
+        Vector<f64> samples;
+        for (usize run = 0; run < runs; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<f64, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            samples.push_back(elapsed.count());
+        }
+        std::ranges::sort(samples);
+        return samples[samples.size() / 2];
+    }
+
+    void printHeader(const StringView scenario) {
+        std::printf("\n%.*s\n", static_cast<int>(scenario.size()), scenario.data());
+        std::printf("  %-28s %12s %12s %10s\n", "implementation", "total [ms]", "per task [ns]", "speedup");
+    }
+
+    void printResult(const StringView name, const f64 milliseconds, const usize tasks, const f64 baseline) {
+        std::printf("  %-28.*s %12.3f %12.1f %9.2fx\n", static_cast<int>(name.size()), name.data(), milliseconds,
+                    milliseconds * 1e6 / static_cast<f64>(tasks), baseline / milliseconds);
+    }
+}
+
+int main(const int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        std::cerr << USAGE;
+        return 1;
+    }
+    const usize tasks = options->tasks;
+    const usize work = options->work;
+
+    ThreadPool threadPool(options->threads);
+    JobSystem jobSystem(options->threads);
+
+    std::printf("%zu tasks, %zu iterations each, %zu worker threads, median of %zu runs\n",
+                tasks, work, options->threads, options->runs);
+
+    //=== Independent tasks submitted one by one from the main thread
+
+    printHeader("Independent tasks");
+    const f64 poolTasks = medianMilliseconds(options->runs, [&] {
+        for (usize i = 0; i < tasks; ++i) {
+            threadPool.submit([i, work] { Sink.fetch_add(busyWork(work, i + 1), std::memory_order_relaxed); });
+        }
+        threadPool.wait();
+    });
+
+    // One thread per task would measure thread creation only; cap the batch and scale the result
+    const usize asyncTasks = std::min<usize>(tasks, 10000);
+    const f64 asyncTime = medianMilliseconds(options->runs, [&] {
+        Vector<std::future<void>> futures;
+        futures.reserve(asyncTasks);
+        for (usize i = 0; i < asyncTasks; ++i) {
+            futures.push_back(std::async(std::launch::async, [i, work] {
+                Sink.fetch_add(busyWork(work, i + 1), std::memory_order_relaxed);
+            }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    }) * static_cast<f64>(tasks) / static_cast<f64>(asyncTasks);
+
+    const f64 jobTasks = medianMilliseconds(options->runs, [&] {
+        JobCounter counter;
+        for (usize i = 0; i < tasks; ++i) {
+            jobSystem.schedule([i, work] { Sink.fetch_add(busyWork(work, i + 1), std::memory_order_relaxed); }, counter);
+        }
+        jobSystem.wait(counter);
+    });
+
+    printResult("std::async (extrapolated)", asyncTime, tasks, poolTasks);
+    printResult("ThreadPool::submit", poolTasks, tasks, poolTasks);
+    printResult("JobSystem::schedule", jobTasks, tasks, poolTasks);
+
+    //=== Tasks spawned by tasks (e.g. per-object updates spawned per scene node)
+
+    printHeader("Nested tasks (64 children per parent)");
+    constexpr usize Children = 64;
+    const usize parents = std::max<usize>(tasks / Children, 1);
+
+    const f64 poolNested = medianMilliseconds(options->runs, [&] {
+        for (usize parent = 0; parent < parents; ++parent) {
+            threadPool.submit([&threadPool, parent, work] {
+                for (usize child = 0; child < Children; ++child) {
+                    threadPool.submit([parent, child, work] {
+                        Sink.fetch_add(busyWork(work, parent * Children + child + 1), std::memory_order_relaxed);
+                    });
+                }
+            });
+        }
+        threadPool.wait();
+    });
+
+    const f64 jobNested = medianMilliseconds(options->runs, [&] {
+        JobCounter counter;
+        for (usize parent = 0; parent < parents; ++parent) {
+            jobSystem.schedule([&jobSystem, &counter, parent, work] {
+                for (usize child = 0; child < Children; ++child) {
+                    jobSystem.schedule([parent, child, work] {
+                        Sink.fetch_add(busyWork(work, parent * Children + child + 1), std::memory_order_relaxed);
+                    }, counter);
+                }
+            }, counter);
+        }
+        jobSystem.wait(counter);
+    });
+
+    printResult("ThreadPool::submit", poolNested, parents * Children, poolNested);
+    printResult("JobSystem::schedule", jobNested, parents * Children, poolNested);
+
+    //=== Parallel for over an index range
+
+    printHeader("Parallel for");
+    const f64 poolFor = medianMilliseconds(options->runs, [&] {
+        threadPool.parallelFor(tasks, [work](const usize index, usize) {
+            Sink.fetch_add(busyWork(work, index + 1), std::memory_order_relaxed);
+        });
+    });
+
+    const f64 asyncFor = medianMilliseconds(options->runs, [&] {
+        const usize chunks = options->threads + 1;
+        const usize chunkSize = (tasks + chunks - 1) / chunks;
+        Vector<std::future<void>> futures;
+        for (usize begin = 0; begin < tasks; begin += chunkSize) {
+            futures.push_back(std::async(std::launch::async, [begin, end = std::min(begin + chunkSize, tasks), work] {
+                u64 sum = 0;
+                for (usize index = begin; index < end; ++index) {
+                    sum += busyWork(work, index + 1);
+                }
+                Sink.fetch_add(sum, std::memory_order_relaxed);
+            }));
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+    });
+
+    const f64 jobFor = medianMilliseconds(options->runs, [&] {
+        jobSystem.parallelFor(tasks, [work](const usize begin, const usize end) {
+            u64 sum = 0;
+            for (usize index = begin; index < end; ++index) {
+                sum += busyWork(work, index + 1);
+            }
+            Sink.fetch_add(sum, std::memory_order_relaxed);
+        });
+    });
+
+    printResult("std::async (one per thread)", asyncFor, tasks, poolFor);
+    printResult("ThreadPool::parallelFor", poolFor, tasks, poolFor);
+    printResult("JobSystem::parallelFor", jobFor, tasks, poolFor);
+
+    std::printf("\n(checksum %llu)\n", static_cast<unsigned long long>(Sink.load()));
+    return 0;
+}
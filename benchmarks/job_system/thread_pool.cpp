@@ -0,0 +1,135 @@
+#include "thread_pool.hpp"
+#include <atomic>
+#include <exception>
+
+namespace time_kill::core {
+    namespace {
+        thread_local usize CurrentWorker = SIZE_MAX;
+    }
+
+    ThreadPool::ThreadPool(const usize threadCount) {
+        threads_.reserve(threadCount);
+        for (usize i = 0; i < threadCount; ++i) {
+            threads_.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        taskAvailable_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::submit(Task task) {
+        if (threads_.empty()) {
+            task();
+            return;
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            queue_.push_back(std::move(task));
+            ++unfinished_;
+        }
+        taskAvailable_.notify_one();
+    }
+
+    void ThreadPool::wait() {
+        std::unique_lock lock(mutex_);
+        idle_.wait(lock, [this] { return unfinished_ == 0; });
+    }
+
+    void ThreadPool::parallelFor(const usize count, const IndexedTask& task) {
+        if (count == 0) {
+            return;
+        }
+
+        const usize callerIndex = threads_.size();
+        const usize helperCount = std::min(threads_.size(), count - 1);
+        if (helperCount == 0) {
+            for (usize index = 0; index < count; ++index) {
+                task(index, callerIndex);
+            }
+            return;
+        }
+
+        // Shared by the caller and the helpers; lives on the caller's stack until every helper is done
+        struct Batch {
+            std::atomic<usize> next = 0;
+            usize activeHelpers = 0;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable done;
+        } batch;
+        batch.activeHelpers = helperCount;
+
+        // The first exception stops handing out indices and is rethrown on the calling thread
+        const auto drain = [&batch, &task, count](const usize participant) {
+            try {
+                for (usize index = batch.next.fetch_add(1, std::memory_order_relaxed); index < count;
+                     index = batch.next.fetch_add(1, std::memory_order_relaxed)) {
+                    task(index, participant);
+                }
+            } catch (...) {
+                batch.next.store(count, std::memory_order_relaxed);
+                std::lock_guard lock(batch.mutex);
+                if (!batch.error) {
+                    batch.error = std::current_exception();
+                }
+            }
+        };
+
+        for (usize i = 0; i < helperCount; ++i) {
+            submit([&batch, &drain] {
+                drain(CurrentWorker);
+
+                std::lock_guard lock(batch.mutex);
+                if (--batch.activeHelpers == 0) {
+                    batch.done.notify_one();
+                }
+            });
+        }
+
+        drain(callerIndex);
+
+        std::unique_lock lock(batch.mutex);
+        batch.done.wait(lock, [&batch] { return batch.activeHelpers == 0; });
+        if (batch.error) {
+            std::rethrow_exception(batch.error);
+        }
+    }
+
+    usize ThreadPool::defaultThreadCount() {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+    void ThreadPool::workerLoop(const usize workerIndex) {
+        CurrentWorker = workerIndex;
+
+        while (true) {
+            Task task;
+            {
+                std::unique_lock lock(mutex_);
+                taskAvailable_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return; // Stopping and nothing left to run
+                }
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            task();
+
+            std::lock_guard lock(mutex_);
+            if (--unfinished_ == 0) {
+                idle_.notify_all();
+            }
+        }
+    }
+}
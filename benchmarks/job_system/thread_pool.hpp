@@ -0,0 +1,57 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace time_kill::core {
+    //! Fixed set of worker threads fed from one shared FIFO queue. The engine uses JobSystem; this
+    //! pool only remains as the baseline the job system benchmark compares against.
+    //!
+    //! parallelFor lets the calling thread take part in the work, so every call has
+    //! getParticipantCount() participants: workers 0 .. threadCount - 1 and the caller as index
+    //! threadCount. Callers use the participant index to pick per-thread resources without locking.
+    class ThreadPool {
+    public:
+        using Task = std::function<void()>;
+        using IndexedTask = std::function<void(usize index, usize participant)>;
+
+        //! Starts `threadCount` workers; defaultThreadCount() leaves one core for the calling thread.
+        explicit ThreadPool(usize threadCount = defaultThreadCount());
+
+        //! Finishes all queued tasks and joins the workers.
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        void submit(Task task);
+
+        //! Blocks until every task submitted so far has finished.
+        void wait();
+
+        //! Calls `task(index, participant)` for every index in [0, count) and blocks until all calls
+        //! have returned. Indices are handed out dynamically, so uneven tasks balance themselves.
+        void parallelFor(usize count, const IndexedTask& task);
+
+        [[nodiscard]] usize getThreadCount() const { return threads_.size(); }
+        [[nodiscard]] usize getParticipantCount() const { return threads_.size() + 1; }
+
+        //! Hardware concurrency minus one (the calling thread), at least zero.
+        [[nodiscard]] static usize defaultThreadCount();
+
+    private:
+        void workerLoop(usize workerIndex);
+
+        Vector<std::thread> threads_;
+        std::deque<Task> queue_;
+        std::mutex mutex_;
+        std::condition_variable taskAvailable_;
+        std::condition_variable idle_;
+        usize unfinished_ = 0; // Queued plus running tasks
+        bool stopping_ = false;
+    };
+}
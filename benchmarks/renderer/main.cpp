@@ -0,0 +1,650 @@
+#include "core/window.hpp"
+#include "graphics/vulkan_context.hpp"
+#include "graphics/vulkan_configuration.hpp"
+#include "graphics/vulkan_tools.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace time_kill;
+using namespace time_kill::graphics;
+
+namespace {
+    constexpr auto USAGE =
+        "Usage: time_kill_bench [options]\n"
+        "Renders a fixed workload for a number of frames and reports CPU and GPU frame times.\n"
+        "\n"
+        "Workload (also accepted per line of a script):\n"
+        "  --triangles=<n>   Triangles per frame (default: 100000)\n"
+        "  --draws=<n>       Draw calls the triangles are split into (default: 1000)\n"
+        "  --pipelines=<n>   Pipelines the draws are spread over, 1 to 32 (default: 1)\n"
+        "  --width=<n>       Render target width (default: 1280)\n"
+        "  --height=<n>      Render target height (default: 720)\n"
+        "  --frames=<n>      Measured frames (default: 1000)\n"
+        "  --warmup=<n>      Frames rendered before measuring (default: 100)\n"
+        "  --parallel        Record the draws in parallel on the job system\n"
+        "\n"
+        "Options:\n"
+        "  --script=<file>   Runs one scenario per line: an optional name followed by workload\n"
+        "                    options, which default to the ones on the command line; '#' starts a comment\n"
+        "  --windowed        Renders to a window instead of offscreen images\n"
+        "  --output=<file>   JSON report (default: time_kill_bench.json)\n"
+        "  --capture=<file>  Saves the last frame of every scenario (.png, .ppm, anything else raw)\n"
+        "  --root=<dir>      Directory containing assets/ (default: current directory)\n"
+        "  --label=<text>    Stored in the report, e.g. a commit hash\n"
+        "  --validation      Enables the validation layers (distorts the timings)\n";
+
+    //! Different pipeline states the workload cycles through: depth compare op x blending x depth
+    //! writes x front face. All of them draw the same triangles.
+    constexpr usize MaxPipelines = 32;
+
+    struct Scenario {
+        String name = "default";
+        usize triangles = 100000;
+        usize draws = 1000;
+        usize pipelines = 1;
+        uint32_t width = 1280;
+        uint32_t height = 720;
+        usize frames = 1000;
+        usize warmup = 100;
+        bool parallel = false;
+    };
+
+    struct Options {
+        Scenario defaults;
+        String script;
+        bool windowed = false;
+        String output = "time_kill_bench.json";
+        String capture;
+        String root;
+        String label;
+        bool validation = false;
+    };
+
+    //! Applies a workload option to `scenario`; returns false if `arg` is not one.
+    bool applyScenarioOption(const String& arg, Scenario& scenario) {
+        const auto number = [&](const StringView prefix) -> Optional<usize> {
+            if (!arg.starts_with(prefix)) {
+                return std::nullopt;
+            }
+            try {
+                return static_cast<usize>(std::stoull(arg.substr(prefix.size())));
+            } catch (const std::exception&) {
+                return std::nullopt;
+            }
+        };
+
+        if (const auto value = number("--triangles=")) {
+            scenario.triangles = std::max<usize>(*value, 1);
+        } else if (const auto value = number("--draws=")) {
+            scenario.draws = std::max<usize>(*value, 1);
+        } else if (const auto value = number("--pipelines=")) {
+            scenario.pipelines = std::clamp<usize>(*value, 1, MaxPipelines);
+        } else if (const auto value = number("--width=")) {
+            scenario.width = static_cast<uint32_t>(std::max<usize>(*value, 1));
+        } else if (const auto value = number("--height=")) {
+            scenario.height = static_cast<uint32_t>(std::max<usize>(*value, 1));
+        } else if (const auto value = number("--frames=")) {
+            scenario.frames = std::max<usize>(*value, 1);
+        } else if (const auto value = number("--warmup=")) {
+            scenario.warmup = *value;
+        } else if (arg == "--parallel") {
+            scenario.parallel = true;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    Optional<Options> parseOptions(const int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const String arg = argv[i];
+            const auto text = [&](const StringView prefix) -> Optional<String> {
+                if (!arg.starts_with(prefix) || arg.size() == prefix.size()) {
+                    return std::nullopt;
+                }
+                return arg.substr(prefix.size());
+            };
+
+            if (applyScenarioOption(arg, options.defaults)) {
+                continue;
+            }
+            if (const auto value = text("--script=")) {
+                options.script = *value;
+            } else if (const auto value = text("--output=")) {
+                options.output = *value;
+            } else if (const auto value = text("--capture=")) {
+                options.capture = *value;
+            } else if (const auto value = text("--root=")) {
+                options.root = *value;
+            } else if (const auto value = text("--label=")) {
+                options.label = *value;
+            } else if (arg == "--windowed") {
+                options.windowed = true;
+            } else if (arg == "--validation") {
+                options.validation = true;
+            } else {
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    //! Reads one scenario per non-empty line of `path`, starting from `defaults`.
+    Vector<Scenario> readScript(const String& path, const Scenario& defaults) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open script: " + path);
+        }
+
+        Vector<Scenario> scenarios;
+        String line;
+        for (usize lineNumber = 1; std::getline(file, line); ++lineNumber) {
+            if (const auto comment = line.find('#'); comment != String::npos) {
+                line.erase(comment);
+            }
+
+            std::istringstream tokens(line);
+            Scenario scenario = defaults;
+            scenario.name = "scenario" + std::to_string(scenarios.size() + 1);
+            bool empty = true;
+            for (String token; tokens >> token; empty = false) {
+                if (empty && !token.starts_with("--")) {
+                    scenario.name = token;
+                } else if (!applyScenarioOption(token, scenario)) {
+                    throw std::runtime_error(std::format("{}:{}: unknown option '{}'", path, lineNumber, token));
+                }
+            }
+            if (!empty) {
+                scenarios.push_back(scenario);
+            }
+        }
+        if (scenarios.empty()) {
+            throw std::runtime_error("Script contains no scenarios: " + path);
+        }
+        return scenarios;
+    }
+
+    //! Same sequence on every run and machine
+    struct Random {
+        u64 state = 0x9e3779b97f4a7c15ull;
+
+        f32 next() {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return static_cast<f32>(state >> 40) / static_cast<f32>(1ull << 24);
+        }
+    };
+
+    //! Matches the inputs of basic.vert: vec2 position, vec3 color, tightly interleaved.
+    struct Vertex {
+        f32 x, y;
+        f32 r, g, b;
+    };
+
+    Vector<Vertex> createTriangles(const usize count) {
+        constexpr f32 Size = 0.05f;
+        Random random;
+        Vector<Vertex> vertices;
+        vertices.reserve(count * 3);
+        for (usize i = 0; i < count; ++i) {
+            const f32 cx = random.next() * 2.0f - 1.0f;
+            const f32 cy = random.next() * 2.0f - 1.0f;
+            const f32 r = random.next(), g = random.next(), b = random.next();
+            vertices.push_back({ cx, cy - Size, r, g, b });
+            vertices.push_back({ cx + Size, cy + Size, r, g, b });
+            vertices.push_back({ cx - Size, cy + Size, r, g, b });
+        }
+        return vertices;
+    }
+
+    //! A buffer with its memory, freed on destruction.
+    struct Buffer {
+        VkDevice device = VK_NULL_HANDLE;
+        VulkanMemoryAllocator* allocator = nullptr;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        MemoryAllocation allocation;
+
+        Buffer(VkDevice device, VulkanMemoryAllocator& allocator, const VkDeviceSize size,
+               const VkBufferUsageFlags usage, const MemoryUsage memoryUsage)
+            : device(device), allocator(&allocator) {
+            VkBufferCreateInfo bufferInfo = {};
+            bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+            bufferInfo.size = size;
+            bufferInfo.usage = usage;
+            bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create buffer!");
+            }
+            try {
+                allocation = allocator.allocateForBuffer(buffer, memoryUsage);
+            } catch (const std::exception&) {
+                vkDestroyBuffer(device, buffer, nullptr);
+                throw;
+            }
+        }
+
+        ~Buffer() {
+            vkDestroyBuffer(device, buffer, nullptr);
+            allocator->free(allocation);
+        }
+
+        Buffer(const Buffer&) = delete;
+        Buffer& operator=(const Buffer&) = delete;
+    };
+
+    struct Statistics {
+        f64 mean = 0.0;
+        f64 min = 0.0;
+        f64 p50 = 0.0;
+        f64 p95 = 0.0;
+        f64 p99 = 0.0;
+        f64 max = 0.0;
+        usize count = 0;
+    };
+
+    //! Nearest-rank percentiles.
+    Optional<Statistics> computeStatistics(Vector<f64> samples) {
+        if (samples.empty()) {
+            return std::nullopt;
+        }
+        std::ranges::sort(samples);
+        const auto percentile = [&](const f64 p) {
+            const auto rank = static_cast<usize>(std::ceil(p / 100.0 * static_cast<f64>(samples.size())));
+            return samples[std::clamp<usize>(rank, 1, samples.size()) - 1];
+        };
+
+        Statistics statistics;
+        for (const f64 sample : samples) {
+            statistics.mean += sample;
+        }
+        statistics.mean /= static_cast<f64>(samples.size());
+        statistics.min = samples.front();
+        statistics.p50 = percentile(50.0);
+        statistics.p95 = percentile(95.0);
+        statistics.p99 = percentile(99.0);
+        statistics.max = samples.back();
+        statistics.count = samples.size();
+        return statistics;
+    }
+
+    struct ScenarioResult {
+        Scenario scenario;
+        String device;
+        VkExtent2D extent = {};
+        uint32_t framesInFlight = 0;
+        f32 timestampPeriod = 0.0f;
+        usize measuredFrames = 0;           // Less than scenario.frames only if the window was closed early
+        usize skippedFrames = 0;            // beginFrame had nothing to render to (minimized window)
+        Optional<Statistics> cpuFrame;      // Whole loop iteration, including waits for the GPU
+        Optional<Statistics> cpuRecord;     // beginFrame returned -> endFrame returned
+        Optional<Statistics> gpuFrame;      // GpuProfiler frame time: the whole command buffer
+        Optional<Statistics> gpuDraws;      // GpuProfiler scope around the render pass
+        Optional<GpuPipelineStatistics> pipelineStatistics; // Of the render pass in the last measured frame
+    };
+
+    String capturePath(const String& path, const Scenario& scenario, const bool addName) {
+        if (!addName) {
+            return path;
+        }
+        std::filesystem::path file(path);
+        const auto extension = file.extension();
+        file.replace_extension();
+        file += "_" + scenario.name;
+        file += extension;
+        return file.string();
+    }
+
+    ImageFileFormat captureFormat(const String& path) {
+        const auto extension = std::filesystem::path(path).extension();
+        if (extension == ".png") {
+            return ImageFileFormat::Png;
+        }
+        if (extension == ".ppm") {
+            return ImageFileFormat::Ppm;
+        }
+        return ImageFileFormat::Raw;
+    }
+
+    ScenarioResult runScenario(const Options& options, const Scenario& scenario, const String& capture) {
+        VulkanConfiguration config;
+        config.debugEnabled = options.validation;
+        config.enableValidationLayers = options.validation;
+        config.setRootDirectory(options.root);
+        config.latencyPolicy = LatencyPolicy::uncapped();
+        config.headless.width = scenario.width;
+        config.headless.height = scenario.height;
+
+        // Results must not depend on what earlier runs left on disk
+        config.pipelineCachePath.clear();
+        config.reflectionCachePath.clear();
+
+        UniquePtr<core::Window> window;
+        UniquePtr<VulkanContext> context;
+        if (options.windowed) {
+            window = createUniquePtr<core::Window>(static_cast<int>(scenario.width), static_cast<int>(scenario.height),
+                                                   "time_kill_bench - " + scenario.name, false);
+            context = createUniquePtr<VulkanContext>(*window, config);
+            window->setVisible(true);
+        } else {
+            context = createUniquePtr<VulkanContext>(config);
+        }
+
+        const auto& res = context->getResources();
+        auto& renderer = context->getRenderer();
+        auto& allocator = context->getMemoryAllocator();
+
+        // Pipelines differ in state only, so every variant is a separate VkPipeline doing the same work
+        constexpr VkCompareOp CompareOps[] = {
+            VK_COMPARE_OP_LESS, VK_COMPARE_OP_LESS_OR_EQUAL, VK_COMPARE_OP_ALWAYS, VK_COMPARE_OP_NOT_EQUAL
+        };
+        const std::filesystem::path shaderDirectory = std::filesystem::path(options.root) / "assets" / "shaders";
+        Vector<VkPipeline> pipelines;
+        {
+            Vector<PipelineHandle> handles;
+            for (usize i = 0; i < scenario.pipelines; ++i) {
+                PipelineDescription description;
+                description.name = std::format("bench{}", i);
+                description.shaderFiles = { (shaderDirectory / "basic.vert.spv").string(),
+                                            (shaderDirectory / "basic.frag.spv").string() };
+                description.cullMode = VK_CULL_MODE_NONE;
+                description.depthCompareOp = CompareOps[i % 4];
+                description.blendEnable = (i / 4) % 2 == 1;
+                description.depthWriteEnable = (i / 8) % 2 == 0;
+                description.frontFace = (i / 16) % 2 == 0 ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+                description.useSwapchainTarget(res);
+                handles.push_back(context->getPipelineRegistry().request(description));
+            }
+            for (const auto& handle : handles) {
+                pipelines.push_back(handle.wait());
+            }
+        }
+
+        // Geometry lives in device-local memory; the upload is recorded into the first frame
+        const auto vertices = createTriangles(scenario.triangles);
+        const VkDeviceSize vertexBytes = vertices.size() * sizeof(Vertex);
+        Buffer staging(res.logicalDevice, allocator, vertexBytes, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryUsage::Upload);
+        std::memcpy(staging.allocation.mappedData, vertices.data(), vertexBytes);
+        Buffer vertexBuffer(res.logicalDevice, allocator, vertexBytes,
+                            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, MemoryUsage::GpuOnly);
+
+        // Draw d covers triangles [d * T / D, (d + 1) * T / D); draws are grouped by pipeline
+        const usize drawCount = std::min(scenario.draws, scenario.triangles);
+        const auto recordDraws = [&](const VkCommandBuffer commandBuffer, const usize begin, const usize end) {
+            constexpr VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.buffer, &offset);
+            usize bound = pipelines.size();
+            for (usize draw = begin; draw < end; ++draw) {
+                const usize pipeline = draw * pipelines.size() / drawCount;
+                if (pipeline != bound) {
+                    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[pipeline]);
+                    bound = pipeline;
+                }
+                const usize first = draw * scenario.triangles / drawCount;
+                const usize last = (draw + 1) * scenario.triangles / drawCount;
+                vkCmdDraw(commandBuffer, static_cast<uint32_t>((last - first) * 3), 1, static_cast<uint32_t>(first * 3), 0);
+            }
+        };
+
+        auto& readback = context->getFrameReadback();
+        if (!capture.empty()) {
+            readback.createReadback(renderer.getFramesInFlight() + 1);
+        }
+
+        ScenarioResult result;
+        result.scenario = scenario;
+        result.device = VulkanTools::getDeviceName(res.physicalDevice);
+        result.extent = res.swapchainExtent;
+        result.framesInFlight = renderer.getFramesInFlight();
+        result.timestampPeriod = res.timestampPeriod;
+
+        Vector<f64> cpuFrame, cpuRecord, gpuFrame, gpuDraws;
+        cpuFrame.reserve(scenario.frames);
+        cpuRecord.reserve(scenario.frames);
+        gpuFrame.reserve(scenario.frames);
+        gpuDraws.reserve(scenario.frames);
+
+        // GPU results arrive framesInFlight frames late; warmup frames are told apart by frame number
+        Optional<u64> firstMeasuredFrame;
+        auto& profiler = context->getGpuProfiler();
+        profiler.createProfiler(renderer.getFramesInFlight(), 4);
+        profiler.setProfileCallback([&](const GpuFrameProfile& profile) {
+            if (!firstMeasuredFrame || profile.frameNumber < *firstMeasuredFrame) {
+                return;
+            }
+            gpuFrame.push_back(profile.frameMilliseconds);
+            if (!profile.scopes.empty()) {
+                gpuDraws.push_back(profile.scopes.front().milliseconds);
+                result.pipelineStatistics = profile.scopes.front().statistics;
+            }
+        });
+
+        constexpr VkClearColorValue clearColor = {{ 0.05f, 0.05f, 0.1f, 1.0f }};
+        const usize totalFrames = scenario.warmup + scenario.frames;
+        bool uploaded = false;
+        // Skipped frames don't count, so the requested number of frames is measured
+        for (usize rendered = 0; rendered < totalFrames;) {
+            if (window) {
+                if (window->shouldClose()) {
+                    break;
+                }
+                glfwPollEvents();
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            const auto frame = renderer.beginFrame();
+            if (!frame) {
+                ++result.skippedFrames;
+                if (window) {
+                    glfwWaitEvents(); // Until the window is restored
+                }
+                continue;
+            }
+            const auto recordStart = std::chrono::steady_clock::now();
+            const bool measured = rendered >= scenario.warmup;
+            if (measured && !firstMeasuredFrame) {
+                firstMeasuredFrame = frame->frameNumber;
+            }
+            profiler.beginFrame(*frame);
+
+            const VkCommandBuffer commandBuffer = frame->commandBuffer;
+            if (!uploaded) {
+                VkBufferCopy region = {};
+                region.size = vertexBytes;
+                vkCmdCopyBuffer(commandBuffer, staging.buffer, vertexBuffer.buffer, 1, &region);
+
+                VkBufferMemoryBarrier barrier = {};
+                barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.buffer = vertexBuffer.buffer;
+                barrier.offset = 0;
+                barrier.size = VK_WHOLE_SIZE;
+                vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+                                     0, 0, nullptr, 1, &barrier, 0, nullptr);
+                uploaded = true;
+            }
+
+            {
+                // Secondary command buffers don't inherit pipeline statistics queries
+                GpuProfiler::Scope scope(profiler, commandBuffer, "draws", !scenario.parallel);
+                if (scenario.parallel) {
+                    renderer.beginRenderPass(*frame, clearColor, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    renderer.recordParallel(*frame, drawCount, recordDraws);
+                } else {
+                    renderer.beginRenderPass(*frame, clearColor);
+                    recordDraws(commandBuffer, 0, drawCount);
+                }
+                renderer.endRenderPass(*frame);
+            }
+
+            if (!capture.empty() && rendered + 1 == totalFrames) {
+                readback.capture(*frame);
+            }
+            profiler.endFrame(*frame);
+            renderer.endFrame(*frame);
+
+            const auto end = std::chrono::steady_clock::now();
+            if (measured) {
+                cpuFrame.push_back(std::chrono::duration<f64, std::milli>(end - start).count());
+                cpuRecord.push_back(std::chrono::duration<f64, std::milli>(end - recordStart).count());
+            }
+            ++rendered;
+        }
+
+        // Frames still in flight
+        context->queuesWaitIdle(true);
+        profiler.resolvePending();
+        profiler.setProfileCallback({});
+
+        if (!capture.empty()) {
+            if (const auto image = readback.poll(renderer.getFrameNumber())) {
+                VulkanFrameReadback::saveImage(*image, capture, captureFormat(capture));
+                readback.release(*image);
+            }
+        }
+
+        result.measuredFrames = cpuFrame.size();
+        result.cpuFrame = computeStatistics(std::move(cpuFrame));
+        result.cpuRecord = computeStatistics(std::move(cpuRecord));
+        result.gpuFrame = computeStatistics(std::move(gpuFrame));
+        result.gpuDraws = computeStatistics(std::move(gpuDraws));
+        return result;
+    }
+
+    String jsonString(const StringView text) {
+        String escaped = "\"";
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+                escaped += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                escaped += std::format("\\u{:04x}", static_cast<int>(c));
+            } else {
+                escaped += c;
+            }
+        }
+        return escaped + "\"";
+    }
+
+    String jsonStatistics(const Optional<Statistics>& statistics) {
+        if (!statistics) {
+            return "null";
+        }
+        return std::format(R"({{ "mean": {:.4f}, "min": {:.4f}, "p50": {:.4f}, "p95": {:.4f}, "p99": {:.4f}, "max": {:.4f}, "samples": {} }})",
+                           statistics->mean, statistics->min, statistics->p50, statistics->p95, statistics->p99,
+                           statistics->max, statistics->count);
+    }
+
+    String jsonPipelineStatistics(const Optional<GpuPipelineStatistics>& statistics) {
+        if (!statistics) {
+            return "null";
+        }
+        return std::format(R"({{ "inputAssemblyPrimitives": {}, "vertexShaderInvocations": {}, "clippingInvocations": {}, "clippingPrimitives": {}, "fragmentShaderInvocations": {} }})",
+                           statistics->inputAssemblyPrimitives, statistics->vertexShaderInvocations,
+                           statistics->clippingInvocations, statistics->clippingPrimitives,
+                           statistics->fragmentShaderInvocations);
+    }
+
+    void writeReport(const String& path, const Options& options, const Vector<ScenarioResult>& results) {
+        std::ofstream file(path, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open report file: " + path);
+        }
+
+        file << "{\n";
+        file << "  \"label\": " << jsonString(options.label) << ",\n";
+        file << "  \"mode\": " << jsonString(options.windowed ? "windowed" : "headless") << ",\n";
+        file << "  \"scenarios\": [\n";
+        for (usize i = 0; i < results.size(); ++i) {
+            const auto& result = results[i];
+            const auto& scenario = result.scenario;
+            file << "    {\n";
+            file << "      \"name\": " << jsonString(scenario.name) << ",\n";
+            file << "      \"device\": " << jsonString(result.device) << ",\n";
+            file << std::format("      \"triangles\": {},\n", scenario.triangles);
+            file << std::format("      \"draws\": {},\n", std::min(scenario.draws, scenario.triangles));
+            file << std::format("      \"pipelines\": {},\n", scenario.pipelines);
+            file << std::format("      \"width\": {},\n", result.extent.width);
+            file << std::format("      \"height\": {},\n", result.extent.height);
+            file << std::format("      \"parallel\": {},\n", scenario.parallel);
+            file << std::format("      \"frames\": {},\n", result.measuredFrames);
+            file << std::format("      \"requestedFrames\": {},\n", scenario.frames);
+            file << std::format("      \"warmup\": {},\n", scenario.warmup);
+            file << std::format("      \"framesInFlight\": {},\n", result.framesInFlight);
+            file << std::format("      \"skippedFrames\": {},\n", result.skippedFrames);
+            file << std::format("      \"timestampPeriod\": {},\n", result.timestampPeriod);
+            file << "      \"cpuFrameMs\": " << jsonStatistics(result.cpuFrame) << ",\n";
+            file << "      \"cpuRecordMs\": " << jsonStatistics(result.cpuRecord) << ",\n";
+            file << "      \"gpuFrameMs\": " << jsonStatistics(result.gpuFrame) << ",\n";
+            file << "      \"gpuDrawsMs\": " << jsonStatistics(result.gpuDraws) << ",\n";
+            file << "      \"pipelineStatistics\": " << jsonPipelineStatistics(result.pipelineStatistics) << "\n";
+            file << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        file << "  ]\n";
+        file << "}\n";
+
+        if (!file) {
+            throw std::runtime_error("Failed to write report file: " + path);
+        }
+    }
+
+    void printHeader() {
+        std::printf("  %-20s %10s %8s %5s %11s %28s %28s\n", "scenario", "triangles", "draws", "psos", "resolution",
+                    "cpu frame p50/p95/p99 [ms]", "gpu p50/p95/p99 [ms]");
+    }
+
+    void printResult(const ScenarioResult& result) {
+        const auto& scenario = result.scenario;
+        const auto triple = [](const Optional<Statistics>& statistics) {
+            return statistics ? std::format("{:.3f}/{:.3f}/{:.3f}", statistics->p50, statistics->p95, statistics->p99)
+                              : String("n/a");
+        };
+        const String resolution = std::format("{}x{}", result.extent.width, result.extent.height);
+        std::printf("  %-20.20s %10zu %8zu %5zu %11s %28s %28s\n", scenario.name.c_str(), scenario.triangles,
+                    std::min(scenario.draws, scenario.triangles), scenario.pipelines, resolution.c_str(),
+                    triple(result.cpuFrame).c_str(), triple(result.gpuFrame).c_str());
+    }
+}
+
+int main(const int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        std::cerr << USAGE;
+        return 1;
+    }
+
+    try {
+        const Vector<Scenario> scenarios = options->script.empty() ? Vector<Scenario>{ options->defaults }
+                                                                   : readScript(options->script, options->defaults);
+
+        std::printf("%zu scenario(s), %s\n", scenarios.size(), options->windowed ? "windowed" : "headless");
+        printHeader();
+
+        Vector<ScenarioResult> results;
+        for (const auto& scenario : scenarios) {
+            const String capture = options->capture.empty()
+                ? String() : capturePath(options->capture, scenario, scenarios.size() > 1);
+            results.push_back(runScenario(*options, scenario, capture));
+            printResult(results.back());
+        }
+
+        writeReport(options->output, *options, results);
+        std::printf("\nReport written to %s\n", options->output.c_str());
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -18,11 +18,21 @@ int main() {
         log_enable_trace(true);
         log_set_date_separator(time_kill::core::DateSeparator::Period);
 
+        // Keep the most recent records in memory; they are written to crash_log.txt only if something fails
+        log_enable_crash_log();
+
         // Create a Vulkan configuration with debug messages enabled
         VulkanConfiguration vulkanConfig = {};
         vulkanConfig.debugEnabled = true;
         vulkanConfig.setRootDirectory("../../../");
 
+        // Rebuild pipelines when a shader in assets/shaders is edited
+        vulkanConfig.hotReloadShaders = true;
+
+        // Sample input as late as possible and don't render faster than needed
+        vulkanConfig.latencyPolicy = LatencyPolicy::lowestLatency();
+        vulkanConfig.latencyPolicy.targetFrameRate = 144.0;
+
         // Create a window instance with vulkan context
         Window window(800, 600, WINDOW_TITLE, true);
         VulkanContext vulkanContext(window, vulkanConfig);
@@ -34,10 +44,19 @@ int main() {
         window.setVisible(true);
         
         // Main loop
+        auto& renderer = vulkanContext.getRenderer();
+        constexpr VkClearColorValue clearColor = {{ 0.05f, 0.05f, 0.1f, 1.0f }};
+
         int windowPosition[2] = {0, 0};
         int windowDimension[2] = {0, 0};
         while (!window.shouldClose()) {
+            // Wait for the previous frame to be shown and for the pacer before sampling input
+            renderer.waitForNextFrame();
             glfwPollEvents();
+            vulkanContext.processShaderReloads();
+
+            // Acquire -> record -> submit -> present; only blocks if all frames in flight are busy
+            renderer.drawFrame(clearColor);
             
             // Test window methods
             if (window.isVisible()) {
@@ -60,9 +79,11 @@ int main() {
                 }
             }
         }
+        vulkanContext.queuesWaitIdle(true);
         return EXIT_SUCCESS;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        time_kill::log_dump_crash_log(e.what());
         return EXIT_FAILURE;
     }
 } 
\ No newline at end of file
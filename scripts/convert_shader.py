@@ -1,7 +1,10 @@
 import os
+import shutil
 import subprocess
 import sys
 
+PACKER = "time_kill_shaderpack"
+
 def compile_glsl_to_spirv(directory):
     for root, _, files in os.walk(directory):
         for file in files:
@@ -17,13 +20,44 @@ def compile_glsl_to_spirv(directory):
                 except subprocess.CalledProcessError as e:
                     print(f"Failed to compile {input_path}: {e}")
 
+def pack_shader_bundle(directory, bundle_path, packer):
+    if shutil.which(packer) is None and not os.path.isfile(packer):
+        print(f"Shader packer '{packer}' not found; build the time_kill_shaderpack target first.")
+        return False
+
+    print(f"Packing {directory} -> {bundle_path}")
+    try:
+        subprocess.run([packer, directory, bundle_path], check=True)
+        return True
+    except subprocess.CalledProcessError as e:
+        print(f"Failed to pack {bundle_path}: {e}")
+        return False
+
 if __name__ == "__main__":
-    if len(sys.argv) != 2:
-        print("Usage: python script.py <directory>")
+    usage = "Usage: python script.py <directory> [--bundle <output>] [--packer <path to time_kill_shaderpack>]"
+    args = sys.argv[1:]
+    bundle_path = None
+    packer = PACKER
+
+    positional = []
+    while args:
+        arg = args.pop(0)
+        if arg in ("--bundle", "--packer") and args:
+            if arg == "--bundle":
+                bundle_path = args.pop(0)
+            else:
+                packer = args.pop(0)
+        else:
+            positional.append(arg)
+
+    if len(positional) != 1:
+        print(usage)
         sys.exit(1)
 
-    directory = sys.argv[1]
+    directory = positional[0]
     if os.path.isdir(directory):
         compile_glsl_to_spirv(directory)
+        if bundle_path is not None and not pack_shader_bundle(directory, bundle_path, packer):
+            sys.exit(1)
     else:
         print("Invalid directory path.")
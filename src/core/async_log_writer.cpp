@@ -0,0 +1,266 @@
+#include "async_log_writer.hpp"
+#include <algorithm>
+
+namespace time_kill::core {
+    namespace {
+        std::atomic<u64> NextWriterId = 1;
+
+        // Per-thread handle to the ring the thread produces into. The ring is shared with the writer,
+        // so it outlives the thread until the writer has drained it.
+        struct LocalRingSlot {
+            u64 writerId = 0;
+            SharedPtr<void> ring;
+            std::atomic<bool>* closed = nullptr;
+
+            ~LocalRingSlot() {
+                if (closed != nullptr) {
+                    closed->store(true, std::memory_order_release);
+                }
+            }
+        };
+
+        thread_local LocalRingSlot LocalRing;
+    }
+
+    AsyncLogWriter::AsyncLogWriter(const AsyncLogConfig& config, BatchHandler onBatch, FlushHandler onFlush)
+        : config_(config),
+          writerId_(NextWriterId.fetch_add(1, std::memory_order_relaxed)),
+          onBatch_(std::move(onBatch)),
+          onFlush_(std::move(onFlush)) {
+        batch_.reserve(config_.maxBatchSize + 1);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    AsyncLogWriter::~AsyncLogWriter() {
+        stopRequested_.store(true, std::memory_order_release);
+        wakeWriter();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    bool AsyncLogWriter::enqueue(const LogLevel level, const StringView message,
+                                 const std::chrono::system_clock::time_point time) {
+        ProducerRing& producer = localRing();
+
+        LogRecord* record = producer.ring.beginWrite();
+        if (record == nullptr) {
+            if (config_.overflowPolicy == LogOverflowPolicy::Drop) {
+                producer.dropped.store(producer.dropped.load(std::memory_order_relaxed) + 1,
+                                       std::memory_order_relaxed);
+                return false;
+            }
+
+            // Backpressure: keep the writer awake until it has made room for us
+            while ((record = producer.ring.beginWrite()) == nullptr) {
+                wakeWriter();
+                std::this_thread::yield();
+            }
+        }
+
+        record->time = time;
+        record->level = level;
+        record->threadId = currentThreadId();
+        record->setMessage(message);
+        producer.ring.commitWrite();
+        producer.enqueued.store(producer.enqueued.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        // Only wake the writer early when the ring fills up or something important was logged;
+        // otherwise it picks the records up on its next idle tick without costing us a syscall.
+        if (producer.ring.size() == producer.ring.capacity() / 2 || level >= config_.flushLevel) {
+            wakeWriter();
+        }
+        return true;
+    }
+
+    void AsyncLogWriter::flush() {
+        const u64 ticket = flushRequested_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        wakeWriter();
+
+        std::unique_lock lock(flushMutex_);
+        flushCondition_.wait(lock, [&] { return flushCompleted_ >= ticket; });
+    }
+
+    AsyncLogStats AsyncLogWriter::getStats() const {
+        AsyncLogStats stats;
+        {
+            std::lock_guard lock(ringsMutex_);
+            stats.enqueued = retiredEnqueued_;
+            stats.dropped = retiredDropped_;
+            for (const auto& producer : rings_) {
+                stats.enqueued += producer->enqueued.load(std::memory_order_relaxed);
+                stats.dropped += producer->dropped.load(std::memory_order_relaxed);
+            }
+            stats.producerThreads = static_cast<u32>(rings_.size());
+        }
+        stats.written = written_.load(std::memory_order_relaxed);
+        stats.batches = batches_.load(std::memory_order_relaxed);
+        stats.flushes = flushes_.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    AsyncLogWriter::ProducerRing& AsyncLogWriter::localRing() {
+        if (LocalRing.writerId == writerId_) {
+            return *static_cast<ProducerRing*>(LocalRing.ring.get());
+        }
+
+        // First record of this thread for this writer: register a new ring
+        auto producer = createSharedPtr<ProducerRing>(config_.ringCapacity);
+        {
+            std::lock_guard lock(ringsMutex_);
+            rings_.push_back(producer);
+            ringsVersion_.fetch_add(1, std::memory_order_release);
+        }
+
+        if (LocalRing.closed != nullptr) {
+            LocalRing.closed->store(true, std::memory_order_release);
+        }
+        LocalRing.writerId = writerId_;
+        LocalRing.closed = &producer->closed;
+        LocalRing.ring = producer;
+        return *producer;
+    }
+
+    void AsyncLogWriter::run() {
+        using namespace std::chrono;
+
+        auto lastFlush = steady_clock::now();
+        bool unflushed = false;
+
+        while (true) {
+            // Read the stop and flush requests before draining, so everything that was enqueued
+            // before the request is guaranteed to be part of this pass.
+            const bool stopping = stopRequested_.load(std::memory_order_acquire);
+            const u64 flushRequest = flushRequested_.load(std::memory_order_acquire);
+            const bool flushPending = flushRequest != flushCompleted_;
+
+            const auto [written, urgent] = drainRings(stopping || flushPending);
+            unflushed = unflushed || written > 0;
+
+            const auto now = steady_clock::now();
+            const bool flushDue = stopping || flushPending || urgent
+                || (config_.flushPolicy == LogFlushPolicy::EveryBatch && written > 0)
+                || (config_.flushPolicy == LogFlushPolicy::Interval && now - lastFlush >= config_.flushInterval);
+
+            if (flushDue && unflushed) {
+                onFlush_();
+                flushes_.fetch_add(1, std::memory_order_relaxed);
+                unflushed = false;
+                lastFlush = now;
+            }
+
+            if (flushPending) {
+                {
+                    std::lock_guard lock(flushMutex_);
+                    flushCompleted_ = flushRequest;
+                }
+                flushCondition_.notify_all();
+            }
+
+            if (stopping) {
+                break;
+            }
+
+            if (written == 0) {
+                std::unique_lock lock(wakeMutex_);
+                wakeCondition_.wait_for(lock, config_.idleWait, [&] {
+                    return stopRequested_.load(std::memory_order_acquire)
+                        || flushRequested_.load(std::memory_order_acquire) != flushCompleted_;
+                });
+            }
+        }
+    }
+
+    AsyncLogWriter::DrainResult AsyncLogWriter::drainRings(const bool drainAll) {
+        refreshRings();
+
+        DrainResult result;
+        bool more = true;
+        while (more) {
+            more = false;
+            for (const auto& producer : activeRings_) {
+                batch_.clear();
+                while (batch_.size() < config_.maxBatchSize) {
+                    const LogRecord* record = producer->ring.front();
+                    if (record == nullptr) {
+                        break;
+                    }
+                    result.urgent = result.urgent || record->level >= config_.flushLevel;
+                    batch_.push_back(*record);
+                    producer->ring.pop();
+                }
+
+                if (batch_.empty()) {
+                    continue;
+                }
+                more = more || batch_.size() == config_.maxBatchSize;
+
+                onBatch_(batch_);
+                result.written += batch_.size();
+                written_.fetch_add(batch_.size(), std::memory_order_relaxed);
+                batches_.fetch_add(1, std::memory_order_relaxed);
+            }
+            more = more && drainAll;
+        }
+
+        reportDroppedRecords();
+        return result;
+    }
+
+    void AsyncLogWriter::refreshRings() {
+        const u64 version = ringsVersion_.load(std::memory_order_acquire);
+        const bool anyClosed = std::ranges::any_of(activeRings_, [](const auto& producer) {
+            return producer->closed.load(std::memory_order_acquire) && producer->ring.size() == 0;
+        });
+
+        if (version == activeRingsVersion_ && !anyClosed) {
+            return;
+        }
+
+        std::lock_guard lock(ringsMutex_);
+
+        // Forget rings whose thread has exited and which have been fully drained
+        std::erase_if(rings_, [this](const SharedPtr<ProducerRing>& producer) {
+            if (!producer->closed.load(std::memory_order_acquire) || producer->ring.size() != 0) {
+                return false;
+            }
+            retiredEnqueued_ += producer->enqueued.load(std::memory_order_relaxed);
+            retiredDropped_ += producer->dropped.load(std::memory_order_relaxed);
+            return true;
+        });
+
+        activeRings_ = rings_;
+        activeRingsVersion_ = ringsVersion_.load(std::memory_order_acquire);
+    }
+
+    void AsyncLogWriter::reportDroppedRecords() {
+        u64 dropped = 0;
+        {
+            std::lock_guard lock(ringsMutex_);
+            dropped = retiredDropped_;
+            for (const auto& producer : rings_) {
+                dropped += producer->dropped.load(std::memory_order_relaxed);
+            }
+        }
+
+        if (dropped == reportedDropped_) {
+            return;
+        }
+
+        LogRecord notice;
+        notice.time = std::chrono::system_clock::now();
+        notice.level = LogLevel::WARN;
+        notice.threadId = currentThreadId();
+        notice.setMessage("Async logger dropped " + std::to_string(dropped - reportedDropped_)
+                          + " records (ring buffer full)");
+        reportedDropped_ = dropped;
+
+        batch_.clear();
+        batch_.push_back(notice);
+        onBatch_(batch_);
+    }
+
+    void AsyncLogWriter::wakeWriter() {
+        wakeCondition_.notify_one();
+    }
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "log_record.hpp"
+#include "spsc_ring_buffer.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+
+namespace time_kill::core {
+    //! What a logging thread does when its ring buffer is full.
+    enum class LogOverflowPolicy {
+        Drop,   // Discard the new record and count it as dropped
+        Block   // Wait until the writer thread has freed a slot
+    };
+
+    //! When the writer thread flushes its outputs.
+    enum class LogFlushPolicy {
+        EveryBatch, // Flush after every batch that wrote at least one record
+        Interval    // Flush at most once per flushInterval (and on flushLevel records)
+    };
+
+    struct AsyncLogConfig {
+        usize ringCapacity = 1024;                          // Records per logging thread
+        usize maxBatchSize = 256;                           // Records taken from one ring per pass
+        LogOverflowPolicy overflowPolicy = LogOverflowPolicy::Drop;
+        LogFlushPolicy flushPolicy = LogFlushPolicy::Interval;
+        std::chrono::milliseconds flushInterval{200};
+        std::chrono::milliseconds idleWait{2};              // Sleep of the writer thread when all rings are empty
+        LogLevel flushLevel = LogLevel::ERROR;              // Records at or above this level force a flush
+    };
+
+    struct AsyncLogStats {
+        u64 enqueued = 0;
+        u64 written = 0;
+        u64 dropped = 0;
+        u64 batches = 0;
+        u64 flushes = 0;
+        u32 producerThreads = 0;
+    };
+
+    //! Background writer for the logger. Every logging thread owns a lock-free single-producer ring of
+    //! fixed-size records; one writer thread drains all rings and hands the records over in batches.
+    class AsyncLogWriter {
+    public:
+        using BatchHandler = std::function<void(std::span<const LogRecord> records)>;
+        using FlushHandler = std::function<void()>;
+
+        AsyncLogWriter(const AsyncLogConfig& config, BatchHandler onBatch, FlushHandler onFlush);
+
+        //! Drains all pending records, flushes and joins the writer thread.
+        ~AsyncLogWriter();
+
+        AsyncLogWriter(const AsyncLogWriter&) = delete;
+        AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+        //! Queues a record for the calling thread. Returns false if the record was dropped.
+        bool enqueue(LogLevel level, StringView message, std::chrono::system_clock::time_point time);
+
+        //! Blocks until every record enqueued before the call has been written and flushed.
+        void flush();
+
+        [[nodiscard]] AsyncLogStats getStats() const;
+        [[nodiscard]] const AsyncLogConfig& getConfig() const { return config_; }
+
+    private:
+        struct ProducerRing {
+            explicit ProducerRing(const usize capacity) : ring(capacity) {}
+
+            SpscRingBuffer<LogRecord> ring;
+            std::atomic<u64> enqueued = 0;    // Written by the producer only
+            std::atomic<u64> dropped = 0;     // Written by the producer only
+            std::atomic<bool> closed = false; // Set when the producing thread exits
+        };
+
+        struct DrainResult {
+            usize written = 0;
+            bool urgent = false;
+        };
+
+        ProducerRing& localRing();
+        void run();
+        DrainResult drainRings(bool drainAll);
+        void refreshRings();
+        void reportDroppedRecords();
+        void wakeWriter();
+
+        const AsyncLogConfig config_;
+        const u64 writerId_;
+        BatchHandler onBatch_;
+        FlushHandler onFlush_;
+
+        // Producer registry (touched once per thread)
+        mutable std::mutex ringsMutex_;
+        Vector<SharedPtr<ProducerRing>> rings_;
+        std::atomic<u64> ringsVersion_ = 0;
+        u64 retiredEnqueued_ = 0;
+        u64 retiredDropped_ = 0;
+
+        // Writer thread state
+        Vector<SharedPtr<ProducerRing>> activeRings_;
+        u64 activeRingsVersion_ = 0;
+        Vector<LogRecord> batch_;
+        u64 reportedDropped_ = 0;
+        std::atomic<u64> written_ = 0;
+        std::atomic<u64> batches_ = 0;
+        std::atomic<u64> flushes_ = 0;
+
+        // Wake-up and flush handshake
+        std::mutex wakeMutex_;
+        std::condition_variable wakeCondition_;
+        std::atomic<bool> stopRequested_ = false;
+        std::atomic<u64> flushRequested_ = 0;
+        std::mutex flushMutex_;
+        std::condition_variable flushCondition_;
+        u64 flushCompleted_ = 0;
+
+        std::thread thread_;
+    };
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include "log_record.hpp"
+#include <array>
+#include <concepts>
+#include <cstring>
+#include <format>
+#include <span>
+
+//! On-disk layout of binary log files, shared by BinaryLogSink (writer) and BinaryLogReader (decoder).
+//!
+//! A file starts with a FileHeader followed by a sequence of records. Every record starts with a
+//! RecordHeader and is padded to RecordAlignment bytes. The mapped file is zero-filled beyond the
+//! last record, so a record size of 0 marks the end of the data, even after a crash.
+//!
+//!  FormatString record: u32 id, u32 length, <length> chars
+//!  Message record:      i64 steady clock nanoseconds, u32 thread id, u32 format id, <argCount> packed args
+//!  Packed argument:     u8 BinaryArgType followed by its payload (strings: u32 length + chars)
+namespace time_kill::core::binlog {
+    constexpr std::array<char, 8> Magic = { 'T', 'K', 'B', 'L', 'O', 'G', '\0', '\1' };
+    constexpr u32 Version = 1;
+    constexpr usize RecordAlignment = 8;
+
+    //! Format id used for plain (non-formatted) messages; its format string is "{}".
+    constexpr u32 PlainMessageFormatId = 0;
+
+    struct FileHeader {
+        std::array<char, 8> magic = Magic;
+        u32 version = Version;
+        u32 headerSize = sizeof(FileHeader);
+        i64 wallClockOriginNs = 0;   // system_clock at file creation
+        i64 steadyOriginNs = 0;      // steady_clock at file creation
+        u64 sequence = 0;            // Increases with every rotation
+    };
+
+    enum class RecordKind : u8 {
+        End = 0,
+        FormatString = 1,
+        Message = 2
+    };
+
+    struct RecordHeader {
+        u32 size = 0;                // Record size including this header and padding
+        RecordKind kind = RecordKind::End;
+        u8 level = 0;
+        u8 argCount = 0;
+        u8 reserved = 0;
+    };
+
+    struct MessageHeader {
+        i64 steadyNs = 0;
+        u32 threadId = 0;
+        u32 formatId = 0;
+    };
+
+    struct FormatStringHeader {
+        u32 id = 0;
+        u32 length = 0;
+    };
+
+    static_assert(sizeof(FileHeader) == 40);
+    static_assert(sizeof(RecordHeader) == 8);
+    static_assert(sizeof(MessageHeader) == 16);
+
+    enum class BinaryArgType : u8 {
+        Bool = 1,
+        Char = 2,
+        Int64 = 3,
+        UInt64 = 4,
+        Float64 = 5,
+        String = 6,
+        Pointer = 7
+    };
+
+    constexpr usize alignRecordSize(const usize size) {
+        return (size + RecordAlignment - 1) & ~(RecordAlignment - 1);
+    }
+
+    //! Packs log arguments into the compact binary form stored in message records. Values that have no
+    //! native encoding are formatted to a string up front.
+    class BinaryLogArgs {
+    public:
+        void clear() {
+            bytes_.clear();
+            count_ = 0;
+        }
+
+        template<typename T>
+        void pack(const T& value) {
+            using V = std::remove_cvref_t<T>;
+            ++count_;
+
+            if constexpr (std::same_as<V, bool>) {
+                appendTagged(BinaryArgType::Bool, static_cast<u8>(value ? 1 : 0));
+            } else if constexpr (std::same_as<V, char>) {
+                appendTagged(BinaryArgType::Char, value);
+            } else if constexpr (std::signed_integral<V>) {
+                appendTagged(BinaryArgType::Int64, static_cast<i64>(value));
+            } else if constexpr (std::unsigned_integral<V>) {
+                appendTagged(BinaryArgType::UInt64, static_cast<u64>(value));
+            } else if constexpr (std::floating_point<V>) {
+                appendTagged(BinaryArgType::Float64, static_cast<f64>(value));
+            } else if constexpr (std::convertible_to<const V&, StringView>) {
+                appendString(StringView(value));
+            } else if constexpr (std::is_pointer_v<V> || std::same_as<V, std::nullptr_t>) {
+                appendTagged(BinaryArgType::Pointer, static_cast<u64>(reinterpret_cast<std::uintptr_t>(value)));
+            } else {
+                appendString(std::format("{}", value));
+            }
+        }
+
+        [[nodiscard]] std::span<const std::byte> bytes() const { return bytes_; }
+        [[nodiscard]] u8 count() const { return count_; }
+
+    private:
+        template<typename P>
+        void appendTagged(const BinaryArgType type, const P payload) {
+            append(&type, sizeof(type));
+            append(&payload, sizeof(payload));
+        }
+
+        void appendString(const StringView text) {
+            constexpr auto type = BinaryArgType::String;
+            const auto length = static_cast<u32>(text.size());
+            append(&type, sizeof(type));
+            append(&length, sizeof(length));
+            append(text.data(), text.size());
+        }
+
+        void append(const void* data, const usize size) {
+            const auto* bytes = static_cast<const std::byte*>(data);
+            bytes_.insert(bytes_.end(), bytes, bytes + size);
+        }
+
+        Vector<std::byte> bytes_;
+        u8 count_ = 0;
+    };
+}
@@ -0,0 +1,291 @@
+#include "binary_log_reader.hpp"
+#include <unordered_map>
+#include <variant>
+
+namespace time_kill::core {
+    namespace {
+        using DecodedArg = std::variant<bool, char, i64, u64, f64, String, const void*>;
+
+        // Bounds-checked cursor over the mapped file
+        class ByteReader {
+        public:
+            ByteReader(const std::byte* data, const usize size) : data_(data), size_(size) {}
+
+            template<typename T>
+            bool read(T& value) {
+                if (size_ - offset_ < sizeof(T)) {
+                    return false;
+                }
+                std::memcpy(&value, data_ + offset_, sizeof(T));
+                offset_ += sizeof(T);
+                return true;
+            }
+
+            bool readString(String& value, const usize length) {
+                if (size_ - offset_ < length) {
+                    return false;
+                }
+                value.assign(reinterpret_cast<const char*>(data_ + offset_), length);
+                offset_ += length;
+                return true;
+            }
+
+        private:
+            const std::byte* data_;
+            usize size_;
+            usize offset_ = 0;
+        };
+
+        bool decodeArgs(ByteReader& reader, const u8 count, Vector<DecodedArg>& args) {
+            args.clear();
+            for (u8 i = 0; i < count; ++i) {
+                binlog::BinaryArgType type = {};
+                if (!reader.read(type)) {
+                    return false;
+                }
+
+                bool ok = false;
+                switch (type) {
+                    case binlog::BinaryArgType::Bool: {
+                        u8 value = 0;
+                        ok = reader.read(value);
+                        args.emplace_back(value != 0);
+                        break;
+                    }
+                    case binlog::BinaryArgType::Char: {
+                        char value = 0;
+                        ok = reader.read(value);
+                        args.emplace_back(value);
+                        break;
+                    }
+                    case binlog::BinaryArgType::Int64: {
+                        i64 value = 0;
+                        ok = reader.read(value);
+                        args.emplace_back(value);
+                        break;
+                    }
+                    case binlog::BinaryArgType::UInt64: {
+                        u64 value = 0;
+                        ok = reader.read(value);
+                        args.emplace_back(value);
+                        break;
+                    }
+                    case binlog::BinaryArgType::Float64: {
+                        f64 value = 0;
+                        ok = reader.read(value);
+                        args.emplace_back(value);
+                        break;
+                    }
+                    case binlog::BinaryArgType::String: {
+                        u32 length = 0;
+                        String value;
+                        ok = reader.read(length) && reader.readString(value, length);
+                        args.emplace_back(std::move(value));
+                        break;
+                    }
+                    case binlog::BinaryArgType::Pointer: {
+                        u64 value = 0;
+                        ok = reader.read(value);
+                        args.emplace_back(reinterpret_cast<const void*>(static_cast<std::uintptr_t>(value)));
+                        break;
+                    }
+                    default:
+                        return false;
+                }
+
+                if (!ok) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        String formatArg(const DecodedArg& arg, const StringView spec) {
+            const String format = "{:" + String(spec) + "}";
+            try {
+                return std::visit([&](const auto& value) {
+                    return std::vformat(format, std::make_format_args(value));
+                }, arg);
+            } catch (const std::format_error&) {
+                return "{?" + String(spec) + "}";
+            }
+        }
+
+        //! Index of a replacement field: explicit if given, otherwise the next automatic one.
+        usize parseArgIndex(const StringView indexText, usize& nextArg) {
+            if (indexText.empty()) {
+                return nextArg++;
+            }
+            usize index = 0;
+            for (const char digit : indexText) {
+                index = index * 10 + static_cast<usize>(digit - '0');
+            }
+            return index;
+        }
+
+        //! Replaces the nested fields of a spec (dynamic width and precision, `{:{}.{}}`) with the
+        //! integer values of their arguments; nothing if an argument is missing or not an integer.
+        Optional<String> resolveSpec(const StringView spec, const Vector<DecodedArg>& args, usize& nextArg) {
+            String resolved;
+            for (usize i = 0; i < spec.size(); ++i) {
+                if (spec[i] != '{') {
+                    resolved += spec[i];
+                    continue;
+                }
+                const usize end = spec.find('}', i + 1);
+                if (end == StringView::npos) {
+                    return std::nullopt;
+                }
+                const usize index = parseArgIndex(spec.substr(i + 1, end - i - 1), nextArg);
+                if (index >= args.size()) {
+                    return std::nullopt;
+                }
+                if (const auto* value = std::get_if<i64>(&args[index]); value != nullptr && *value >= 0) {
+                    resolved += std::to_string(*value);
+                } else if (const auto* unsignedValue = std::get_if<u64>(&args[index])) {
+                    resolved += std::to_string(*unsignedValue);
+                } else {
+                    return std::nullopt;
+                }
+                i = end;
+            }
+            return resolved;
+        }
+
+        // Re-applies a std::format string to decoded arguments, one replacement field at a time
+        String formatMessage(const StringView format, const Vector<DecodedArg>& args) {
+            String result;
+            result.reserve(format.size() + args.size() * 8);
+
+            usize nextArg = 0;
+            for (usize i = 0; i < format.size(); ++i) {
+                const char c = format[i];
+                if (c == '}' && i + 1 < format.size() && format[i + 1] == '}') {
+                    result += '}';
+                    ++i;
+                    continue;
+                }
+                if (c != '{') {
+                    result += c;
+                    continue;
+                }
+                if (i + 1 < format.size() && format[i + 1] == '{') {
+                    result += '{';
+                    ++i;
+                    continue;
+                }
+
+                // The field ends at the brace that closes it; a spec may nest fields of its own
+                usize end = i + 1;
+                for (usize depth = 1; end < format.size(); ++end) {
+                    if (format[end] == '{') {
+                        ++depth;
+                    } else if (format[end] == '}' && --depth == 0) {
+                        break;
+                    }
+                }
+                if (end >= format.size()) {
+                    result += format.substr(i);
+                    break;
+                }
+
+                const StringView field = format.substr(i + 1, end - i - 1);
+                const usize colon = field.find(':');
+                const StringView spec = colon == StringView::npos ? StringView{} : field.substr(colon + 1);
+
+                // As in std::format, the value is numbered before the width and precision arguments
+                const usize index = parseArgIndex(field.substr(0, colon), nextArg);
+                const auto resolvedSpec = resolveSpec(spec, args, nextArg);
+                if (index >= args.size() || !resolvedSpec) {
+                    result += "{?" + String(spec) + "}";
+                } else {
+                    result += formatArg(args[index], *resolvedSpec);
+                }
+                i = end;
+            }
+            return result;
+        }
+    }
+
+    BinaryLogReader::BinaryLogReader(const String& path) {
+        file_.openReadOnly(path);
+
+        if (file_.size() < sizeof(binlog::FileHeader)) {
+            throw std::runtime_error("Not a binary log file (too small): " + path);
+        }
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+
+        if (header_.magic != binlog::Magic) {
+            throw std::runtime_error("Not a binary log file (bad magic): " + path);
+        }
+        if (header_.version != binlog::Version) {
+            throw std::runtime_error("Unsupported binary log version " + std::to_string(header_.version) + ": " + path);
+        }
+    }
+
+    void BinaryLogReader::forEach(const std::function<bool(const DecodedLogRecord&)>& visitor) const {
+        using namespace std::chrono;
+
+        std::unordered_map<u32, String> formats;
+        formats.emplace(binlog::PlainMessageFormatId, "{}");
+
+        Vector<DecodedArg> args;
+        DecodedLogRecord decoded;
+
+        usize offset = header_.headerSize;
+        while (offset + sizeof(binlog::RecordHeader) <= file_.size()) {
+            binlog::RecordHeader header;
+            std::memcpy(&header, file_.data() + offset, sizeof(header));
+            if (header.size < sizeof(header) || header.kind == binlog::RecordKind::End
+                || offset + header.size > file_.size()) {
+                break;
+            }
+
+            ByteReader reader(file_.data() + offset + sizeof(header), header.size - sizeof(header));
+            offset += header.size;
+
+            if (header.kind == binlog::RecordKind::FormatString) {
+                binlog::FormatStringHeader formatHeader;
+                String format;
+                if (!reader.read(formatHeader) || !reader.readString(format, formatHeader.length)) {
+                    break;
+                }
+                formats[formatHeader.id] = std::move(format);
+                continue;
+            }
+
+            binlog::MessageHeader message;
+            if (!reader.read(message) || !decodeArgs(reader, header.argCount, args)) {
+                break;
+            }
+
+            const auto format = formats.find(message.formatId);
+            const i64 wallNs = header_.wallClockOriginNs + (message.steadyNs - header_.steadyOriginNs);
+
+            decoded.time = system_clock::time_point(duration_cast<system_clock::duration>(nanoseconds(wallNs)));
+            decoded.level = static_cast<LogLevel>(header.level);
+            decoded.threadId = message.threadId;
+            decoded.message = format != formats.end()
+                ? formatMessage(format->second, args)
+                : "<unknown format id " + std::to_string(message.formatId) + ">";
+
+            if (!visitor(decoded)) {
+                break;
+            }
+        }
+    }
+
+    String BinaryLogReader::formatLine(const DecodedLogRecord& record,
+                                       const DateFormat dateFormat,
+                                       const DateSeparator separator) {
+        LogEntry entry;
+        entry.time = record.time;
+        entry.level = record.level;
+        entry.threadId = record.threadId;
+        entry.message = record.message;
+
+        String line;
+        appendLogLine(line, entry, dateFormat, separator);
+        return line;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "binary_log_format.hpp"
+#include "logger.hpp"
+#include "utils/memory_mapped_file.hpp"
+#include <functional>
+
+namespace time_kill::core {
+    struct DecodedLogRecord {
+        std::chrono::system_clock::time_point time;
+        LogLevel level = LogLevel::INFO;
+        u32 threadId = 0;
+        String message;
+    };
+
+    //! Decodes a file written by BinaryLogSink back into log records.
+    class BinaryLogReader {
+    public:
+        //! Maps the file and validates its header. Throws if the file is not a binary log.
+        explicit BinaryLogReader(const String& path);
+
+        //! Calls `visitor` for every message record in file order; stops early when it returns false.
+        //! A truncated or corrupt tail (e.g. after a crash) ends the iteration without an error.
+        void forEach(const std::function<bool(const DecodedLogRecord&)>& visitor) const;
+
+        //! Formats a record the same way Logger writes text lines.
+        static String formatLine(const DecodedLogRecord& record, DateFormat dateFormat, DateSeparator separator);
+
+        [[nodiscard]] const binlog::FileHeader& getHeader() const { return header_; }
+
+    private:
+        utils::MemoryMappedFile file_;
+        binlog::FileHeader header_;
+    };
+}
@@ -0,0 +1,196 @@
+#include "binary_log_sink.hpp"
+#include <chrono>
+#include <filesystem>
+
+namespace time_kill::core {
+    namespace {
+        i64 nanosecondsSinceEpoch(const auto time) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        template<typename T>
+        std::byte* writeValue(std::byte* out, const T& value) {
+            std::memcpy(out, &value, sizeof(T));
+            return out + sizeof(T);
+        }
+
+        //! Steady clock time of a wall clock time point in the past, so records queued by the async
+        //! logger keep the time they were logged at rather than the time they were written.
+        i64 steadyNanosecondsAt(const std::chrono::system_clock::time_point time) {
+            const auto age = std::chrono::system_clock::now() - time;
+            return nanosecondsSinceEpoch(std::chrono::steady_clock::now())
+                   - std::chrono::duration_cast<std::chrono::nanoseconds>(age).count();
+        }
+    }
+
+    BinaryLogSink::BinaryLogSink(String path, const BinaryLogConfig& config, const LogLevel level)
+        : LogSink(level), path_(std::move(path)), config_(config) {
+        if (config_.maxFileSize < 4096) {
+            throw std::runtime_error("Binary log file size cap is too small: " + std::to_string(config_.maxFileSize));
+        }
+
+        // Id 0 is reserved for plain messages
+        formats_.emplace_back("{}");
+        formatsInFile_.push_back(false);
+
+        // Keep the log of a previous run as <path>.1
+        if (std::filesystem::exists(path_)) {
+            rotate();
+        } else {
+            openFile();
+        }
+    }
+
+    BinaryLogSink::~BinaryLogSink() {
+        std::lock_guard lock(mutex_);
+        file_.close(offset_);
+    }
+
+    void BinaryLogSink::write(const LogEntry& entry) {
+        std::lock_guard lock(mutex_);
+        if (entry.args != nullptr) {
+            writeMessage(entry.level, steadyNanosecondsAt(entry.time), entry.threadId, internFormat(entry.format),
+                         entry.args->count(), entry.args->bytes());
+        } else {
+            writePlainLocked(entry.level, steadyNanosecondsAt(entry.time), entry.threadId, entry.message);
+        }
+    }
+
+    void BinaryLogSink::write(const LogLevel level, const StringView format, const binlog::BinaryLogArgs& args) {
+        std::lock_guard lock(mutex_);
+        writeMessage(level, nanosecondsSinceEpoch(std::chrono::steady_clock::now()), currentThreadId(),
+                     internFormat(format), args.count(), args.bytes());
+    }
+
+    void BinaryLogSink::writePlain(const LogLevel level, const StringView message) {
+        std::lock_guard lock(mutex_);
+        writePlainLocked(level, nanosecondsSinceEpoch(std::chrono::steady_clock::now()), currentThreadId(), message);
+    }
+
+    void BinaryLogSink::writePlainLocked(const LogLevel level, const i64 steadyNs, const u32 threadId,
+                                         const StringView message) {
+        plainArgs_.clear();
+        plainArgs_.pack(message);
+        writeMessage(level, steadyNs, threadId, binlog::PlainMessageFormatId, plainArgs_.count(), plainArgs_.bytes());
+    }
+
+    void BinaryLogSink::flush() {
+        std::lock_guard lock(mutex_);
+        file_.flushAsync();
+    }
+
+    u64 BinaryLogSink::getDroppedRecords() const {
+        std::lock_guard lock(mutex_);
+        return droppedRecords_;
+    }
+
+    void BinaryLogSink::writeMessage(const LogLevel level, const i64 steadyNs, const u32 threadId, const u32 formatId, const u8 argCount,
+                                     const std::span<const std::byte> args) {
+        const usize messageSize = binlog::alignRecordSize(
+            sizeof(binlog::RecordHeader) + sizeof(binlog::MessageHeader) + args.size());
+        const usize formatSize = formatsInFile_[formatId]
+            ? 0
+            : binlog::alignRecordSize(sizeof(binlog::RecordHeader) + sizeof(binlog::FormatStringHeader)
+                                      + formats_[formatId].size());
+
+        if (!ensureCapacity(messageSize + formatSize)) {
+            ++droppedRecords_;
+            return;
+        }
+
+        // Rotation resets which format strings the current file knows about
+        if (!formatsInFile_[formatId]) {
+            emitFormat(formatId);
+        }
+
+        binlog::RecordHeader header;
+        header.size = static_cast<u32>(messageSize);
+        header.kind = binlog::RecordKind::Message;
+        header.level = static_cast<u8>(level);
+        header.argCount = argCount;
+
+        binlog::MessageHeader message;
+        message.steadyNs = steadyNs;
+        message.threadId = threadId;
+        message.formatId = formatId;
+
+        std::byte* out = append(messageSize);
+        out = writeValue(out, header);
+        out = writeValue(out, message);
+        if (!args.empty()) {
+            std::memcpy(out, args.data(), args.size());
+        }
+    }
+
+    u32 BinaryLogSink::internFormat(const StringView format) {
+        if (const auto it = formatIds_.find(format.data()); it != formatIds_.end()) {
+            return it->second;
+        }
+
+        const auto id = static_cast<u32>(formats_.size());
+        formats_.emplace_back(format);
+        formatsInFile_.push_back(false);
+        formatIds_.emplace(format.data(), id);
+        return id;
+    }
+
+    void BinaryLogSink::emitFormat(const u32 formatId) {
+        const String& format = formats_[formatId];
+        const usize size = binlog::alignRecordSize(
+            sizeof(binlog::RecordHeader) + sizeof(binlog::FormatStringHeader) + format.size());
+
+        binlog::RecordHeader header;
+        header.size = static_cast<u32>(size);
+        header.kind = binlog::RecordKind::FormatString;
+
+        binlog::FormatStringHeader formatHeader;
+        formatHeader.id = formatId;
+        formatHeader.length = static_cast<u32>(format.size());
+
+        std::byte* out = append(size);
+        out = writeValue(out, header);
+        out = writeValue(out, formatHeader);
+        std::memcpy(out, format.data(), format.size());
+
+        formatsInFile_[formatId] = true;
+    }
+
+    bool BinaryLogSink::ensureCapacity(const usize size) {
+        if (offset_ + size <= file_.size()) {
+            return true;
+        }
+        if (sizeof(binlog::FileHeader) + size > config_.maxFileSize) {
+            return false; // Would not even fit into an empty file
+        }
+        rotate();
+        return true;
+    }
+
+    std::byte* BinaryLogSink::append(const usize size) {
+        std::byte* out = file_.data() + offset_;
+        offset_ += size;
+        return out;
+    }
+
+    void BinaryLogSink::openFile() {
+        file_.create(path_, config_.maxFileSize);
+
+        binlog::FileHeader header;
+        header.wallClockOriginNs = nanosecondsSinceEpoch(std::chrono::system_clock::now());
+        header.steadyOriginNs = nanosecondsSinceEpoch(std::chrono::steady_clock::now());
+        header.sequence = sequence_++;
+        writeValue(file_.data(), header);
+        offset_ = sizeof(binlog::FileHeader);
+
+        formatsInFile_.assign(formatsInFile_.size(), false);
+    }
+
+    void BinaryLogSink::rotate() {
+        if (file_.isOpen()) {
+            file_.close(offset_);
+        }
+
+        rotateLogFiles(path_, config_.maxFiles);
+        openFile();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "binary_log_format.hpp"
+#include "log_sink.hpp"
+#include "utils/memory_mapped_file.hpp"
+#include <mutex>
+#include <unordered_map>
+
+namespace time_kill::core {
+    struct BinaryLogConfig {
+        usize maxFileSize = 64 * 1024 * 1024; // Size cap of a single file
+        u32 maxFiles = 4;                     // Current file plus rotated ones (<path>.1 ... <path>.<maxFiles - 1>)
+    };
+
+    //! Writes compact binary log records (see binary_log_format.hpp) into a memory-mapped, size-capped
+    //! file. When the file is full it is rotated: <path> becomes <path>.1, <path>.1 becomes <path>.2
+    //! and so on, and the oldest file is removed. Decode the files with time_kill_logdump.
+    class BinaryLogSink final : public LogSink {
+    public:
+        BinaryLogSink(String path, const BinaryLogConfig& config, LogLevel level = LogLevel::TRACE);
+
+        //! Truncates the current file to the data written so far and closes it.
+        ~BinaryLogSink() override;
+
+        //! Writes the packed arguments if the entry has them, otherwise the message text.
+        void write(const LogEntry& entry) override;
+        using LogSink::write;
+
+        //! Writes a formatted message as interned format string plus packed arguments.
+        //! `format` must point to static storage (e.g. the literal of a std::format_string).
+        void write(LogLevel level, StringView format, const binlog::BinaryLogArgs& args);
+
+        //! Writes an already formatted message.
+        void writePlain(LogLevel level, StringView message);
+
+        //! Schedules the written pages to be written back to disk.
+        void flush() override;
+
+        [[nodiscard]] bool usesPackedArgs() const override { return true; }
+
+        [[nodiscard]] u64 getDroppedRecords() const;
+
+    private:
+        void writeMessage(LogLevel level, i64 steadyNs, u32 threadId, u32 formatId, u8 argCount,
+                          std::span<const std::byte> args);
+        void writePlainLocked(LogLevel level, i64 steadyNs, u32 threadId, StringView message);
+        u32 internFormat(StringView format);
+        void emitFormat(u32 formatId);
+        bool ensureCapacity(usize size);
+        std::byte* append(usize size);
+        void openFile();
+        void rotate();
+
+        const String path_;
+        const BinaryLogConfig config_;
+
+        mutable std::mutex mutex_;
+        utils::MemoryMappedFile file_;
+        usize offset_ = 0;
+        u64 sequence_ = 0;
+        u64 droppedRecords_ = 0;
+        binlog::BinaryLogArgs plainArgs_;
+
+        // Interned format strings, keyed by the address of their (static) characters
+        std::unordered_map<const char*, u32> formatIds_;
+        Vector<String> formats_;
+        Vector<bool> formatsInFile_;
+    };
+}
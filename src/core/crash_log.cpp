@@ -0,0 +1,288 @@
+#include "crash_log.hpp"
+#include <bit>
+#include <csignal>
+#include <cstdlib>
+#include <exception>
+#include <fcntl.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace time_kill::core {
+    namespace {
+        constexpr int FatalSignals[] = {
+            SIGSEGV, SIGABRT, SIGFPE, SIGILL,
+#ifdef SIGBUS
+            SIGBUS,
+#endif
+        };
+        constexpr usize FatalSignalCount = std::size(FatalSignals);
+
+        using SignalHandler = void (*)(int);
+
+        // Process-wide handler state; only one ring installs handlers at a time
+        std::atomic<CrashLogRing*> HandlerRing = nullptr;
+        std::terminate_handler PreviousTerminate = nullptr;
+        SignalHandler PreviousSignalHandlers[FatalSignalCount] = {};
+
+        StringView signalName(const int signal) {
+            switch (signal) {
+                case SIGSEGV: return "SIGSEGV";
+                case SIGABRT: return "SIGABRT";
+                case SIGFPE:  return "SIGFPE";
+                case SIGILL:  return "SIGILL";
+#ifdef SIGBUS
+                case SIGBUS:  return "SIGBUS";
+#endif
+                default:      return "fatal signal";
+            }
+        }
+
+        int openForAppend(const char* path) {
+#if defined(_WIN32) || defined(_WIN64)
+            return _open(path, _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+            return ::open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+        }
+
+        void closeFile(const int fd) {
+#if defined(_WIN32) || defined(_WIN64)
+            _close(fd);
+#else
+            ::close(fd);
+#endif
+        }
+
+        // Buffered writer that only uses async-signal-safe calls
+        class DumpWriter {
+        public:
+            explicit DumpWriter(const int fd) : fd_(fd) {}
+            ~DumpWriter() { flush(); }
+
+            void append(const StringView text) {
+                for (const char c : text) {
+                    if (length_ == sizeof(buffer_)) {
+                        flush();
+                    }
+                    buffer_[length_++] = c;
+                }
+            }
+
+            void appendNumber(u64 value, const int width = 0) {
+                char digits[20];
+                int count = 0;
+                do {
+                    digits[count++] = static_cast<char>('0' + value % 10);
+                    value /= 10;
+                } while (value != 0 && count < 20);
+                for (int i = count; i < width; ++i) {
+                    append("0");
+                }
+                while (count > 0) {
+                    append(StringView(&digits[--count], 1));
+                }
+            }
+
+            // "YYYY-MM-DD hh:mm:ss.mmmZ"; gmtime/localtime are not async-signal-safe, so convert by hand
+            void appendUtcTime(const std::chrono::system_clock::time_point time) {
+                using namespace std::chrono;
+                const auto millis = time_point_cast<milliseconds>(time);
+                const auto day = floor<days>(millis);
+                const year_month_day date{ day };
+                const hh_mm_ss timeOfDay{ millis - day };
+
+                appendNumber(static_cast<u64>(static_cast<int>(date.year())), 4);
+                append("-");
+                appendNumber(static_cast<unsigned>(date.month()), 2);
+                append("-");
+                appendNumber(static_cast<unsigned>(date.day()), 2);
+                append(" ");
+                appendNumber(static_cast<u64>(timeOfDay.hours().count()), 2);
+                append(":");
+                appendNumber(static_cast<u64>(timeOfDay.minutes().count()), 2);
+                append(":");
+                appendNumber(static_cast<u64>(timeOfDay.seconds().count()), 2);
+                append(".");
+                appendNumber(static_cast<u64>(timeOfDay.subseconds().count()), 3);
+                append("Z");
+            }
+
+            void flush() {
+                usize written = 0;
+                while (written < length_) {
+#if defined(_WIN32) || defined(_WIN64)
+                    const int result = _write(fd_, buffer_ + written, static_cast<unsigned>(length_ - written));
+#else
+                    const auto result = ::write(fd_, buffer_ + written, length_ - written);
+#endif
+                    if (result <= 0) {
+                        break;
+                    }
+                    written += static_cast<usize>(result);
+                }
+                length_ = 0;
+            }
+
+        private:
+            int fd_;
+            char buffer_[4096];
+            usize length_ = 0;
+        };
+    }
+
+    CrashLogRing::CrashLogRing(const CrashLogConfig& config) : level_(config.level) {
+        if (config.dumpPath.empty() || config.dumpPath.size() >= MaxPathLength) {
+            throw std::runtime_error("Invalid crash log dump path: '" + config.dumpPath + "'");
+        }
+        config.dumpPath.copy(dumpPath_, config.dumpPath.size());
+
+        const usize capacity = std::bit_ceil(std::max<usize>(config.capacity, 2));
+        slots_ = createUniquePtr<Slot[]>(capacity);
+        mask_ = capacity - 1;
+
+        if (config.installHandlers) {
+            installHandlers();
+        }
+    }
+
+    CrashLogRing::~CrashLogRing() {
+        uninstallHandlers();
+    }
+
+    void CrashLogRing::record(const std::chrono::system_clock::time_point time, const LogLevel level,
+                              const u32 threadId, const StringView message) {
+        const u64 index = next_.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots_[index & mask_];
+
+        // Per-slot seqlock: a dump skips slots that are being written or were overwritten meanwhile
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.record.time = time;
+        slot.record.level = level;
+        slot.record.threadId = threadId;
+        slot.record.setMessage(message);
+
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    bool CrashLogRing::dump(const StringView reason, const String& path) const {
+        return dumpToFile(path.empty() ? dumpPath_ : path.c_str(), reason);
+    }
+
+    bool CrashLogRing::dumpToFile(const char* path, const StringView reason) const {
+        const int fd = openForAppend(path);
+        if (fd < 0) {
+            return false;
+        }
+
+        {
+            DumpWriter writer(fd);
+            writer.append("==== Crash log: ");
+            writer.append(reason);
+            writer.append(" ====\n");
+
+            const u64 end = next_.load(std::memory_order_acquire);
+            const u64 capacity = mask_ + 1;
+            const u64 begin = end > capacity ? end - capacity : 0;
+
+            LogRecord record;
+            for (u64 index = begin; index < end; ++index) {
+                const Slot& slot = slots_[index & mask_];
+                const u64 expected = 2 * index + 2;
+                if (slot.sequence.load(std::memory_order_acquire) != expected) {
+                    continue;
+                }
+                record = slot.record;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != expected) {
+                    continue;
+                }
+
+                writer.appendUtcTime(record.time);
+                writer.append(" [");
+                writer.append(logLevelLabel(record.level));
+                writer.append("] (");
+                writer.appendNumber(record.threadId);
+                writer.append(") ");
+                writer.append(record.text());
+                if (record.truncated) {
+                    writer.append("...");
+                }
+                writer.append("\n");
+            }
+            writer.append("==== End of crash log ====\n");
+        }
+
+        closeFile(fd);
+        return true;
+    }
+
+    void CrashLogRing::dumpOnCrash(const StringView reason) {
+        if (!crashDumped_.exchange(true)) {
+            dumpToFile(dumpPath_, reason);
+        }
+    }
+
+    void CrashLogRing::installHandlers() {
+        CrashLogRing* expected = nullptr;
+        if (!HandlerRing.compare_exchange_strong(expected, this)) {
+            return; // Another ring already owns the handlers
+        }
+
+        PreviousTerminate = std::set_terminate(&CrashLogRing::handleTerminate);
+        for (usize i = 0; i < FatalSignalCount; ++i) {
+            PreviousSignalHandlers[i] = std::signal(FatalSignals[i], &CrashLogRing::handleSignal);
+        }
+        handlersInstalled_ = true;
+    }
+
+    void CrashLogRing::uninstallHandlers() {
+        if (!handlersInstalled_) {
+            return;
+        }
+
+        for (usize i = 0; i < FatalSignalCount; ++i) {
+            std::signal(FatalSignals[i], PreviousSignalHandlers[i] == SIG_ERR ? SIG_DFL : PreviousSignalHandlers[i]);
+        }
+        std::set_terminate(PreviousTerminate);
+        HandlerRing.store(nullptr);
+        handlersInstalled_ = false;
+    }
+
+    void CrashLogRing::handleTerminate() {
+        if (CrashLogRing* ring = HandlerRing.load()) {
+            String reason = "std::terminate called";
+            if (const auto exception = std::current_exception()) {
+                try {
+                    std::rethrow_exception(exception);
+                } catch (const std::exception& e) {
+                    reason = String("uncaught exception: ") + e.what();
+                } catch (...) {
+                    reason = "uncaught exception of unknown type";
+                }
+            }
+            ring->dumpOnCrash(reason);
+        }
+
+        if (PreviousTerminate != nullptr) {
+            PreviousTerminate();
+        }
+        std::abort();
+    }
+
+    void CrashLogRing::handleSignal(const int signal) {
+        if (CrashLogRing* ring = HandlerRing.load()) {
+            ring->dumpOnCrash(signalName(signal));
+        }
+
+        // Re-raise with the default action so the process still terminates (and dumps core)
+        std::signal(signal, SIG_DFL);
+        std::raise(signal);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include "log_record.hpp"
+#include <atomic>
+
+namespace time_kill::core {
+    struct CrashLogConfig {
+        usize capacity = 1024;            // Records kept; rounded up to a power of two
+        LogLevel level = LogLevel::TRACE; // Lowest level kept, independent of the enabled log levels
+        String dumpPath = "crash_log.txt";
+        bool installHandlers = true;      // Dump on std::terminate and on fatal signals
+    };
+
+    //! Always-on flight recorder for the most recent log records. Recording is lock-free and
+    //! allocation-free (one fixed-size slot per record); nothing is written out until a dump is
+    //! requested, an exception escapes (std::terminate) or a fatal signal arrives.
+    //!
+    //! Dumps are appended to the dump file in a plain format using only async-signal-safe calls:
+    //! "<UTC time> [LEVEL] (thread) message", oldest record first.
+    class CrashLogRing {
+    public:
+        explicit CrashLogRing(const CrashLogConfig& config);
+
+        //! Restores the previous terminate and signal handlers if they were installed.
+        ~CrashLogRing();
+
+        CrashLogRing(const CrashLogRing&) = delete;
+        CrashLogRing& operator=(const CrashLogRing&) = delete;
+
+        void record(std::chrono::system_clock::time_point time, LogLevel level, u32 threadId, StringView message);
+
+        [[nodiscard]] bool accepts(const LogLevel level) const { return level >= level_; }
+        [[nodiscard]] LogLevel getLevel() const { return level_; }
+
+        //! Appends the current contents to `path` (the configured dump path if empty). Returns false
+        //! if the file could not be opened.
+        bool dump(StringView reason, const String& path = {}) const;
+
+    private:
+        struct Slot {
+            std::atomic<u64> sequence = 0; // 2 * index + 1 while being written, 2 * index + 2 when complete
+            LogRecord record;
+        };
+
+        bool dumpToFile(const char* path, StringView reason) const;
+
+        // Dumps only the first time it is called, so terminate -> abort -> SIGABRT writes one report
+        void dumpOnCrash(StringView reason);
+
+        void installHandlers();
+        void uninstallHandlers();
+        static void handleTerminate();
+        static void handleSignal(int signal);
+
+        static constexpr usize MaxPathLength = 512;
+
+        const LogLevel level_;
+        UniquePtr<Slot[]> slots_;
+        usize mask_ = 0;
+        std::atomic<u64> next_ = 0;
+        std::atomic<bool> crashDumped_ = false;
+        bool handlersInstalled_ = false;
+        char dumpPath_[MaxPathLength] = {}; // Copied up front, so the signal handler does not touch a String
+    };
+}
@@ -0,0 +1,47 @@
+#include "frame_pacer.hpp"
+#include <thread>
+
+namespace time_kill::core {
+    FramePacer::FramePacer(const f64 targetFrameRate) {
+        setTargetFrameRate(targetFrameRate);
+    }
+
+    void FramePacer::setTargetFrameRate(const f64 targetFrameRate) {
+        targetFrameRate_ = targetFrameRate > 0.0 ? targetFrameRate : 0.0;
+        period_ = targetFrameRate_ > 0.0
+                ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(1.0 / targetFrameRate_))
+                : Clock::duration::zero();
+        reset();
+    }
+
+    FramePacer::Clock::time_point FramePacer::wait() {
+        auto now = Clock::now();
+        if (!isEnabled()) {
+            return now;
+        }
+
+        if (nextFrame_ == Clock::time_point{}) {
+            nextFrame_ = now;
+        }
+
+        if (now < nextFrame_) {
+            if (nextFrame_ - now > SpinThreshold) {
+                std::this_thread::sleep_until(nextFrame_ - SpinThreshold);
+            }
+            while ((now = Clock::now()) < nextFrame_) {
+                std::this_thread::yield();
+            }
+        }
+
+        // Late frames shift the schedule rather than being made up for
+        nextFrame_ += period_;
+        if (nextFrame_ < now) {
+            nextFrame_ = now + period_;
+        }
+        return now;
+    }
+
+    void FramePacer::reset() {
+        nextFrame_ = {};
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <chrono>
+
+namespace time_kill::core {
+    //! Holds the frame loop to a target frame rate on the CPU.
+    //!
+    //! Call wait() at the top of the frame, before input is sampled, so the time spent waiting does
+    //! not end up between input and present. Sleeps until shortly before the deadline and yields for
+    //! the rest, since OS sleeps overshoot by up to a millisecond or more. A frame that runs late
+    //! moves the schedule instead of making the following frames catch up in a burst.
+    class FramePacer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        //! A target of zero (the default) disables pacing; wait() then returns immediately.
+        explicit FramePacer(f64 targetFrameRate = 0.0);
+
+        void setTargetFrameRate(f64 targetFrameRate);
+        [[nodiscard]] f64 getTargetFrameRate() const { return targetFrameRate_; }
+        [[nodiscard]] bool isEnabled() const { return period_ > Clock::duration::zero(); }
+
+        //! Blocks until the next frame is due and returns the current time.
+        Clock::time_point wait();
+
+        //! Forgets the schedule, e.g. after the app was paused.
+        void reset();
+
+    private:
+        //! Part of the wait spent yielding instead of sleeping.
+        static constexpr auto SpinThreshold = std::chrono::microseconds(1500);
+
+        f64 targetFrameRate_ = 0.0;
+        Clock::duration period_ = Clock::duration::zero();
+        Clock::time_point nextFrame_ = {};
+    };
+}
@@ -0,0 +1,262 @@
+#include "job_system.hpp"
+#include <algorithm>
+
+namespace time_kill::core {
+    namespace {
+        // Identifies the workers of a job system
+        thread_local const JobSystem* CurrentSystem = nullptr;
+        thread_local usize CurrentWorker = 0;
+
+        // Fast path before a worker goes to sleep
+        constexpr int SpinAttempts = 64;
+    }
+
+    JobSystem::JobSystem(const usize workerCount) {
+        workers_.reserve(workerCount);
+        for (usize i = 0; i < workerCount; ++i) {
+            workers_.push_back(createUniquePtr<Worker>(DequeCapacity));
+        }
+        // Start the threads only once every deque exists, they steal from each other right away
+        for (usize i = 0; i < workerCount; ++i) {
+            workers_[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+        }
+    }
+
+    JobSystem::~JobSystem() {
+        {
+            std::lock_guard lock(sleepMutex_);
+            stopping_.store(true);
+        }
+        wakeCondition_.notify_all();
+        for (const auto& worker : workers_) {
+            worker->thread.join();
+        }
+
+        // Without workers nothing has run the injected jobs yet
+        while (Job* job = findJob()) {
+            execute(*job);
+        }
+    }
+
+    JobSystem& JobSystem::getInstance() {
+        static JobSystem instance;
+        return instance;
+    }
+
+    void JobSystem::wait(JobCounter& counter) {
+        int idleAttempts = 0;
+        const bool isWorker = CurrentSystem == this;
+        while (!counter.isDone()) {
+            if (Job* job = isWorker ? findJob() : takeInjectedJob(counter)) {
+                execute(*job);
+                idleAttempts = 0;
+            } else if (++idleAttempts > SpinAttempts) {
+                std::this_thread::yield();
+            }
+        }
+
+        if (counter.error_) {
+            std::exception_ptr error = std::move(counter.error_);
+            counter.error_ = nullptr;
+            counter.failed_.store(false, std::memory_order_relaxed);
+            std::rethrow_exception(error);
+        }
+    }
+
+    usize JobSystem::getThreadIndex() const {
+        return CurrentSystem == this ? CurrentWorker : workers_.size();
+    }
+
+    usize JobSystem::defaultWorkerCount() {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 0;
+    }
+
+    JobSystem::Job& JobSystem::allocateJob() {
+        // Only when every slot is taken, help running jobs until one becomes free
+        if (CurrentSystem == this) {
+            JobPool& pool = workers_[CurrentWorker]->pool;
+            while (true) {
+                if (Job* job = tryAllocateJob(pool)) {
+                    return *job;
+                }
+                if (Job* other = findJob()) {
+                    execute(*other);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        // Other threads share one pool and leave running jobs to the workers; without workers the
+        // injected jobs have to run here, or nothing would ever free a slot
+        while (true) {
+            {
+                std::lock_guard lock(externalPoolMutex_);
+                if (Job* job = tryAllocateJob(externalPool_)) {
+                    return *job;
+                }
+            }
+            if (workers_.empty()) {
+                if (Job* other = findJob()) {
+                    execute(*other);
+                    continue;
+                }
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    JobSystem::Job* JobSystem::tryAllocateJob(JobPool& pool) {
+        // Skip slots that are still in flight (a waiting job may own one for a long time)
+        for (usize scanned = 0; scanned < JobPoolSize; ++scanned) {
+            Job& job = pool.jobs[pool.next++ % JobPoolSize];
+            if (!job.busy.load(std::memory_order_acquire)) {
+                job.busy.store(true, std::memory_order_relaxed);
+                return &job;
+            }
+        }
+        return nullptr;
+    }
+
+    void JobSystem::submit(Job& job) {
+        if (CurrentSystem == this) {
+            if (!workers_[CurrentWorker]->deque.push(&job)) {
+                execute(job); // Deque full: run it right away instead of blocking
+                return;
+            }
+        } else {
+            std::lock_guard lock(injectionMutex_);
+            injectionQueue_.push_back(&job);
+            injectedCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // Pairs with the fence in workerLoop: either the worker sees the job or we see the sleeper
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepingWorkers_.load(std::memory_order_relaxed) > 0) {
+            { std::lock_guard lock(sleepMutex_); }
+            wakeCondition_.notify_one();
+        }
+    }
+
+    JobSystem::Job* JobSystem::findJob() {
+        const bool isWorker = CurrentSystem == this;
+        if (isWorker) {
+            if (Job* job = workers_[CurrentWorker]->deque.pop()) {
+                return job;
+            }
+        }
+
+        if (injectedCount_.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard lock(injectionMutex_);
+            if (!injectionQueue_.empty()) {
+                Job* job = injectionQueue_.front();
+                injectionQueue_.pop_front();
+                injectedCount_.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        // Steal, starting after our own deque so thieves spread over the victims
+        const usize workerCount = workers_.size();
+        const usize start = isWorker ? CurrentWorker + 1 : 0;
+        for (usize i = 0; i < workerCount; ++i) {
+            const usize victim = (start + i) % workerCount;
+            if (isWorker && victim == CurrentWorker) {
+                continue;
+            }
+            if (Job* job = workers_[victim]->deque.steal()) {
+                return job;
+            }
+        }
+        return nullptr;
+    }
+
+    JobSystem::Job* JobSystem::takeInjectedJob(const JobCounter& counter) {
+        if (injectedCount_.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+
+        std::lock_guard lock(injectionMutex_);
+        const auto it = std::ranges::find(injectionQueue_, &counter, &Job::counter);
+        if (it == injectionQueue_.end()) {
+            return nullptr;
+        }
+        Job* job = *it;
+        injectionQueue_.erase(it);
+        injectedCount_.fetch_sub(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    void JobSystem::execute(Job& job) {
+        JobCounter* counter = job.counter;
+        std::exception_ptr unhandled;
+        try {
+            job.invoke(job);
+        } catch (...) {
+            if (counter == nullptr) {
+                unhandled = std::current_exception();
+            } else if (!counter->failed_.exchange(true, std::memory_order_relaxed)) {
+                counter->error_ = std::current_exception();
+            }
+        }
+        if (job.destroy != nullptr) {
+            job.destroy(job);
+        }
+
+        job.busy.store(false, std::memory_order_release);
+        // Last access: the counter may be destroyed as soon as it reaches zero
+        if (counter != nullptr) {
+            counter->pending_.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        // Nobody waits for this job; on a worker this ends in std::terminate
+        if (unhandled) {
+            std::rethrow_exception(unhandled);
+        }
+    }
+
+    bool JobSystem::hasQueuedJobs() const {
+        if (injectedCount_.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+        for (const auto& worker : workers_) {
+            if (!worker->deque.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::workerLoop(const usize workerIndex) {
+        CurrentSystem = this;
+        CurrentWorker = workerIndex;
+
+        int idleAttempts = 0;
+        while (true) {
+            if (Job* job = findJob()) {
+                execute(*job);
+                idleAttempts = 0;
+                continue;
+            }
+
+            if (++idleAttempts < SpinAttempts) {
+                std::this_thread::yield();
+                continue;
+            }
+            idleAttempts = 0;
+
+            std::unique_lock lock(sleepMutex_);
+            sleepingWorkers_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!hasQueuedJobs()) {
+                if (stopping_.load()) {
+                    sleepingWorkers_.fetch_sub(1, std::memory_order_relaxed);
+                    return;
+                }
+                wakeCondition_.wait(lock);
+            }
+            sleepingWorkers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include "work_stealing_deque.hpp"
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+namespace time_kill::core {
+    //! Counts the unfinished jobs scheduled against it; JobSystem::wait blocks until it reaches zero.
+    //! A counter may be reused once it is done. It must outlive every job scheduled against it.
+    class JobCounter {
+    public:
+        JobCounter() = default;
+        JobCounter(const JobCounter&) = delete;
+        JobCounter& operator=(const JobCounter&) = delete;
+
+        [[nodiscard]] bool isDone() const { return pending_.load(std::memory_order_acquire) == 0; }
+        [[nodiscard]] u32 getPending() const { return pending_.load(std::memory_order_relaxed); }
+
+    private:
+        friend class JobSystem;
+
+        std::atomic<u32> pending_ = 0;
+        std::atomic<bool> failed_ = false;
+        std::exception_ptr error_; // First exception thrown by one of the jobs, rethrown by wait
+    };
+
+    //! Work-stealing job system with one worker thread per core.
+    //!
+    //! Every worker owns a Chase-Lev deque: jobs scheduled from a worker go to its own deque without
+    //! locking, idle workers steal the oldest job of another worker. Jobs scheduled from any other
+    //! thread go through a shared injection queue. Jobs are small type-erased callables stored inline
+    //! in pools owned by the system (no heap allocation), grouped by JobCounter for dependencies:
+    //! wait(counter) runs other jobs until the counter reaches zero, so it may be called from inside
+    //! a job without blocking a worker. Threads that are not workers only help with the injected jobs
+    //! of the counter they wait on, so a render thread waiting on its recording jobs never picks up
+    //! unrelated long-running work; without workers, a job only runs once its counter is waited on.
+    class JobSystem {
+    public:
+        //! Bytes of captured state a job can hold inline. Capture large state by reference.
+        static constexpr usize JobStorageSize = 96;
+
+        //! Starts `workerCount` workers; defaultWorkerCount() leaves one core for the calling thread.
+        explicit JobSystem(usize workerCount = defaultWorkerCount());
+
+        //! Runs all remaining jobs and joins the workers.
+        ~JobSystem();
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        //! Engine-wide job system, started on first use.
+        static JobSystem& getInstance();
+
+        //! Queues `function` to run on any thread; `counter` (optional) is incremented now and
+        //! decremented once the job has finished.
+        template<typename Function>
+        void schedule(Function&& function, JobCounter* counter = nullptr);
+
+        template<typename Function>
+        void schedule(Function&& function, JobCounter& counter) {
+            schedule(std::forward<Function>(function), &counter);
+        }
+
+        //! Runs queued jobs on the calling thread until `counter` is done, then rethrows the first
+        //! exception thrown by one of its jobs. On a worker any job may run; on other threads only
+        //! the jobs of `counter` that went through the injection queue.
+        void wait(JobCounter& counter);
+
+        //! Calls `function(begin, end)` over sub-ranges of [0, count) of at most `grainSize` indices and
+        //! blocks until all of them have returned. Ranges are split recursively, so idle workers steal
+        //! large halves instead of single indices.
+        template<typename Function>
+        void parallelFor(usize count, usize grainSize, const Function& function);
+
+        //! parallelFor with a grain size that gives every thread a few ranges to balance with.
+        template<typename Function>
+        void parallelFor(usize count, const Function& function) {
+            parallelFor(count, std::max<usize>(1, count / (getThreadCount() * 4)), function);
+        }
+
+        [[nodiscard]] usize getWorkerCount() const { return workers_.size(); }
+
+        //! Workers plus the one external thread that waits on jobs (see getThreadIndex).
+        [[nodiscard]] usize getThreadCount() const { return workers_.size() + 1; }
+
+        //! 0 .. getWorkerCount() - 1 on this system's workers, getWorkerCount() on every other thread.
+        //! An external thread only runs jobs of counters it waits on itself, so per-thread resources
+        //! indexed by it are safe as long as the jobs using them are waited on by a single external
+        //! thread (e.g. the render thread recording command buffers in parallelFor).
+        [[nodiscard]] usize getThreadIndex() const;
+
+        //! Hardware concurrency minus one (the calling thread), at least zero.
+        [[nodiscard]] static usize defaultWorkerCount();
+
+    private:
+        struct alignas(64) Job {
+            void (*invoke)(Job& job) = nullptr;
+            void (*destroy)(Job& job) = nullptr;
+            JobCounter* counter = nullptr;
+            std::atomic<bool> busy = false; // Set from allocation until the job has finished
+            alignas(std::max_align_t) unsigned char storage[JobStorageSize];
+        };
+
+        //! Ring of jobs of one scheduling thread; a slot is reused once its job has finished.
+        struct JobPool {
+            UniquePtr<Job[]> jobs = createUniquePtr<Job[]>(JobPoolSize);
+            usize next = 0;
+        };
+
+        struct Worker {
+            explicit Worker(const usize capacity) : deque(capacity) {}
+
+            WorkStealingDeque<Job> deque;
+            JobPool pool;
+            std::thread thread;
+        };
+
+        template<typename Function>
+        void scheduleRange(usize begin, usize end, usize grainSize, const Function& function, JobCounter& counter);
+
+        Job& allocateJob();
+        static Job* tryAllocateJob(JobPool& pool);
+        void submit(Job& job);
+        Job* findJob();
+        Job* takeInjectedJob(const JobCounter& counter);
+        void execute(Job& job);
+        [[nodiscard]] bool hasQueuedJobs() const;
+        void workerLoop(usize workerIndex);
+
+        static constexpr usize DequeCapacity = 4096;
+        static constexpr usize JobPoolSize = 4096;   // Jobs per worker (and for all other threads) in flight at once
+
+        Vector<UniquePtr<Worker>> workers_;
+
+        // Jobs scheduled from threads that are not workers of this system. Owned here rather than by
+        // the scheduling thread, so queued jobs stay valid after that thread has exited
+        std::mutex externalPoolMutex_;
+        JobPool externalPool_;
+
+        // Jobs scheduled from threads that are not workers of this system
+        mutable std::mutex injectionMutex_;
+        std::deque<Job*> injectionQueue_;
+        std::atomic<usize> injectedCount_ = 0;
+
+        // Idle workers sleep here until a job is scheduled or the system stops
+        std::mutex sleepMutex_;
+        std::condition_variable wakeCondition_;
+        std::atomic<u32> sleepingWorkers_ = 0;
+        std::atomic<bool> stopping_ = false;
+    };
+
+    template<typename Function>
+    void JobSystem::schedule(Function&& function, JobCounter* counter) {
+        using Callable = std::decay_t<Function>;
+        static_assert(sizeof(Callable) <= JobStorageSize, "Job captures too much state; capture by reference instead");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "Job callable is over-aligned");
+
+        Job& job = allocateJob();
+        ::new (static_cast<void*>(job.storage)) Callable(std::forward<Function>(function));
+        job.invoke = [](Job& self) { (*std::launder(reinterpret_cast<Callable*>(self.storage)))(); };
+        if constexpr (std::is_trivially_destructible_v<Callable>) {
+            job.destroy = nullptr;
+        } else {
+            job.destroy = [](Job& self) { std::launder(reinterpret_cast<Callable*>(self.storage))->~Callable(); };
+        }
+        job.counter = counter;
+        if (counter != nullptr) {
+            counter->pending_.fetch_add(1, std::memory_order_relaxed);
+        }
+        submit(job);
+    }
+
+    template<typename Function>
+    void JobSystem::parallelFor(const usize count, const usize grainSize, const Function& function) {
+        if (count == 0) {
+            return;
+        }
+
+        JobCounter counter;
+        scheduleRange(0, count, std::max<usize>(grainSize, 1), function, counter);
+        wait(counter);
+    }
+
+    template<typename Function>
+    void JobSystem::scheduleRange(const usize begin, const usize end, const usize grainSize,
+                                  const Function& function, JobCounter& counter) {
+        schedule([this, begin, end, grainSize, &function, &counter] {
+            // Hand the upper halves to other threads and keep the lower part
+            usize last = end;
+            while (last - begin > grainSize) {
+                const usize middle = begin + (last - begin) / 2;
+                scheduleRange(middle, last, grainSize, function, counter);
+                last = middle;
+            }
+            function(begin, last);
+        }, counter);
+    }
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <chrono>
+
+namespace time_kill::core {
+    enum class LogLevel {
+        TRACE,
+        DEBUG,
+        INFO,
+        WARN,
+        ERROR
+    };
+
+    //! Fixed-width label of a level as it appears in text output, e.g. "INFO ".
+    constexpr StringView logLevelLabel(const LogLevel level) {
+        switch (level) {
+            case LogLevel::TRACE: return "TRACE";
+            case LogLevel::DEBUG: return "DEBUG";
+            case LogLevel::INFO:  return "INFO ";
+            case LogLevel::WARN:  return "WARN ";
+            case LogLevel::ERROR: return "ERROR";
+            default:              return "?????";
+        }
+    }
+
+    enum class DateFormat {
+        DD_MM_YYYY,
+        MM_DD_YYYY,
+        YYYY_MM_DD
+    };
+
+    enum class DateSeparator {
+        Hyphen,
+        Period,
+        Slash
+    };
+
+    //! Formats `time` as local date and time with milliseconds, e.g. "16-10-2026 09:20:53.094".
+    //! The date/time part is cached per thread and only recomputed when the second changes.
+    //! The returned view stays valid until the next call on the same thread.
+    StringView formatLogTimestamp(std::chrono::system_clock::time_point time,
+                                  DateFormat format,
+                                  DateSeparator separator);
+
+    //! Returns a small numeric id for the calling thread, stable for the lifetime of the thread.
+    u32 currentThreadId();
+
+    //! Fixed-size log record as it travels from the calling thread to the background writer.
+    //! Messages longer than MaxMessageLength are truncated, which keeps every record the same size
+    //! and allows the ring buffers to be allocated once up front.
+    struct LogRecord {
+        static constexpr usize MaxMessageLength = 236;
+
+        std::chrono::system_clock::time_point time;
+        LogLevel level = LogLevel::INFO;
+        u32 threadId = 0;
+        u16 length = 0;
+        bool truncated = false;
+        char message[MaxMessageLength] = {};
+
+        [[nodiscard]] StringView text() const {
+            return { message, length };
+        }
+
+        void setMessage(const StringView text) {
+            truncated = text.size() > MaxMessageLength;
+            length = static_cast<u16>(truncated ? MaxMessageLength : text.size());
+            std::char_traits<char>::copy(message, text.data(), length);
+        }
+    };
+
+    static_assert(sizeof(LogRecord) <= 256, "LogRecord should stay within four cache lines");
+}
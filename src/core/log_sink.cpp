@@ -0,0 +1,216 @@
+#include "log_sink.hpp"
+#include "logger.hpp"
+#include <filesystem>
+#include <iostream>
+
+namespace time_kill::core {
+    void appendLogLine(String& out, const LogEntry& entry, const DateFormat dateFormat, const DateSeparator separator) {
+        out += formatLogTimestamp(entry.time, dateFormat, separator);
+        out += " [";
+        out += logLevelLabel(entry.level);
+        out += "] ";
+        out += entry.message;
+        if (entry.truncated) {
+            out += "...";
+        }
+    }
+
+    void rotateLogFiles(const String& path, const u32 maxFiles) {
+        namespace fs = std::filesystem;
+
+        const auto rotatedPath = [&](const u32 index) { return path + "." + std::to_string(index); };
+
+        std::error_code error;
+        if (maxFiles <= 1) {
+            fs::remove(path, error);
+            return;
+        }
+
+        fs::remove(rotatedPath(maxFiles - 1), error);
+        for (u32 index = maxFiles - 1; index > 0; --index) {
+            const String source = index == 1 ? path : rotatedPath(index - 1);
+            if (fs::exists(source, error)) {
+                fs::rename(source, rotatedPath(index), error);
+            }
+        }
+    }
+
+    void LogSink::write(const std::span<const LogEntry> entries) {
+        for (const auto& entry : entries) {
+            write(entry);
+        }
+    }
+
+    // TextLogSink
+
+    TextLogSink::TextLogSink(const LogLevel level) : LogSink(level) {}
+
+    void TextLogSink::setFormatter(LogFormatter formatter) {
+        std::lock_guard lock(mutex_);
+        formatter_ = std::move(formatter);
+    }
+
+    void TextLogSink::write(const LogEntry& entry) {
+        std::lock_guard lock(mutex_);
+        buffer_.clear();
+        format(buffer_, entry);
+        buffer_ += '\n';
+        writeText(buffer_);
+    }
+
+    void TextLogSink::write(const std::span<const LogEntry> entries) {
+        std::lock_guard lock(mutex_);
+        buffer_.clear();
+        for (const auto& entry : entries) {
+            format(buffer_, entry);
+            buffer_ += '\n';
+        }
+        if (!buffer_.empty()) {
+            writeText(buffer_);
+        }
+    }
+
+    void TextLogSink::flush() {
+        std::lock_guard lock(mutex_);
+        flushText();
+    }
+
+    void TextLogSink::format(String& out, const LogEntry& entry) const {
+        if (formatter_) {
+            formatter_(out, entry);
+            return;
+        }
+
+        const auto& logger = Logger::getInstance();
+        appendLogLine(out, entry, logger.getDateFormat(), logger.getDateSeparator());
+    }
+
+    // ConsoleLogSink
+
+    ConsoleLogSink::ConsoleLogSink(const LogLevel level, const ConsoleStream stream)
+        : TextLogSink(level), stream_(stream == ConsoleStream::Stderr ? std::cerr : std::cout) {}
+
+    void ConsoleLogSink::writeText(const StringView text) {
+        stream_.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    void ConsoleLogSink::flushText() {
+        stream_.flush();
+    }
+
+    // FileLogSink
+
+    FileLogSink::FileLogSink(const String& path, const LogLevel level)
+        : TextLogSink(level), path_(path) {
+        file_.open(path_, std::fstream::out | std::fstream::app);
+        if (!file_.is_open()) {
+            throw std::runtime_error("Failed to open log file: " + path_);
+        }
+    }
+
+    void FileLogSink::write(const LogEntry& entry) {
+        TextLogSink::write(entry);
+        flush();
+    }
+
+    void FileLogSink::writeText(const StringView text) {
+        file_.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    void FileLogSink::flushText() {
+        file_.flush();
+    }
+
+    // RotatingFileLogSink
+
+    RotatingFileLogSink::RotatingFileLogSink(const String& path, const RotatingFileConfig& config, const LogLevel level)
+        : FileLogSink(path, level), config_(config) {
+        // Keep the log of a previous run as <path>.1
+        std::error_code error;
+        if (std::filesystem::file_size(path_, error) > 0 && !error) {
+            file_.close();
+            rotateLogFiles(path_, config_.maxFiles);
+            file_.open(path_, std::fstream::out | std::fstream::trunc);
+            if (!file_.is_open()) {
+                throw std::runtime_error("Failed to open log file: " + path_);
+            }
+        }
+    }
+
+    void RotatingFileLogSink::writeText(const StringView text) {
+        if (fileSize_ > 0 && fileSize_ + text.size() > config_.maxFileSize) {
+            file_.close();
+            rotateLogFiles(path_, config_.maxFiles);
+            file_.open(path_, std::fstream::out | std::fstream::trunc);
+            fileSize_ = 0;
+        }
+
+        FileLogSink::writeText(text);
+        fileSize_ += text.size();
+    }
+
+    // MemoryLogSink
+
+    MemoryLogSink::MemoryLogSink(const usize capacity, const LogLevel level)
+        : TextLogSink(level), lines_(std::max<usize>(capacity, 1)) {}
+
+    void MemoryLogSink::write(const LogEntry& entry) {
+        std::lock_guard lock(mutex_);
+        store(entry);
+    }
+
+    void MemoryLogSink::write(const std::span<const LogEntry> entries) {
+        std::lock_guard lock(mutex_);
+        for (const auto& entry : entries) {
+            store(entry);
+        }
+    }
+
+    Vector<String> MemoryLogSink::snapshot() {
+        std::lock_guard lock(mutex_);
+
+        Vector<String> result;
+        result.reserve(count_);
+        const usize first = (next_ + lines_.size() - count_) % lines_.size();
+        for (usize i = 0; i < count_; ++i) {
+            result.push_back(lines_[(first + i) % lines_.size()]);
+        }
+        return result;
+    }
+
+    void MemoryLogSink::clear() {
+        std::lock_guard lock(mutex_);
+        next_ = 0;
+        count_ = 0;
+    }
+
+    void MemoryLogSink::store(const LogEntry& entry) {
+        String& line = lines_[next_];
+        line.clear();
+        format(line, entry);
+
+        next_ = (next_ + 1) % lines_.size();
+        count_ = std::min(count_ + 1, lines_.size());
+    }
+
+    // CallbackLogSink
+
+    CallbackLogSink::CallbackLogSink(Callback callback, const LogLevel level)
+        : TextLogSink(level), callback_(std::move(callback)) {}
+
+    void CallbackLogSink::write(const LogEntry& entry) {
+        std::lock_guard lock(mutex_);
+        line_.clear();
+        format(line_, entry);
+        callback_(entry, line_);
+    }
+
+    void CallbackLogSink::write(const std::span<const LogEntry> entries) {
+        std::lock_guard lock(mutex_);
+        for (const auto& entry : entries) {
+            line_.clear();
+            format(line_, entry);
+            callback_(entry, line_);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include "log_record.hpp"
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <span>
+
+namespace time_kill::core {
+    namespace binlog {
+        class BinaryLogArgs;
+    }
+
+    //! A log message as it is handed to the sinks. The views are only valid during the write call.
+    struct LogEntry {
+        std::chrono::system_clock::time_point time;
+        LogLevel level = LogLevel::INFO;
+        u32 threadId = 0;
+        StringView message;
+        bool truncated = false;
+
+        // Source of a formatted message; `args` is null for plain messages and for queued (async) records
+        StringView format;
+        const binlog::BinaryLogArgs* args = nullptr;
+    };
+
+    //! Appends the default text form of an entry: "<timestamp> [LEVEL] message" (no line break).
+    void appendLogLine(String& out, const LogEntry& entry, DateFormat dateFormat, DateSeparator separator);
+
+    //! Rotates <path> to <path>.1, <path>.1 to <path>.2 and so on, removing the file that would
+    //! become <path>.<maxFiles>. With maxFiles <= 1 the file is simply removed.
+    void rotateLogFiles(const String& path, u32 maxFiles);
+
+    //! Destination of log records. Every sink has its own level threshold and does its own
+    //! locking, so a slow sink only holds up the records that are written to it.
+    class LogSink {
+    public:
+        virtual ~LogSink() = default;
+
+        LogSink(const LogSink&) = delete;
+        LogSink& operator=(const LogSink&) = delete;
+
+        // Sinks registered with the Logger should be changed via Logger::setSinkLevel instead,
+        // which also updates the Logger's fast-path level check
+        void setLevel(const LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+        [[nodiscard]] LogLevel getLevel() const { return level_.load(std::memory_order_relaxed); }
+        [[nodiscard]] bool accepts(const LogLevel level) const { return level >= getLevel(); }
+
+        virtual void write(const LogEntry& entry) = 0;
+
+        // Batches come from the async writer; the default writes the entries one by one
+        virtual void write(std::span<const LogEntry> entries);
+
+        virtual void flush() {}
+
+        // Sinks that store the packed format arguments instead of text are written on the logging
+        // thread even in async mode, because the arguments are not queued
+        [[nodiscard]] virtual bool usesPackedArgs() const { return false; }
+
+    protected:
+        explicit LogSink(const LogLevel level) : level_(level) {}
+
+    private:
+        std::atomic<LogLevel> level_;
+    };
+
+    //! Turns an entry into one line of text (without line break)
+    using LogFormatter = std::function<void(String& out, const LogEntry& entry)>;
+
+    //! Base of the sinks that write text. Entries are formatted with the sink's formatter (by default
+    //! appendLogLine with the Logger's date format), and a batch is formatted into a single write.
+    class TextLogSink : public LogSink {
+    public:
+        void setFormatter(LogFormatter formatter);
+
+        void write(const LogEntry& entry) override;
+        void write(std::span<const LogEntry> entries) override;
+        void flush() override;
+
+    protected:
+        explicit TextLogSink(LogLevel level);
+
+        // Called with mutex_ held; `text` holds complete lines
+        virtual void writeText(StringView text) = 0;
+        virtual void flushText() {}
+
+        // Appends the formatted entry to `out`; requires mutex_
+        void format(String& out, const LogEntry& entry) const;
+
+        std::mutex mutex_;
+
+    private:
+        LogFormatter formatter_;
+        String buffer_;
+    };
+
+    enum class ConsoleStream {
+        Stdout,
+        Stderr
+    };
+
+    class ConsoleLogSink final : public TextLogSink {
+    public:
+        explicit ConsoleLogSink(LogLevel level = LogLevel::TRACE, ConsoleStream stream = ConsoleStream::Stdout);
+
+    protected:
+        void writeText(StringView text) override;
+        void flushText() override;
+
+    private:
+        std::ostream& stream_;
+    };
+
+    //! Appends to a text file. Single records (synchronous logging) are flushed right away;
+    //! batches from the async writer are flushed according to its flush policy.
+    class FileLogSink : public TextLogSink {
+    public:
+        explicit FileLogSink(const String& path, LogLevel level = LogLevel::TRACE);
+
+        void write(const LogEntry& entry) override;
+        using TextLogSink::write;
+
+    protected:
+        void writeText(StringView text) override;
+        void flushText() override;
+
+        const String path_;
+        std::ofstream file_;
+    };
+
+    struct RotatingFileConfig {
+        usize maxFileSize = 16 * 1024 * 1024; // Size after which the file is rotated
+        u32 maxFiles = 4;                     // Current file plus rotated ones (<path>.1 ... <path>.<maxFiles - 1>)
+    };
+
+    //! Text file that is rotated like the binary log once it exceeds its size cap.
+    //! An existing file is kept as <path>.1 on start.
+    class RotatingFileLogSink final : public FileLogSink {
+    public:
+        RotatingFileLogSink(const String& path, const RotatingFileConfig& config, LogLevel level = LogLevel::TRACE);
+
+    protected:
+        void writeText(StringView text) override;
+
+    private:
+        const RotatingFileConfig config_;
+        usize fileSize_ = 0;
+    };
+
+    //! Keeps the last `capacity` formatted lines in memory, e.g. for an in-game console or a crash report.
+    //! Slots are reused, so after warm-up writing a line does not allocate.
+    class MemoryLogSink final : public TextLogSink {
+    public:
+        explicit MemoryLogSink(usize capacity, LogLevel level = LogLevel::TRACE);
+
+        void write(const LogEntry& entry) override;
+        void write(std::span<const LogEntry> entries) override;
+
+        //! Returns the stored lines, oldest first
+        [[nodiscard]] Vector<String> snapshot();
+        void clear();
+
+    protected:
+        void writeText(StringView) override {}
+
+    private:
+        void store(const LogEntry& entry);
+
+        Vector<String> lines_;
+        usize next_ = 0;
+        usize count_ = 0;
+    };
+
+    //! Forwards every entry and its formatted line to a callback (called under the sink's lock)
+    class CallbackLogSink final : public TextLogSink {
+    public:
+        using Callback = std::function<void(const LogEntry& entry, StringView line)>;
+
+        explicit CallbackLogSink(Callback callback, LogLevel level = LogLevel::TRACE);
+
+        void write(const LogEntry& entry) override;
+        void write(std::span<const LogEntry> entries) override;
+
+    protected:
+        void writeText(StringView) override {}
+
+    private:
+        Callback callback_;
+        String line_;
+    };
+}
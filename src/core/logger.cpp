@@ -1,8 +1,7 @@
 #include "logger.hpp"
 
-#include <iomanip>
-#include <iostream>
-#include <sstream>
+#include <ctime>
+#include <limits>
 
 #ifdef DEBUG_LOGGING_ENABLED
 #define DEBUG_LOG(message) Logger::getInstance().log(LogLevel::DEBUG, message)
@@ -11,40 +10,248 @@
 #endif
 
 namespace time_kill::core {
+    u32 currentThreadId() {
+        static std::atomic<u32> nextThreadId = 1;
+        thread_local const u32 threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        return threadId;
+    }
+
     Logger& Logger::getInstance() {
         static Logger instance;
         return instance;
     }
 
+    Logger::Logger() : sinks_(createSharedPtr<const LogSinkList>()) {
+        consoleSink_ = createSharedPtr<ConsoleLogSink>();
+        addSink(consoleSink_);
+    }
+
+    Logger::~Logger() {
+        disableAsync();
+        disableBinaryLog();
+        disableCrashLog();
+    }
+
     void Logger::init(const String &logFilePath, const bool debugLoggingEnabled) {
-        std::lock_guard<std::mutex> lock(logMutex_);
-        if (logFile_.is_open()) {
-            logFile_.close();
+        auto fileSink = createSharedPtr<FileLogSink>(logFilePath);
+        if (fileSink_) {
+            removeSink(fileSink_);
+        }
+        fileSink_ = std::move(fileSink);
+        addSink(fileSink_);
+
+        setLevelEnabled(LogLevel::DEBUG, debugLoggingEnabled);
+    }
+
+    void Logger::addSink(SharedPtr<LogSink> sink) {
+        if (!sink) {
+            throw std::runtime_error("Cannot add a null log sink");
+        }
+
+        std::lock_guard lock(sinksMutex_);
+        auto sinks = createSharedPtr<LogSinkList>(*sinks_.load(std::memory_order_acquire));
+        sinks->push_back(std::move(sink));
+        publishSinks(std::move(sinks));
+    }
+
+    void Logger::removeSink(const SharedPtr<LogSink>& sink) {
+        std::lock_guard lock(sinksMutex_);
+        auto sinks = createSharedPtr<LogSinkList>(*sinks_.load(std::memory_order_acquire));
+        std::erase(*sinks, sink);
+        publishSinks(std::move(sinks));
+    }
+
+    void Logger::setSinkLevel(const SharedPtr<LogSink>& sink, const LogLevel level) {
+        std::lock_guard lock(sinksMutex_);
+        sink->setLevel(level);
+        publishSinks(sinks_.load(std::memory_order_acquire));
+    }
+
+    void Logger::publishSinks(SharedPtr<const LogSinkList> sinks) {
+        u32 levels = 0;
+        bool packedArgs = false;
+        for (const auto& sink : *sinks) {
+            levels |= levelsFrom(sink->getLevel());
+            packedArgs |= sink->usesPackedArgs();
+        }
+
+        sinks_.store(std::move(sinks), std::memory_order_release);
+        sinkLevels_.store(levels, std::memory_order_relaxed);
+        needsPackedArgs_.store(packedArgs, std::memory_order_relaxed);
+    }
+
+    void Logger::log(const LogLevel level, const StringView message) {
+        if (!isLevelEnabled(level)) {
+            return;
         }
 
-        logFile_.open(logFilePath, std::fstream::out | std::fstream::app);
-        if (!logFile_.is_open()) {
-            throw std::runtime_error("Failed to open log file: " + logFilePath);
+        LogEntry entry;
+        entry.time = std::chrono::system_clock::now();
+        entry.level = level;
+        entry.threadId = currentThreadId();
+        entry.message = message;
+        dispatch(entry);
+    }
+
+    void Logger::log(const LogLevel level, const StringView message, const StringView format,
+                     const binlog::BinaryLogArgs* packedArgs) {
+        if (!isLevelEnabled(level)) {
+            return;
         }
 
-        debugLoggingEnabled_ = debugLoggingEnabled;
+        LogEntry entry;
+        entry.time = std::chrono::system_clock::now();
+        entry.level = level;
+        entry.threadId = currentThreadId();
+        entry.message = message;
+        entry.format = format;
+        entry.args = packedArgs;
+        dispatch(entry);
     }
 
-    void Logger::log(const LogLevel level, const String& message) {
-        if ((level == LogLevel::DEBUG && !debugLoggingEnabled_) ||
-            (level == LogLevel::TRACE && !traceLoggingEnabled_)) {
+    void Logger::dispatch(const LogEntry& entry) {
+        // The crash log sees its levels even when they are disabled for the sinks
+        if (CrashLogRing* ring = crashRing_.load(std::memory_order_acquire); ring && ring->accepts(entry.level)) {
+            ring->record(entry.time, entry.level, entry.threadId, entry.message);
+        }
+        if ((sinkLevelMask() & levelBit(entry.level)) == 0) {
             return;
         }
 
-        std::lock_guard lock(logMutex_);
-        const auto logMessage = getTimestamp() + " [" + levelToString(level) + "] " + message;
+        const auto sinks = sinks_.load(std::memory_order_acquire);
+        AsyncLogWriter* writer = activeAsyncWriter_.load(std::memory_order_acquire);
+
+        // Each sink locks only itself. In async mode the text sinks are left to the writer thread,
+        // which keeps slow console or file I/O off the logging thread entirely.
+        bool enqueue = false;
+        for (const auto& sink : *sinks) {
+            if (!sink->accepts(entry.level)) {
+                continue;
+            }
+            if (writer != nullptr && !sink->usesPackedArgs()) {
+                enqueue = true;
+                continue;
+            }
+            sink->write(entry);
+        }
+
+        if (enqueue) {
+            writer->enqueue(entry.level, entry.message, entry.time);
+        }
+    }
+
+    void Logger::enableAsync(const AsyncLogConfig& config) {
+        disableAsync();
+
+        asyncWriter_ = createUniquePtr<AsyncLogWriter>(
+            config,
+            [this](const std::span<const LogRecord> records) { writeBatch(records); },
+            [this] { flushOutputs(); }
+        );
+        activeAsyncWriter_.store(asyncWriter_.get(), std::memory_order_release);
+    }
+
+    void Logger::disableAsync() {
+        activeAsyncWriter_.store(nullptr, std::memory_order_release);
 
-        // Output to console
-        std::cout << logMessage << "\n";
+        // Destroying the writer drains and flushes everything that is still queued
+        asyncWriter_.reset();
+    }
+
+    bool Logger::isAsyncEnabled() const {
+        return activeAsyncWriter_.load(std::memory_order_acquire) != nullptr;
+    }
 
-        // Output to file
-        if (logFile_.is_open()) {
-            logFile_ << logMessage << std::endl;
+    AsyncLogStats Logger::getAsyncStats() const {
+        if (const AsyncLogWriter* writer = activeAsyncWriter_.load(std::memory_order_acquire)) {
+            return writer->getStats();
+        }
+        return {};
+    }
+
+    void Logger::flush() {
+        if (AsyncLogWriter* writer = activeAsyncWriter_.load(std::memory_order_acquire)) {
+            writer->flush();
+            return;
+        }
+        flushOutputs();
+    }
+
+    void Logger::enableBinaryLog(const String& path, const BinaryLogConfig& config) {
+        disableBinaryLog();
+
+        binaryLog_ = createSharedPtr<BinaryLogSink>(path, config);
+        addSink(binaryLog_);
+    }
+
+    void Logger::disableBinaryLog() {
+        if (binaryLog_) {
+            removeSink(binaryLog_);
+            binaryLog_.reset();
+        }
+    }
+
+    bool Logger::isBinaryLogEnabled() const {
+        return binaryLog_ != nullptr;
+    }
+
+    void Logger::enableCrashLog(const CrashLogConfig& config) {
+        disableCrashLog();
+
+        crashLog_ = createUniquePtr<CrashLogRing>(config);
+        crashRing_.store(crashLog_.get(), std::memory_order_release);
+        crashLevels_.store(levelsFrom(config.level), std::memory_order_relaxed);
+    }
+
+    void Logger::disableCrashLog() {
+        crashLevels_.store(0, std::memory_order_relaxed);
+        crashRing_.store(nullptr, std::memory_order_release);
+        crashLog_.reset();
+    }
+
+    bool Logger::isCrashLogEnabled() const {
+        return crashRing_.load(std::memory_order_acquire) != nullptr;
+    }
+
+    bool Logger::dumpCrashLog(const StringView reason, const String& path) const {
+        const CrashLogRing* ring = crashRing_.load(std::memory_order_acquire);
+        return ring != nullptr && ring->dump(reason, path);
+    }
+
+    void Logger::writeBatch(const std::span<const LogRecord> records) {
+        batchEntries_.clear();
+        for (const auto& record : records) {
+            LogEntry& entry = batchEntries_.emplace_back();
+            entry.time = record.time;
+            entry.level = record.level;
+            entry.threadId = record.threadId;
+            entry.message = record.text();
+            entry.truncated = record.truncated;
+        }
+
+        // Each text sink gets the part of the batch it accepts as a single write
+        const auto sinks = sinks_.load(std::memory_order_acquire);
+        for (const auto& sink : *sinks) {
+            if (sink->usesPackedArgs()) {
+                continue; // Already written on the logging thread
+            }
+
+            sinkEntries_.clear();
+            for (const auto& entry : batchEntries_) {
+                if (sink->accepts(entry.level)) {
+                    sinkEntries_.push_back(entry);
+                }
+            }
+            if (!sinkEntries_.empty()) {
+                sink->write(sinkEntries_);
+            }
+        }
+    }
+
+    void Logger::flushOutputs() {
+        const auto sinks = sinks_.load(std::memory_order_acquire);
+        for (const auto& sink : *sinks) {
+            sink->flush();
         }
     }
 
@@ -69,40 +276,48 @@ namespace time_kill::core {
     }
 
     void Logger::setDebugEnabled(const bool enabled) {
-        debugLoggingEnabled_ = enabled;
+        setLevelEnabled(LogLevel::DEBUG, enabled);
     }
 
     bool Logger::isDebugEnabled() const {
-        return debugLoggingEnabled_;
+        return (enabledLevels_.load(std::memory_order_relaxed) & levelBit(LogLevel::DEBUG)) != 0;
     }
 
     void Logger::setTraceEnabled(const bool enabled) {
-        traceLoggingEnabled_ = enabled;
+        setLevelEnabled(LogLevel::TRACE, enabled);
     }
 
     bool Logger::isTraceEnabled() const {
-        return traceLoggingEnabled_;
+        return (enabledLevels_.load(std::memory_order_relaxed) & levelBit(LogLevel::TRACE)) != 0;
+    }
+
+    void Logger::setLevelEnabled(const LogLevel level, const bool enabled) {
+        if (enabled) {
+            enabledLevels_.fetch_or(levelBit(level), std::memory_order_relaxed);
+        } else {
+            enabledLevels_.fetch_and(~levelBit(level), std::memory_order_relaxed);
+        }
     }
 
     void Logger::setDateFormat(const DateFormat format) {
-        dateFormat_ = format;
+        dateFormat_.store(format, std::memory_order_relaxed);
     }
 
     void Logger::setDateFormat(const DateFormat format, const DateSeparator separator) {
-        dateFormat_ = format;
-        dateSeparator_ = separator;
+        dateFormat_.store(format, std::memory_order_relaxed);
+        dateSeparator_.store(separator, std::memory_order_relaxed);
     }
 
     DateFormat Logger::getDateFormat() const {
-        return dateFormat_;
+        return dateFormat_.load(std::memory_order_relaxed);
     }
 
     void Logger::setDateSeparator(const DateSeparator separator) {
-        dateSeparator_ = separator;
+        dateSeparator_.store(separator, std::memory_order_relaxed);
     }
 
     DateSeparator Logger::getDateSeparator() const {
-        return dateSeparator_;
+        return dateSeparator_.load(std::memory_order_relaxed);
     }
 
     constexpr std::string_view dateSeparatorToString(const DateSeparator sep) {
@@ -114,53 +329,108 @@ namespace time_kill::core {
         }
     }
 
-    String formatDateTime(const std::chrono::system_clock::time_point now,
-        const DateFormat format,
-        const DateSeparator separator
-    ) {
-        const std::time_t time = std::chrono::system_clock::to_time_t(now);
-        std::tm tm = {};
-        localtime_s(&tm, &time);
-
-        const std::string_view sep = dateSeparatorToString(separator);
+    namespace {
+        // "dd-mm-yyyy hh:mm:ss.mmm"
+        constexpr usize TimestampSecondsLength = 19;
+        constexpr usize TimestampLength = TimestampSecondsLength + 4;
+
+        // Date/time prefix of the last formatted second. Each thread keeps its own copy, so the cache
+        // needs no locking; with the async writer there is only one formatting thread anyway.
+        struct TimestampCache {
+            std::time_t second = std::numeric_limits<std::time_t>::min();
+            DateFormat format = DateFormat::DD_MM_YYYY;
+            DateSeparator separator = DateSeparator::Hyphen;
+            char text[TimestampLength] = {};
+        };
+
+        thread_local TimestampCache LocalTimestampCache;
+
+        std::tm toLocalTime(const std::time_t time) {
+            std::tm tm = {};
+#if defined(_WIN32) || defined(_WIN64)
+            localtime_s(&tm, &time);
+#else
+            localtime_r(&time, &tm);
+#endif
+            return tm;
+        }
 
-        std::ostringstream oss;
-        switch (format) {
-            case DateFormat::DD_MM_YYYY:
-                oss << std::put_time(&tm, ("%d" + std::string(sep) + "%m" + std::string(sep) + "%Y %H:%M:%S").c_str());
-            break;
-            case DateFormat::MM_DD_YYYY:
-                oss << std::put_time(&tm, ("%m" + std::string(sep) + "%d" + std::string(sep) + "%Y %H:%M:%S").c_str());
-            break;
-            case DateFormat::YYYY_MM_DD:
-                oss << std::put_time(&tm, ("%Y" + std::string(sep) + "%m" + std::string(sep) + "%d %H:%M:%S").c_str());
-            break;
-            default:
-                return "";
+        char* writeDigits(char* out, int value, const int digits) {
+            for (int i = digits - 1; i >= 0; --i) {
+                out[i] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            }
+            return out + digits;
         }
 
-        return oss.str();
+        void formatDateTime(char* out, const std::time_t time, const DateFormat format, const DateSeparator separator) {
+            const std::tm tm = toLocalTime(time);
+            const std::string_view separatorText = dateSeparatorToString(separator);
+            const char sep = separatorText.empty() ? '-' : separatorText.front();
+
+            switch (format) {
+                case DateFormat::MM_DD_YYYY:
+                    out = writeDigits(out, tm.tm_mon + 1, 2);
+                    *out++ = sep;
+                    out = writeDigits(out, tm.tm_mday, 2);
+                    *out++ = sep;
+                    out = writeDigits(out, tm.tm_year + 1900, 4);
+                    break;
+                case DateFormat::YYYY_MM_DD:
+                    out = writeDigits(out, tm.tm_year + 1900, 4);
+                    *out++ = sep;
+                    out = writeDigits(out, tm.tm_mon + 1, 2);
+                    *out++ = sep;
+                    out = writeDigits(out, tm.tm_mday, 2);
+                    break;
+                case DateFormat::DD_MM_YYYY:
+                default:
+                    out = writeDigits(out, tm.tm_mday, 2);
+                    *out++ = sep;
+                    out = writeDigits(out, tm.tm_mon + 1, 2);
+                    *out++ = sep;
+                    out = writeDigits(out, tm.tm_year + 1900, 4);
+                    break;
+            }
+
+            *out++ = ' ';
+            out = writeDigits(out, tm.tm_hour, 2);
+            *out++ = ':';
+            out = writeDigits(out, tm.tm_min, 2);
+            *out++ = ':';
+            out = writeDigits(out, tm.tm_sec, 2);
+            *out = '.';
+        }
     }
 
-    String Logger::getTimestamp() const {
+    StringView formatLogTimestamp(const std::chrono::system_clock::time_point time,
+                                  const DateFormat format,
+                                  const DateSeparator separator) {
         using namespace std::chrono;
-        const auto now = system_clock::now();
-        const auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
+        const auto sinceEpoch = duration_cast<milliseconds>(time.time_since_epoch());
+        const std::time_t second = static_cast<std::time_t>(floor<seconds>(sinceEpoch).count());
+        const int millis = static_cast<int>(sinceEpoch.count() - static_cast<i64>(second) * 1000);
+
+        // Only go through localtime when the second (or the format) changes
+        auto& cache = LocalTimestampCache;
+        if (cache.second != second || cache.format != format || cache.separator != separator) {
+            formatDateTime(cache.text, second, format, separator);
+            cache.second = second;
+            cache.format = format;
+            cache.separator = separator;
+        }
+
+        writeDigits(cache.text + TimestampSecondsLength + 1, millis, 3);
+        return { cache.text, TimestampLength };
+    }
 
-        std::ostringstream oss;
-        oss << formatDateTime(now, dateFormat_, dateSeparator_);
-        oss << "." << std::setfill('0') << std::setw(3) << ms.count();
-        return oss.str();
+    String Logger::getTimestamp(const std::chrono::system_clock::time_point time) const {
+        return String(formatLogTimestamp(time,
+                                         dateFormat_.load(std::memory_order_relaxed),
+                                         dateSeparator_.load(std::memory_order_relaxed)));
     }
 
     String Logger::levelToString(const LogLevel level) {
-        switch (level) {
-            case LogLevel::TRACE: return "TRACE";
-            case LogLevel::DEBUG: return "DEBUG";
-            case LogLevel::INFO:  return "INFO ";
-            case LogLevel::WARN:  return "WARN ";
-            case LogLevel::ERROR: return "ERROR";
-            default:              return "?????";
-        }
+        return String(logLevelLabel(level));
     }
 }
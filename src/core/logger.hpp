@@ -1,29 +1,24 @@
 #pragma once
 
 #include "prerequisites.hpp"
-#include <fstream>
+#include "log_record.hpp"
+#include "async_log_writer.hpp"
+#include "binary_log_sink.hpp"
+#include "crash_log.hpp"
+#include "log_sink.hpp"
+#include <algorithm>
+#include <format>
 #include <mutex>
 
-namespace time_kill::core {
-    enum class LogLevel {
-        TRACE,
-        DEBUG,
-        INFO,
-        WARN,
-        ERROR
-    };
+// Minimum log level compiled into the binary (0 = TRACE ... 4 = ERROR). Log calls below this level
+// are removed entirely, also for the crash log. Everything is kept by default; release builds strip
+// TRACE/DEBUG only with TIME_KILL_STRIP_DEBUG_LOGS (see src/CMakeLists.txt).
+#ifndef TIME_KILL_LOG_MIN_LEVEL
+#define TIME_KILL_LOG_MIN_LEVEL 0
+#endif
 
-    enum class DateFormat {
-        DD_MM_YYYY,
-        MM_DD_YYYY,
-        YYYY_MM_DD
-    };
-
-    enum class DateSeparator {
-        Hyphen,
-        Period,
-        Slash
-    };
+namespace time_kill::core {
+    constexpr auto CompileTimeMinLogLevel = static_cast<LogLevel>(TIME_KILL_LOG_MIN_LEVEL);
 
     class Logger {
     public:
@@ -33,17 +28,39 @@ namespace time_kill::core {
         // Access via singleton
         static Logger& getInstance();
 
-        // Initialize logging
+        // Initialize logging: adds (or replaces) the file sink next to the default console sink
         void init(const String& logFilePath, bool debugLoggingEnabled = false);
 
+        // Sinks. Every record goes to each sink whose level it reaches; the list is copied on change,
+        // so logging threads never wait for a sink to be added or removed.
+        void addSink(SharedPtr<LogSink> sink);
+        void removeSink(const SharedPtr<LogSink>& sink);
+        void setSinkLevel(const SharedPtr<LogSink>& sink, LogLevel level);
+        [[nodiscard]] const SharedPtr<ConsoleLogSink>& getConsoleSink() const { return consoleSink_; }
+
         // Logging methods
-        void log(LogLevel level, const String& message);
+        void log(LogLevel level, StringView message);
+
+        // Used by the formatted log_* overloads: `message` is the formatted text, `format` and
+        // `packedArgs` its source for the binary sink (packedArgs is null if needsPackedArgs() is false).
+        void log(LogLevel level, StringView message, StringView format, const binlog::BinaryLogArgs* packedArgs);
         void trace(const String& message);
         void debug(const String& message);
         void info(const String& message);
         void warn(const String& message);
         void error(const String& message);
 
+        // Cheap runtime level check, usable before any message is built: the level must be enabled
+        // and accepted by at least one sink, or be kept by the crash log
+        [[nodiscard]] static bool isLevelEnabled(const LogLevel level) {
+            return ((sinkLevelMask() | crashLevels_.load(std::memory_order_relaxed)) & levelBit(level)) != 0;
+        }
+
+        // Whether a registered sink stores format arguments (see LogSink::usesPackedArgs)
+        [[nodiscard]] bool needsPackedArgs() const {
+            return needsPackedArgs_.load(std::memory_order_relaxed);
+        }
+
         // Debug logging
         void setDebugEnabled(bool enabled);
         [[nodiscard]] bool isDebugEnabled() const;
@@ -52,6 +69,36 @@ namespace time_kill::core {
         void setTraceEnabled(bool enabled);
         [[nodiscard]] bool isTraceEnabled() const;
 
+        // Asynchronous mode: records are queued per thread and written by a background thread.
+        // Must not be toggled while other threads are logging.
+        void enableAsync(const AsyncLogConfig& config = {});
+        void disableAsync();
+        [[nodiscard]] bool isAsyncEnabled() const;
+        [[nodiscard]] AsyncLogStats getAsyncStats() const;
+
+        // Blocks until all pending records have been written and the outputs are flushed
+        void flush();
+
+        // Binary log: compact records in a memory-mapped, rotating file (decode with time_kill_logdump).
+        // Must not be toggled while other threads are logging.
+        void enableBinaryLog(const String& path, const BinaryLogConfig& config = {});
+        void disableBinaryLog();
+        [[nodiscard]] bool isBinaryLogEnabled() const;
+
+        // Crash log: keeps the last records in memory, including TRACE and DEBUG records disabled at
+        // runtime, and writes them out only on a crash or when dumpCrashLog is called. Records below
+        // the compile-time minimum level (TIME_KILL_LOG_MIN_LEVEL) are not compiled in and never reach it.
+        // Must not be toggled while other threads are logging.
+        void enableCrashLog(const CrashLogConfig& config = {});
+        void disableCrashLog();
+        [[nodiscard]] bool isCrashLogEnabled() const;
+
+        // Appends the crash log to `path` (the configured dump path if empty); false if it is not enabled
+        // or the file could not be written
+        bool dumpCrashLog(StringView reason, const String& path = {}) const;
+
+        static String levelToString(LogLevel level);
+
         // Dateformat
         void setDateFormat(DateFormat format);
         void setDateFormat(DateFormat format, DateSeparator separator);
@@ -62,21 +109,61 @@ namespace time_kill::core {
         [[nodiscard]] DateSeparator getDateSeparator() const;
 
     private:
-        Logger() = default; // Prevent instance creation
-        ~Logger() = default;
+        using LogSinkList = Vector<SharedPtr<LogSink>>;
 
+        Logger(); // Prevent instance creation
+        ~Logger();
 
+        // Writer thread callbacks
+        void writeBatch(std::span<const LogRecord> records);
+        void flushOutputs();
 
         // Auxiliary methods
-        [[nodiscard]] String getTimestamp() const;
-        static String levelToString(LogLevel level);
+        [[nodiscard]] String getTimestamp(std::chrono::system_clock::time_point time) const;
+        void dispatch(const LogEntry& entry);
+        void publishSinks(SharedPtr<const LogSinkList> sinks);
 
-        std::ofstream logFile_;
-        std::mutex logMutex_;
-        bool debugLoggingEnabled_ = false;
-        bool traceLoggingEnabled_ = false;
-        DateFormat dateFormat_ = DateFormat::DD_MM_YYYY;
-        DateSeparator dateSeparator_ = DateSeparator::Hyphen;
+        static constexpr u32 levelBit(const LogLevel level) {
+            return 1u << static_cast<u32>(level);
+        }
+
+        // Bits of `level` and every level above it
+        static constexpr u32 levelsFrom(const LogLevel level) {
+            return ~(levelBit(level) - 1) & ((levelBit(LogLevel::ERROR) << 1) - 1);
+        }
+        static void setLevelEnabled(LogLevel level, bool enabled);
+
+        // Levels that reach the regular sinks
+        static u32 sinkLevelMask() {
+            return enabledLevels_.load(std::memory_order_relaxed) & sinkLevels_.load(std::memory_order_relaxed);
+        }
+
+        // Bit per LogLevel; DEBUG and TRACE are off until enabled explicitly
+        static inline std::atomic<u32> enabledLevels_ =
+            levelBit(LogLevel::INFO) | levelBit(LogLevel::WARN) | levelBit(LogLevel::ERROR);
+
+        // Union of the levels accepted by the registered sinks. Starts with every level, which is what
+        // the default console sink accepts, because the first log call may precede the Logger's creation.
+        static inline std::atomic<u32> sinkLevels_ = levelsFrom(LogLevel::TRACE);
+
+        // Levels kept by the crash log, independent of enabledLevels_
+        static inline std::atomic<u32> crashLevels_ = 0;
+
+        std::mutex sinksMutex_; // Serializes changes to the sink list, never taken while logging
+        std::atomic<SharedPtr<const LogSinkList>> sinks_;
+        std::atomic<bool> needsPackedArgs_ = false;
+        SharedPtr<ConsoleLogSink> consoleSink_;
+        SharedPtr<FileLogSink> fileSink_;
+        SharedPtr<BinaryLogSink> binaryLog_;
+        UniquePtr<CrashLogRing> crashLog_;
+        std::atomic<CrashLogRing*> crashRing_ = nullptr;
+
+        UniquePtr<AsyncLogWriter> asyncWriter_;
+        std::atomic<AsyncLogWriter*> activeAsyncWriter_ = nullptr;
+        Vector<LogEntry> batchEntries_;
+        Vector<LogEntry> sinkEntries_;
+        std::atomic<DateFormat> dateFormat_ = DateFormat::DD_MM_YYYY;
+        std::atomic<DateSeparator> dateSeparator_ = DateSeparator::Hyphen;
     };
 }
 
@@ -85,28 +172,135 @@ namespace time_kill {
         core::Logger::getInstance().init(logFilePath, true);
     }
 
-    inline void log_write(const core::LogLevel level, const String& message) {
+    inline void log_write(const core::LogLevel level, const StringView message) {
         core::Logger::getInstance().log(level, message);
     }
 
-    inline void log_trace(const String& message) {
-        core::Logger::getInstance().log(core::LogLevel::TRACE, message);
+    //! Defers an expensive log argument until the message is actually formatted:
+    //! `log_debug("Picked format: {}", log_lazy([&] { return mappings.getFormatDescription(format); }));`
+    //! The producer runs at most once per record; the binary sink and the text sinks share its value.
+    template<typename F>
+    struct LazyLogArg {
+        using Value = std::remove_cvref_t<std::invoke_result_t<const F&>>;
+
+        F producer;
+        mutable Optional<Value> value;
+
+        const Value& get() const {
+            if (!value) {
+                value.emplace(producer());
+            }
+            return *value;
+        }
+    };
+
+    template<typename F>
+    LazyLogArg<F> log_lazy(F producer) {
+        return { std::move(producer), std::nullopt };
     }
 
-    inline void log_debug(const String& message) {
-        core::Logger::getInstance().log(core::LogLevel::DEBUG, message);
+    namespace detail {
+        // Formatted messages longer than this are truncated
+        constexpr usize LogFormatBufferSize = 2048;
+
+        // The binary sink packs the produced value of a lazy argument, so it keeps its native type
+        template<typename T>
+        const T& resolveLogArg(const T& arg) {
+            return arg;
+        }
+
+        template<typename F>
+        const typename LazyLogArg<F>::Value& resolveLogArg(const LazyLogArg<F>& arg) {
+            return arg.get();
+        }
+
+        template<typename... Args>
+        void log_formatted(const core::LogLevel level, std::format_string<Args...> format, Args&&... args) {
+            auto& logger = core::Logger::getInstance();
+
+            // The binary sink stores the arguments themselves, not the formatted text
+            const core::binlog::BinaryLogArgs* packedArgs = nullptr;
+            if (logger.needsPackedArgs()) {
+                thread_local core::binlog::BinaryLogArgs binaryArgs;
+                binaryArgs.clear();
+                (binaryArgs.pack(resolveLogArg(args)), ...);
+                packedArgs = &binaryArgs;
+            }
+
+            thread_local char buffer[LogFormatBufferSize];
+            const auto result = std::format_to_n(buffer, LogFormatBufferSize, format, std::forward<Args>(args)...);
+            const auto length = std::min(static_cast<usize>(result.size), LogFormatBufferSize);
+            logger.log(level, StringView(buffer, length), format.get(), packedArgs);
+        }
+
+        template<core::LogLevel Level, typename... Args>
+        void log_at(std::format_string<Args...> format, Args&&... args) {
+            if constexpr (Level >= core::CompileTimeMinLogLevel) {
+                if (core::Logger::isLevelEnabled(Level)) {
+                    log_formatted(Level, format, std::forward<Args>(args)...);
+                }
+            }
+        }
     }
 
-    inline void log_info(const String& message) {
-        core::Logger::getInstance().log(core::LogLevel::INFO, message);
+    // Plain messages
+
+    inline void log_trace(const StringView message) {
+        if constexpr (core::LogLevel::TRACE >= core::CompileTimeMinLogLevel) {
+            core::Logger::getInstance().log(core::LogLevel::TRACE, message);
+        }
+    }
+
+    inline void log_debug(const StringView message) {
+        if constexpr (core::LogLevel::DEBUG >= core::CompileTimeMinLogLevel) {
+            core::Logger::getInstance().log(core::LogLevel::DEBUG, message);
+        }
+    }
+
+    inline void log_info(const StringView message) {
+        if constexpr (core::LogLevel::INFO >= core::CompileTimeMinLogLevel) {
+            core::Logger::getInstance().log(core::LogLevel::INFO, message);
+        }
     }
 
-    inline void log_warn(const String& message) {
-        core::Logger::getInstance().log(core::LogLevel::WARN, message);
+    inline void log_warn(const StringView message) {
+        if constexpr (core::LogLevel::WARN >= core::CompileTimeMinLogLevel) {
+            core::Logger::getInstance().log(core::LogLevel::WARN, message);
+        }
     }
 
-    inline void log_error(const String& message) {
-        core::Logger::getInstance().log(core::LogLevel::ERROR, message);
+    inline void log_error(const StringView message) {
+        if constexpr (core::LogLevel::ERROR >= core::CompileTimeMinLogLevel) {
+            core::Logger::getInstance().log(core::LogLevel::ERROR, message);
+        }
+    }
+
+    // Formatted messages: the level is checked before any argument is formatted, and the text is
+    // formatted into a thread-local buffer, so disabled levels cost one branch and no allocation.
+
+    template<typename Arg, typename... Args>
+    void log_trace(std::format_string<Arg, Args...> format, Arg&& arg, Args&&... args) {
+        detail::log_at<core::LogLevel::TRACE>(format, std::forward<Arg>(arg), std::forward<Args>(args)...);
+    }
+
+    template<typename Arg, typename... Args>
+    void log_debug(std::format_string<Arg, Args...> format, Arg&& arg, Args&&... args) {
+        detail::log_at<core::LogLevel::DEBUG>(format, std::forward<Arg>(arg), std::forward<Args>(args)...);
+    }
+
+    template<typename Arg, typename... Args>
+    void log_info(std::format_string<Arg, Args...> format, Arg&& arg, Args&&... args) {
+        detail::log_at<core::LogLevel::INFO>(format, std::forward<Arg>(arg), std::forward<Args>(args)...);
+    }
+
+    template<typename Arg, typename... Args>
+    void log_warn(std::format_string<Arg, Args...> format, Arg&& arg, Args&&... args) {
+        detail::log_at<core::LogLevel::WARN>(format, std::forward<Arg>(arg), std::forward<Args>(args)...);
+    }
+
+    template<typename Arg, typename... Args>
+    void log_error(std::format_string<Arg, Args...> format, Arg&& arg, Args&&... args) {
+        detail::log_at<core::LogLevel::ERROR>(format, std::forward<Arg>(arg), std::forward<Args>(args)...);
     }
 
     inline void log_enable_trace(const bool enabled) {
@@ -122,7 +316,7 @@ namespace time_kill {
     }
 
     inline void log_set_date_separator(const core::DateSeparator separator) {
-        core::Logger::getInstance().setDateSeparator(core::DateSeparator::Hyphen);
+        core::Logger::getInstance().setDateSeparator(separator);
     }
 
     inline bool log_is_debug_enabled() {
@@ -132,4 +326,46 @@ namespace time_kill {
     inline bool log_is_trace_enabled() {
         return core::Logger::getInstance().isTraceEnabled();
     }
+
+    inline void log_enable_async(const core::AsyncLogConfig& config = {}) {
+        core::Logger::getInstance().enableAsync(config);
+    }
+
+    inline void log_flush() {
+        core::Logger::getInstance().flush();
+    }
+
+    inline void log_enable_binary(const String& path, const core::BinaryLogConfig& config = {}) {
+        core::Logger::getInstance().enableBinaryLog(path, config);
+    }
+
+    inline void log_enable_crash_log(const core::CrashLogConfig& config = {}) {
+        core::Logger::getInstance().enableCrashLog(config);
+    }
+
+    inline bool log_dump_crash_log(const StringView reason, const String& path = {}) {
+        return core::Logger::getInstance().dumpCrashLog(reason, path);
+    }
+
+    inline void log_add_sink(SharedPtr<core::LogSink> sink) {
+        core::Logger::getInstance().addSink(std::move(sink));
+    }
+
+    inline void log_remove_sink(const SharedPtr<core::LogSink>& sink) {
+        core::Logger::getInstance().removeSink(sink);
+    }
+
+    inline void log_set_console_level(const core::LogLevel level) {
+        auto& logger = core::Logger::getInstance();
+        logger.setSinkLevel(logger.getConsoleSink(), level);
+    }
 }
+
+template<typename F>
+struct std::formatter<time_kill::LazyLogArg<F>, char>
+    : std::formatter<typename time_kill::LazyLogArg<F>::Value, char> {
+    template<typename FormatContext>
+    auto format(const time_kill::LazyLogArg<F>& arg, FormatContext& ctx) const {
+        return std::formatter<typename time_kill::LazyLogArg<F>::Value, char>::format(arg.get(), ctx);
+    }
+};
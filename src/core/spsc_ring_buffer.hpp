@@ -0,0 +1,82 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <atomic>
+#include <bit>
+
+namespace time_kill::core {
+    //! Bounded lock-free ring buffer for exactly one producer and one consumer thread.
+    //!
+    //! Slots are written and read in place (beginWrite/commitWrite, front/pop), so a record is never
+    //! copied more than once. The capacity is rounded up to the next power of two.
+    template<typename T>
+    class SpscRingBuffer {
+    public:
+        explicit SpscRingBuffer(const usize capacity)
+            : buffer_(std::bit_ceil(capacity < 2 ? usize{2} : capacity)),
+              mask_(buffer_.size() - 1) {}
+
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+        //=== Producer side
+
+        //! Returns the next free slot or nullptr if the buffer is full.
+        [[nodiscard]] T* beginWrite() {
+            const usize tail = tail_.load(std::memory_order_relaxed);
+            if (tail - cachedHead_ == buffer_.size()) {
+                cachedHead_ = head_.load(std::memory_order_acquire);
+                if (tail - cachedHead_ == buffer_.size()) {
+                    return nullptr;
+                }
+            }
+            return &buffer_[tail & mask_];
+        }
+
+        //! Publishes the slot returned by the last beginWrite() call to the consumer.
+        void commitWrite() {
+            tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        //=== Consumer side
+
+        //! Returns the oldest unread slot or nullptr if the buffer is empty.
+        [[nodiscard]] const T* front() {
+            const usize head = head_.load(std::memory_order_relaxed);
+            if (head == cachedTail_) {
+                cachedTail_ = tail_.load(std::memory_order_acquire);
+                if (head == cachedTail_) {
+                    return nullptr;
+                }
+            }
+            return &buffer_[head & mask_];
+        }
+
+        //! Releases the slot returned by front() back to the producer.
+        void pop() {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        //=== Either side
+
+        [[nodiscard]] usize size() const {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] usize capacity() const {
+            return buffer_.size();
+        }
+
+    private:
+        static constexpr usize CacheLineSize = 64;
+
+        Vector<T> buffer_;
+        const usize mask_;
+
+        alignas(CacheLineSize) std::atomic<usize> head_ = 0; // Written by the consumer
+        usize cachedTail_ = 0;                               // Consumer-local copy of tail_
+
+        alignas(CacheLineSize) std::atomic<usize> tail_ = 0; // Written by the producer
+        usize cachedHead_ = 0;                               // Producer-local copy of head_
+    };
+}
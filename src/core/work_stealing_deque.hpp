@@ -0,0 +1,94 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <atomic>
+#include <bit>
+
+namespace time_kill::core {
+    //! Bounded Chase-Lev work-stealing deque of pointers.
+    //!
+    //! The owning thread pushes and pops at the bottom (LIFO, cache-warm); any other thread steals
+    //! from the top (FIFO, oldest and usually largest work first). Only push/pop may be called by the
+    //! owner; steal may be called by any thread. The capacity is rounded up to the next power of two.
+    template<typename T>
+    class WorkStealingDeque {
+    public:
+        explicit WorkStealingDeque(const usize capacity)
+            : capacity_(std::bit_ceil(capacity < 2 ? usize{2} : capacity)),
+              mask_(capacity_ - 1),
+              buffer_(createUniquePtr<std::atomic<T*>[]>(capacity_)) {}
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        //! Owner only. Returns false if the deque is full.
+        bool push(T* item) {
+            const i64 bottom = bottom_.load(std::memory_order_relaxed);
+            const i64 top = top_.load(std::memory_order_acquire);
+            if (bottom - top >= static_cast<i64>(capacity_)) {
+                return false;
+            }
+
+            buffer_[static_cast<usize>(bottom) & mask_].store(item, std::memory_order_relaxed);
+            // Publishes the item (and everything written to it before) to thieves that acquire bottom
+            bottom_.store(bottom + 1, std::memory_order_release);
+            return true;
+        }
+
+        //! Owner only. Returns the most recently pushed item or nullptr if the deque is empty.
+        T* pop() {
+            const i64 bottom = bottom_.load(std::memory_order_relaxed) - 1;
+            bottom_.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            i64 top = top_.load(std::memory_order_relaxed);
+
+            if (top > bottom) {
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T* item = buffer_[static_cast<usize>(bottom) & mask_].load(std::memory_order_relaxed);
+            if (top == bottom) {
+                // Last item: race the thieves for it
+                if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        //! Any thread. Returns the oldest item, or nullptr if the deque is empty or another thread won the race.
+        T* steal() {
+            i64 top = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const i64 bottom = bottom_.load(std::memory_order_acquire);
+
+            if (top >= bottom) {
+                return nullptr;
+            }
+
+            T* item = buffer_[static_cast<usize>(top) & mask_].load(std::memory_order_relaxed);
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+        //! Approximate when called concurrently with push/pop/steal.
+        [[nodiscard]] bool empty() const {
+            return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] usize capacity() const { return capacity_; }
+
+    private:
+        const usize capacity_;
+        const usize mask_;
+        UniquePtr<std::atomic<T*>[]> buffer_;
+
+        // Thieves contend on top, the owner works on bottom; keep them on separate cache lines
+        alignas(64) std::atomic<i64> top_ = 0;
+        alignas(64) std::atomic<i64> bottom_ = 0;
+    };
+}
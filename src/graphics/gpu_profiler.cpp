@@ -0,0 +1,312 @@
+#include "gpu_profiler.hpp"
+#include "core/logger.hpp"
+#include <algorithm>
+
+namespace time_kill::graphics {
+    namespace {
+        //! Counters collected per top-level scope; results come in the order of the bits.
+        constexpr VkQueryPipelineStatisticFlags StatisticFlags =
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+        constexpr uint32_t StatisticCount = 5;
+    }
+
+    GpuProfiler::GpuProfiler(VulkanResources& resources)
+        : resources_(resources) {}
+
+    GpuProfiler::~GpuProfiler() {
+        destroyProfiler();
+    }
+
+    void GpuProfiler::createProfiler(const uint32_t frameSlots, const uint32_t maxScopes, const bool pipelineStatistics) {
+        const auto& res = resources_;
+        if (res.logicalDevice == VK_NULL_HANDLE) {
+            throw std::runtime_error("Unable to create GPU profiler; logical device is null!");
+        }
+        if (frameSlots == 0 || maxScopes == 0) {
+            throw std::runtime_error("Unable to create GPU profiler; frame slots and scopes are required!");
+        }
+
+        destroyProfiler();
+        if (res.timestampValidBits == 0) {
+            log_warn("GPU profiling is unavailable; the graphics queue does not support timestamps.");
+            return;
+        }
+
+        timestampMask_ = res.timestampValidBits >= 64 ? ~0ull : (1ull << res.timestampValidBits) - 1;
+        maxScopes_ = maxScopes;
+        slots_.resize(frameSlots);
+
+        VkQueryPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = timestampBase(frameSlots);
+        if (vkCreateQueryPool(res.logicalDevice, &poolInfo, nullptr, &timestampPool_) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create timestamp query pool!");
+        }
+
+        if (pipelineStatistics && res.pipelineStatisticsSupported) {
+            poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            poolInfo.queryCount = statisticsBase(frameSlots);
+            poolInfo.pipelineStatistics = StatisticFlags;
+            if (vkCreateQueryPool(res.logicalDevice, &poolInfo, nullptr, &statisticsPool_) != VK_SUCCESS) {
+                destroyProfiler();
+                throw std::runtime_error("Failed to create pipeline statistics query pool!");
+            }
+        } else if (pipelineStatistics) {
+            log_debug("Pipeline statistics queries are not supported; profiling timestamps only.");
+        }
+
+        log_debug("Created GPU profiler for {} frames with {} scopes each{}.", frameSlots, maxScopes,
+                  isPipelineStatisticsEnabled() ? " and pipeline statistics" : "");
+    }
+
+    void GpuProfiler::destroyProfiler() {
+        if (timestampPool_ == VK_NULL_HANDLE && statisticsPool_ == VK_NULL_HANDLE) {
+            return;
+        }
+
+        // Frames in flight may still write their queries
+        vkDeviceWaitIdle(resources_.logicalDevice);
+
+        if (statisticsPool_ != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(resources_.logicalDevice, statisticsPool_, nullptr);
+            statisticsPool_ = VK_NULL_HANDLE;
+        }
+        if (timestampPool_ != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(resources_.logicalDevice, timestampPool_, nullptr);
+            timestampPool_ = VK_NULL_HANDLE;
+        }
+        slots_.clear();
+        currentSlot_.reset();
+        hasLatest_ = false;
+        droppedWarned_ = false;
+    }
+
+    void GpuProfiler::beginFrame(const FrameContext& frame) {
+        if (!isEnabled()) {
+            return;
+        }
+        if (frame.frameIndex >= slots_.size()) {
+            throw std::runtime_error("GPU profiler has fewer frame slots than the renderer has frames in flight!");
+        }
+
+        // The renderer has waited for the frame this slot held before, so its results are there
+        const uint32_t index = frame.frameIndex;
+        Slot& slot = slots_[index];
+        if (slot.frameNumber && !resolve(index)) {
+            log_warn("GPU profiler results of frame {} are not available; dropping them.", *slot.frameNumber);
+        }
+
+        const VkCommandBuffer commandBuffer = frame.commandBuffer;
+        vkCmdResetQueryPool(commandBuffer, timestampPool_, timestampBase(index), 2 + 2 * maxScopes_);
+        if (isPipelineStatisticsEnabled()) {
+            vkCmdResetQueryPool(commandBuffer, statisticsPool_, statisticsBase(index), maxScopes_);
+        }
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool_, timestampBase(index));
+
+        slot.scopeCount = 0;
+        slot.statisticsCount = 0;
+        slot.droppedScopes = 0;
+        slot.openScopes.clear();
+        slot.frameNumber = frame.frameNumber;
+        slot.ended = false;
+        currentSlot_ = index;
+    }
+
+    void GpuProfiler::endFrame(const FrameContext& frame) {
+        if (!currentSlot_) {
+            return;
+        }
+        if (*currentSlot_ != frame.frameIndex) {
+            throw std::runtime_error("GpuProfiler::endFrame called for a frame that was not begun!");
+        }
+
+        // Unended queries would never become available
+        Slot& slot = slots_[*currentSlot_];
+        while (!slot.openScopes.empty()) {
+            if (const uint32_t scope = slot.openScopes.back(); scope != DroppedScope) {
+                log_warn("GPU profiler scope '{}' was not ended.", slot.scopes[scope].name);
+            }
+            endScope(frame.commandBuffer);
+        }
+
+        vkCmdWriteTimestamp(frame.commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool_,
+                            timestampBase(*currentSlot_) + 1);
+        slot.ended = true;
+        currentSlot_.reset();
+    }
+
+    void GpuProfiler::beginScope(const VkCommandBuffer commandBuffer, const StringView name, const bool statistics) {
+        if (!currentSlot_) {
+            return;
+        }
+
+        Slot& slot = slots_[*currentSlot_];
+        if (slot.scopeCount == maxScopes_) {
+            if (!droppedWarned_) {
+                log_warn("GPU profiler ran out of queries; scopes beyond {} per frame are not measured.", maxScopes_);
+                droppedWarned_ = true;
+            }
+            ++slot.droppedScopes;
+            slot.openScopes.push_back(DroppedScope);
+            return;
+        }
+
+        const uint32_t index = slot.scopeCount++;
+        if (slot.scopes.size() < slot.scopeCount) {
+            slot.scopes.emplace_back();
+        }
+        ScopeRecord& scope = slot.scopes[index];
+        scope.name.assign(name);
+        scope.parent = slot.openScopes.empty() ? GpuScopeResult::NoParent : slot.openScopes.back();
+        scope.depth = static_cast<uint32_t>(slot.openScopes.size());
+        scope.statisticsQuery.reset();
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool_,
+                            timestampBase(*currentSlot_) + 2 + 2 * index);
+        if (statistics && isPipelineStatisticsEnabled() && scope.depth == 0) {
+            scope.statisticsQuery = slot.statisticsCount++;
+            vkCmdBeginQuery(commandBuffer, statisticsPool_, statisticsBase(*currentSlot_) + *scope.statisticsQuery, 0);
+        }
+        slot.openScopes.push_back(index);
+    }
+
+    void GpuProfiler::endScope(const VkCommandBuffer commandBuffer) {
+        if (!currentSlot_) {
+            return;
+        }
+
+        Slot& slot = slots_[*currentSlot_];
+        if (slot.openScopes.empty()) {
+            log_warn("GpuProfiler::endScope called without an open scope.");
+            return;
+        }
+        const uint32_t index = slot.openScopes.back();
+        slot.openScopes.pop_back();
+        if (index == DroppedScope) {
+            return;
+        }
+
+        const ScopeRecord& scope = slot.scopes[index];
+        if (scope.statisticsQuery) {
+            vkCmdEndQuery(commandBuffer, statisticsPool_, statisticsBase(*currentSlot_) + *scope.statisticsQuery);
+        }
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool_,
+                            timestampBase(*currentSlot_) + 3 + 2 * index);
+    }
+
+    void GpuProfiler::resolvePending() {
+        Vector<uint32_t> pending;
+        for (uint32_t index = 0; index < slots_.size(); ++index) {
+            // The frame being recorded has not been submitted yet
+            if (slots_[index].frameNumber && currentSlot_ != index) {
+                pending.push_back(index);
+            }
+        }
+        std::ranges::sort(pending, {}, [&](const uint32_t index) { return *slots_[index].frameNumber; });
+
+        for (const uint32_t index : pending) {
+            if (!resolve(index)) {
+                break;
+            }
+        }
+    }
+
+    bool GpuProfiler::resolve(const uint32_t index) {
+        Slot& slot = slots_[index];
+        if (!slot.ended) {
+            log_warn("GPU profiler frame {} was not ended; dropping its results.", *slot.frameNumber);
+            slot.frameNumber.reset();
+            return true;
+        }
+
+        const VkDevice device = resources_.logicalDevice;
+        const uint32_t timestampCount = 2 + 2 * slot.scopeCount;
+        timestamps_.resize(timestampCount);
+        VkResult result = vkGetQueryPoolResults(device, timestampPool_, timestampBase(index), timestampCount,
+                                                timestamps_.size() * sizeof(u64), timestamps_.data(), sizeof(u64),
+                                                VK_QUERY_RESULT_64_BIT);
+        if (result == VK_NOT_READY) {
+            return false;
+        }
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to read GPU timestamp queries!");
+        }
+
+        if (slot.statisticsCount > 0) {
+            statistics_.resize(usize(slot.statisticsCount) * StatisticCount);
+            result = vkGetQueryPoolResults(device, statisticsPool_, statisticsBase(index), slot.statisticsCount,
+                                           statistics_.size() * sizeof(u64), statistics_.data(),
+                                           StatisticCount * sizeof(u64), VK_QUERY_RESULT_64_BIT);
+            if (result == VK_NOT_READY) {
+                return false;
+            }
+            if (result != VK_SUCCESS) {
+                throw std::runtime_error("Failed to read pipeline statistics queries!");
+            }
+        }
+
+        // Timestamps wrap around at timestampValidBits
+        const auto elapsed = [&](const usize begin) {
+            return toMilliseconds((timestamps_[begin + 1] - timestamps_[begin]) & timestampMask_);
+        };
+
+        latest_.frameNumber = *slot.frameNumber;
+        latest_.frameMilliseconds = elapsed(0);
+        latest_.droppedScopes = slot.droppedScopes;
+        latest_.scopes.resize(slot.scopeCount);
+        for (uint32_t i = 0; i < slot.scopeCount; ++i) {
+            const ScopeRecord& record = slot.scopes[i];
+            GpuScopeResult& scope = latest_.scopes[i];
+            scope.name = record.name;
+            scope.parent = record.parent;
+            scope.depth = record.depth;
+            scope.milliseconds = elapsed(2 + 2 * usize(i));
+            scope.statistics.reset();
+            if (record.statisticsQuery) {
+                const u64* values = statistics_.data() + usize(*record.statisticsQuery) * StatisticCount;
+                scope.statistics = GpuPipelineStatistics {
+                    values[0], values[1], values[2], values[3], values[4]
+                };
+            }
+        }
+        hasLatest_ = true;
+        slot.frameNumber.reset();
+
+        if (callback_) {
+            callback_(latest_);
+        }
+        return true;
+    }
+
+    void GpuProfiler::logLatestProfile() const {
+        if (!hasLatest_) {
+            return;
+        }
+
+        log_info("GPU frame {}: {:.3f} ms", latest_.frameNumber, latest_.frameMilliseconds);
+        for (const auto& scope : latest_.scopes) {
+            const String indent(2 * (scope.depth + 1), ' ');
+            if (scope.statistics) {
+                const auto& statistics = *scope.statistics;
+                log_info("{}{}: {:.3f} ms ({} primitives, {} vertex / {} fragment invocations, {} -> {} clipped)",
+                         indent, scope.name, scope.milliseconds, statistics.inputAssemblyPrimitives,
+                         statistics.vertexShaderInvocations, statistics.fragmentShaderInvocations,
+                         statistics.clippingInvocations, statistics.clippingPrimitives);
+            } else {
+                log_info("{}{}: {:.3f} ms", indent, scope.name, scope.milliseconds);
+            }
+        }
+        if (latest_.droppedScopes > 0) {
+            log_info("  ({} scopes not measured)", latest_.droppedScopes);
+        }
+    }
+
+    f64 GpuProfiler::toMilliseconds(const u64 ticks) const {
+        return static_cast<f64>(ticks) * resources_.timestampPeriod / 1e6;
+    }
+}
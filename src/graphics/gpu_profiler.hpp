@@ -0,0 +1,160 @@
+#pragma once
+
+#include "graphics/vulkan_resources.hpp"
+#include "graphics/vulkan_renderer.hpp"
+#include <functional>
+
+namespace time_kill::graphics {
+    //! Pipeline statistics of a top-level scope (VK_QUERY_TYPE_PIPELINE_STATISTICS).
+    struct GpuPipelineStatistics {
+        u64 inputAssemblyPrimitives = 0;
+        u64 vertexShaderInvocations = 0;
+        u64 clippingInvocations = 0;     //!< Primitives that reached the clipping stage
+        u64 clippingPrimitives = 0;      //!< Primitives that came out of it
+        u64 fragmentShaderInvocations = 0;
+    };
+
+    //! A named scope of a profiled frame.
+    struct GpuScopeResult {
+        static constexpr uint32_t NoParent = ~0u;
+
+        String name;
+        uint32_t parent = NoParent;      //!< Index of the enclosing scope in GpuFrameProfile::scopes
+        uint32_t depth = 0;              //!< 0 for top-level scopes
+        f64 milliseconds = 0.0;
+        Optional<GpuPipelineStatistics> statistics; //!< Top-level scopes, if pipeline statistics are enabled
+    };
+
+    //! GPU times of one frame, in the order the scopes were begun.
+    struct GpuFrameProfile {
+        u64 frameNumber = 0;
+        f64 frameMilliseconds = 0.0;     //!< From GpuProfiler::beginFrame to GpuProfiler::endFrame
+        Vector<GpuScopeResult> scopes;
+        uint32_t droppedScopes = 0;      //!< Scopes beyond the query capacity, not measured
+    };
+
+    //! Measures where GPU time goes with timestamp queries, and optionally counts vertex and fragment
+    //! work with pipeline-statistics queries.
+    //!
+    //! Every frame-in-flight slot owns its own range of queries. beginFrame resets the slot's queries
+    //! in the frame's command buffer, but first reads back the results of the frame the slot held
+    //! before: beginFrame of the renderer has waited for that frame's fence, so vkGetQueryPoolResults
+    //! returns without waiting and nothing stalls. Results reach the app through the profile callback
+    //! and getLatestProfile, framesInFlight frames after they were recorded.
+    //!
+    //! Scopes nest. They must be recorded into the frame's primary command buffer, from the thread
+    //! that drives the frame loop, and begin and end on the same side of a render pass. Pipeline
+    //! statistics queries cannot be nested, so only top-level scopes collect them; they need the
+    //! pipelineStatisticsQuery device feature. Without timestamp support on the graphics queue the
+    //! profiler records nothing.
+    class GpuProfiler {
+    public:
+        //! Called with every frame read back, from beginFrame or resolvePending.
+        using ProfileCallback = std::function<void(const GpuFrameProfile& profile)>;
+
+        //! Ends the scope it began when it goes out of scope.
+        class Scope {
+        public:
+            Scope(GpuProfiler& profiler, const VkCommandBuffer commandBuffer, const StringView name,
+                  const bool statistics = true)
+                : profiler_(profiler), commandBuffer_(commandBuffer) {
+                profiler_.beginScope(commandBuffer_, name, statistics);
+            }
+
+            ~Scope() { profiler_.endScope(commandBuffer_); }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            GpuProfiler& profiler_;
+            VkCommandBuffer commandBuffer_;
+        };
+
+        explicit GpuProfiler(VulkanResources& resources);
+        ~GpuProfiler();
+
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+        //! Creates the query pools for `frameSlots` frames in flight (VulkanRenderer::getFramesInFlight)
+        //! with room for `maxScopes` scopes per frame. Pipeline statistics are collected if asked for
+        //! and supported by the device.
+        void createProfiler(uint32_t frameSlots, uint32_t maxScopes = 64, bool pipelineStatistics = true);
+
+        //! Waits for the device and destroys the query pools; unread results are lost.
+        void destroyProfiler();
+
+        //! Call right after VulkanRenderer::beginFrame, before the render pass: reads back the slot's
+        //! previous frame and starts measuring `frame`.
+        void beginFrame(const FrameContext& frame);
+
+        //! Call after the last scope, outside a render pass and before VulkanRenderer::endFrame.
+        void endFrame(const FrameContext& frame);
+
+        //! Opens a scope nested in the innermost open one. Past `maxScopes`, scopes are dropped.
+        //! Pass `statistics` false for a top-level scope that executes secondary command buffers:
+        //! without the inheritedQueries feature no query may be active around vkCmdExecuteCommands.
+        void beginScope(VkCommandBuffer commandBuffer, StringView name, bool statistics = true);
+        void endScope(VkCommandBuffer commandBuffer);
+
+        //! Reads back every frame whose results are available, oldest first, without waiting. After
+        //! VulkanContext::queuesWaitIdle this collects the frames still in flight.
+        void resolvePending();
+
+        void setProfileCallback(ProfileCallback callback) { callback_ = std::move(callback); }
+
+        //! The most recent frame read back, or null if there is none yet.
+        [[nodiscard]] const GpuFrameProfile* getLatestProfile() const { return hasLatest_ ? &latest_ : nullptr; }
+
+        //! Writes the latest profile to the log, one line per scope, indented by depth.
+        void logLatestProfile() const;
+
+        [[nodiscard]] bool isEnabled() const { return timestampPool_ != VK_NULL_HANDLE; }
+        [[nodiscard]] bool isPipelineStatisticsEnabled() const { return statisticsPool_ != VK_NULL_HANDLE; }
+
+        //! Converts a difference of two timestamps to milliseconds.
+        [[nodiscard]] f64 toMilliseconds(u64 ticks) const;
+
+    private:
+        struct ScopeRecord {
+            String name;
+            uint32_t parent = GpuScopeResult::NoParent;
+            uint32_t depth = 0;
+            Optional<uint32_t> statisticsQuery;
+        };
+
+        struct Slot {
+            Vector<ScopeRecord> scopes;       // Reused across frames
+            uint32_t scopeCount = 0;          // Scopes recorded in this frame
+            uint32_t statisticsCount = 0;     // Pipeline statistics queries recorded in this frame
+            uint32_t droppedScopes = 0;
+            Vector<uint32_t> openScopes;      // Stack of scope indices; dropped scopes push DroppedScope
+            Optional<u64> frameNumber;        // Frame recorded and not read back yet
+            bool ended = false;               // endFrame wrote the frame's end timestamp
+        };
+
+        static constexpr uint32_t DroppedScope = ~0u;
+
+        //! Queries of a slot: the frame's begin and end timestamps, then a pair per scope.
+        [[nodiscard]] uint32_t timestampBase(uint32_t slot) const { return slot * (2 + 2 * maxScopes_); }
+        [[nodiscard]] uint32_t statisticsBase(uint32_t slot) const { return slot * maxScopes_; }
+
+        //! Reads the results of `slot` into latest_; returns false if they are not available yet.
+        bool resolve(uint32_t slot);
+
+        VulkanResources& resources_;
+        VkQueryPool timestampPool_ = VK_NULL_HANDLE;
+        VkQueryPool statisticsPool_ = VK_NULL_HANDLE;
+        uint32_t maxScopes_ = 0;
+        u64 timestampMask_ = 0;
+        Vector<Slot> slots_;
+        Optional<uint32_t> currentSlot_;      // Slot of the frame being recorded
+        Vector<u64> timestamps_;              // Read-back scratch
+        Vector<u64> statistics_;
+        GpuFrameProfile latest_;
+        bool hasLatest_ = false;
+        bool droppedWarned_ = false;
+        ProfileCallback callback_;
+    };
+}
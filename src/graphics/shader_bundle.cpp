@@ -0,0 +1,122 @@
+#include "shader_bundle.hpp"
+#include "shader_bundle_format.hpp"
+#include "core/logger.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace time_kill::graphics {
+    namespace {
+        const shaderbundle::FileHeader& header(const utils::MemoryMappedFile& file) {
+            return *reinterpret_cast<const shaderbundle::FileHeader*>(file.data());
+        }
+
+        const shaderbundle::Entry* entries(const utils::MemoryMappedFile& file) {
+            return reinterpret_cast<const shaderbundle::Entry*>(file.data() + sizeof(shaderbundle::FileHeader));
+        }
+
+        StringView entryName(const utils::MemoryMappedFile& file, const shaderbundle::Entry& entry) {
+            return { reinterpret_cast<const char*>(file.data() + entry.nameOffset), entry.nameLength };
+        }
+
+        bool inBounds(const u64 offset, const u64 size, const u64 fileSize) {
+            return offset <= fileSize && size <= fileSize - offset;
+        }
+    }
+
+    void ShaderBundle::open(const String& path) {
+        close();
+        file_.openReadOnly(path);
+
+        const auto fail = [&](const StringView reason) {
+            file_.close();
+            throw std::runtime_error("Invalid shader bundle '" + path + "': " + String(reason));
+        };
+
+        const u64 fileSize = file_.size();
+        if (fileSize < sizeof(shaderbundle::FileHeader)) {
+            fail("file is truncated");
+        }
+        const auto& fileHeader = header(file_);
+        if (fileHeader.magic != shaderbundle::Magic || fileHeader.version != shaderbundle::Version ||
+            fileHeader.headerSize != sizeof(shaderbundle::FileHeader) || fileHeader.entrySize != sizeof(shaderbundle::Entry)) {
+            fail("unknown format or version");
+        }
+        if (fileHeader.fileSize != fileSize) {
+            fail("size mismatch");
+        }
+        if (!inBounds(sizeof(shaderbundle::FileHeader), u64(fileHeader.entryCount) * sizeof(shaderbundle::Entry), fileSize)) {
+            fail("table of contents is truncated");
+        }
+
+        // Validate every entry once, so lookups can trust the table
+        StringView previousName;
+        for (u32 i = 0; i < fileHeader.entryCount; ++i) {
+            const auto& entry = entries(file_)[i];
+            if (!inBounds(entry.nameOffset, entry.nameLength, fileSize) ||
+                !inBounds(entry.reflectionOffset, entry.reflectionSize, fileSize) ||
+                !inBounds(entry.codeOffset, entry.codeSize, fileSize) ||
+                entry.codeOffset % shaderbundle::BlobAlignment != 0 || entry.codeSize % sizeof(u32) != 0) {
+                fail("entry " + std::to_string(i) + " is out of bounds");
+            }
+
+            const StringView name = entryName(file_, entry);
+            if (i > 0 && name <= previousName) {
+                fail("table of contents is not sorted");
+            }
+            previousName = name;
+        }
+
+        log_debug("Opened shader bundle '{}' with {} shaders.", path, fileHeader.entryCount);
+    }
+
+    void ShaderBundle::close() {
+        file_.close();
+    }
+
+    Optional<ShaderBundleEntry> ShaderBundle::find(const StringView name) const {
+        if (!isOpen()) {
+            return std::nullopt;
+        }
+
+        const auto* begin = entries(file_);
+        const auto* end = begin + header(file_).entryCount;
+        const auto* it = std::lower_bound(begin, end, name, [this](const shaderbundle::Entry& entry, const StringView value) {
+            return entryName(file_, entry) < value;
+        });
+        if (it == end || entryName(file_, *it) != name) {
+            return std::nullopt;
+        }
+        return makeEntry(static_cast<usize>(it - begin));
+    }
+
+    Vector<String> ShaderBundle::getNames() const {
+        Vector<String> names;
+        if (isOpen()) {
+            names.reserve(getShaderCount());
+            for (usize i = 0; i < getShaderCount(); ++i) {
+                names.emplace_back(entryName(file_, entries(file_)[i]));
+            }
+        }
+        return names;
+    }
+
+    usize ShaderBundle::getShaderCount() const {
+        return isOpen() ? header(file_).entryCount : 0;
+    }
+
+    u64 ShaderBundle::getContentHash() const {
+        return isOpen() ? header(file_).contentHash : 0;
+    }
+
+    ShaderBundleEntry ShaderBundle::makeEntry(const usize index) const {
+        const auto& entry = entries(file_)[index];
+
+        ShaderBundleEntry result;
+        result.name = entryName(file_, entry);
+        result.stage = static_cast<VkShaderStageFlagBits>(entry.stage);
+        result.code = { reinterpret_cast<const u32*>(file_.data() + entry.codeOffset), entry.codeSize / sizeof(u32) };
+        result.contentHash = entry.contentHash;
+        result.reflection = { reinterpret_cast<const u8*>(file_.data() + entry.reflectionOffset), entry.reflectionSize };
+        return result;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include "utils/memory_mapped_file.hpp"
+#include <span>
+#include <vulkan/vulkan.h>
+
+namespace time_kill::graphics {
+    //! A shader stored in a ShaderBundle. The spans point into the mapped bundle and stay valid
+    //! until the bundle is closed.
+    struct ShaderBundleEntry {
+        StringView name;
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+        std::span<const u32> code;
+        u64 contentHash = 0;
+        std::span<const u8> reflection;     //!< Serialized ShaderReflection, computed at pack time
+    };
+
+    //! Read-only view of a packed shader bundle (see shader_bundle_format.hpp), created at build time
+    //! by the shaderpack tool. The file is memory-mapped; SPIR-V code is used in place.
+    class ShaderBundle {
+    public:
+        ShaderBundle() = default;
+
+        //! Maps and validates `path`. Throws if it cannot be read or is not a valid bundle.
+        void open(const String& path);
+        void close();
+
+        [[nodiscard]] bool isOpen() const { return file_.isOpen(); }
+        [[nodiscard]] const String& getPath() const { return file_.path(); }
+
+        //! Looks a shader up by its name relative to the shader directory (e.g. "basic.vert.spv").
+        [[nodiscard]] Optional<ShaderBundleEntry> find(StringView name) const;
+
+        //! Names of all shaders, sorted.
+        [[nodiscard]] Vector<String> getNames() const;
+        [[nodiscard]] usize getShaderCount() const;
+        [[nodiscard]] u64 getContentHash() const;
+
+    private:
+        [[nodiscard]] ShaderBundleEntry makeEntry(usize index) const;
+
+        utils::MemoryMappedFile file_;
+    };
+}
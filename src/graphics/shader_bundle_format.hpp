@@ -0,0 +1,45 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <array>
+
+//! On-disk layout of shader bundles, shared by ShaderBundle (reader) and the shaderpack tool (writer).
+//!
+//! A bundle starts with a FileHeader, followed by the table of contents (one Entry per shader,
+//! sorted by name), the name table, the serialized reflection data (see ShaderReflection::serialize)
+//! and finally the SPIR-V blobs. Every
+//! blob starts at a multiple of BlobAlignment, so a memory-mapped bundle can be passed to
+//! vkCreateShaderModule without copying. All offsets are relative to the start of the file.
+namespace time_kill::graphics::shaderbundle {
+    constexpr std::array<char, 8> Magic = { 'T', 'K', 'S', 'H', 'B', 'N', 'D', '\1' };
+    constexpr u32 Version = 2;
+    constexpr u64 BlobAlignment = 16;
+
+    struct FileHeader {
+        std::array<char, 8> magic = Magic;
+        u32 version = Version;
+        u32 headerSize = sizeof(FileHeader);
+        u32 entryCount = 0;
+        u32 entrySize = 0;            // sizeof(Entry) of the writer
+        u64 fileSize = 0;
+        u64 contentHash = 0;          // FNV-1a over the content hashes of all entries, in order
+    };
+
+    struct Entry {
+        u32 nameOffset = 0;           // Name relative to the shader directory, '/' separated, not terminated
+        u32 nameLength = 0;
+        u32 stage = 0;                // VkShaderStageFlagBits
+        u32 reflectionSize = 0;       // Bytes of the serialized ShaderReflection
+        u64 reflectionOffset = 0;
+        u64 codeOffset = 0;           // Aligned to BlobAlignment
+        u64 codeSize = 0;             // Bytes, a multiple of 4
+        u64 contentHash = 0;          // FNV-1a of the SPIR-V code
+    };
+
+    static_assert(sizeof(FileHeader) == 40);
+    static_assert(sizeof(Entry) == 48);
+
+    constexpr u64 alignBlobOffset(const u64 offset) {
+        return (offset + BlobAlignment - 1) & ~(BlobAlignment - 1);
+    }
+}
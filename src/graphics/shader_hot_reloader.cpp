@@ -0,0 +1,231 @@
+#include "shader_hot_reloader.hpp"
+#include "vulkan_configuration.hpp"
+#include "vulkan_pipeline_registry.hpp"
+#include "vulkan_tools.hpp"
+#include "core/logger.hpp"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <cerrno>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace time_kill::graphics {
+    namespace {
+        bool isGlslSource(const std::filesystem::path& path) {
+            static constexpr std::array Extensions = { ".vert", ".frag", ".geom", ".tesc", ".tese", ".comp" };
+            const auto extension = path.extension().string();
+            return std::ranges::find(Extensions, extension) != Extensions.end();
+        }
+
+        //! Runs `arguments[0]` (looked up in PATH) with the given arguments and no shell in between,
+        //! so file names are never interpreted. Collects stdout and stderr into `messages`. Returns
+        //! the exit code, or nullopt if the process could not be started.
+        Optional<int> runProcess(const Vector<String>& arguments, String& messages) {
+#if defined(_WIN32) || defined(_WIN64)
+            // CreateProcess takes one command line that the child splits again with the CRT rules
+            String commandLine;
+            for (const auto& argument : arguments) {
+                if (!commandLine.empty()) {
+                    commandLine += ' ';
+                }
+                commandLine += '"';
+                usize backslashes = 0;
+                for (const char c : argument) {
+                    if (c == '\\') {
+                        ++backslashes;
+                        continue;
+                    }
+                    commandLine.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+                    commandLine += c;
+                    backslashes = 0;
+                }
+                commandLine.append(backslashes * 2, '\\');
+                commandLine += '"';
+            }
+
+            SECURITY_ATTRIBUTES attributes = { sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE };
+            HANDLE readPipe = nullptr;
+            HANDLE writePipe = nullptr;
+            if (!CreatePipe(&readPipe, &writePipe, &attributes, 0)) {
+                return std::nullopt;
+            }
+            SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+
+            STARTUPINFOA startup = {};
+            startup.cb = sizeof(startup);
+            startup.dwFlags = STARTF_USESTDHANDLES;
+            startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+            startup.hStdOutput = writePipe;
+            startup.hStdError = writePipe;
+            PROCESS_INFORMATION process = {};
+            const BOOL started = CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW,
+                                                nullptr, nullptr, &startup, &process);
+            CloseHandle(writePipe);
+            if (!started) {
+                CloseHandle(readPipe);
+                return std::nullopt;
+            }
+
+            std::array<char, 512> buffer;
+            DWORD read = 0;
+            while (ReadFile(readPipe, buffer.data(), static_cast<DWORD>(buffer.size()), &read, nullptr) && read > 0) {
+                messages.append(buffer.data(), read);
+            }
+            CloseHandle(readPipe);
+
+            WaitForSingleObject(process.hProcess, INFINITE);
+            DWORD exitCode = 0;
+            GetExitCodeProcess(process.hProcess, &exitCode);
+            CloseHandle(process.hThread);
+            CloseHandle(process.hProcess);
+            return static_cast<int>(exitCode);
+#else
+            std::array<int, 2> pipe = {};
+            if (::pipe(pipe.data()) != 0) {
+                return std::nullopt;
+            }
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_addclose(&actions, pipe[0]);
+            posix_spawn_file_actions_adddup2(&actions, pipe[1], STDOUT_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, pipe[1], STDERR_FILENO);
+            posix_spawn_file_actions_addclose(&actions, pipe[1]);
+
+            Vector<char*> argv;
+            for (const auto& argument : arguments) {
+                argv.push_back(const_cast<char*>(argument.c_str()));
+            }
+            argv.push_back(nullptr);
+
+            pid_t pid = 0;
+            const int spawned = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+            posix_spawn_file_actions_destroy(&actions);
+            close(pipe[1]);
+            if (spawned != 0) {
+                close(pipe[0]);
+                return std::nullopt;
+            }
+
+            std::array<char, 512> buffer;
+            ssize_t read = 0;
+            while ((read = ::read(pipe[0], buffer.data(), buffer.size())) > 0) {
+                messages.append(buffer.data(), static_cast<usize>(read));
+            }
+            close(pipe[0]);
+
+            int status = 0;
+            while (waitpid(pid, &status, 0) < 0) {
+                if (errno != EINTR) {
+                    return std::nullopt;
+                }
+            }
+            return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+        }
+    }
+
+    ShaderHotReloader::ShaderHotReloader(VulkanPipelineRegistry& pipelineRegistry)
+        : pipelineRegistry_(pipelineRegistry) {}
+
+    ShaderHotReloader::~ShaderHotReloader() {
+        stop();
+    }
+
+    void ShaderHotReloader::start(const VulkanConfiguration& configuration, core::JobSystem& jobSystem) {
+        stop();
+
+        for (const auto& directory : VulkanTools::getShaderDirectories(configuration)) {
+            watcher_.watch(directory);
+            log_debug("Watching shader directory '{}' for changes.", directory);
+        }
+        compiler_ = configuration.shaderCompiler;
+        jobSystem_ = &jobSystem;
+    }
+
+    void ShaderHotReloader::stop() {
+        if (jobSystem_ == nullptr) {
+            return;
+        }
+        jobSystem_->wait(compileCounter_);
+        jobSystem_->wait(reloadCounter_);
+        pendingReloads_.clear();
+        watcher_.unwatchAll();
+        jobSystem_ = nullptr;
+    }
+
+    void ShaderHotReloader::update() {
+        if (jobSystem_ == nullptr) {
+            return;
+        }
+
+        for (const auto& file : watcher_.poll()) {
+            const std::filesystem::path path(file);
+            if (path.extension() == ".spv") {
+                if (std::ranges::find(pendingReloads_, file) == pendingReloads_.end()) {
+                    pendingReloads_.push_back(file);
+                }
+            } else if (isGlslSource(path) && !compiler_.empty()) {
+                // The compiled .spv shows up as a change of its own once it is written
+                jobSystem_->schedule([this, file] { compileGlsl(file); }, compileCounter_);
+            }
+        }
+        scheduleReloads();
+
+        // Nothing else would run the jobs; they are waited on only in stop(). That includes the
+        // pipeline compiles the reload jobs schedule under the registry's own counters.
+        if (jobSystem_->getWorkerCount() == 0) {
+            jobSystem_->wait(compileCounter_);
+            jobSystem_->wait(reloadCounter_);
+            pipelineRegistry_.waitAll();
+        }
+    }
+
+    void ShaderHotReloader::scheduleReloads() {
+        if (pendingReloads_.empty() || !reloadCounter_.isDone()) {
+            return;
+        }
+        jobSystem_->schedule([this, files = std::move(pendingReloads_)] {
+            for (const auto& file : files) {
+                pipelineRegistry_.reloadShader(file);
+            }
+        }, reloadCounter_);
+        pendingReloads_.clear();
+    }
+
+    void ShaderHotReloader::compileGlsl(const String& source) {
+        namespace fs = std::filesystem;
+        const String output = source + ".spv";
+        // Each compile gets its own file, so quick successive saves of a source never share one
+        const String temporary = output + "." + std::to_string(compileSerial_.fetch_add(1)) + ".tmp";
+
+        // Compile next to the target and rename, so the watcher never sees a half-written module
+        String messages;
+        const auto status = runProcess({ compiler_, "-V", source, "-o", temporary }, messages);
+        if (!status) {
+            log_error("Failed to run shader compiler '{}'.", compiler_);
+            return;
+        }
+
+        std::error_code error;
+        if (*status != 0) {
+            fs::remove(temporary, error);
+            log_error("Failed to compile shader '{}':\n{}", source, messages);
+            return;
+        }
+        fs::rename(temporary, output, error);
+        if (error) {
+            fs::remove(temporary, error);
+            log_error("Failed to replace '{}': {}", output, error.message());
+            return;
+        }
+        log_info("Compiled shader '{}'.", source);
+    }
+}
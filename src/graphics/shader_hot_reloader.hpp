@@ -0,0 +1,60 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <atomic>
+#include "core/job_system.hpp"
+#include "utils/file_watcher.hpp"
+
+namespace time_kill::graphics {
+    class VulkanConfiguration;
+    class VulkanPipelineRegistry;
+
+    //! Watches the shader directories and rebuilds the pipelines of shaders that change on disk.
+    //!
+    //! A changed GLSL source (`basic.vert`) is compiled to SPIR-V (`basic.vert.spv`, as
+    //! scripts/convert_shader.py does) by a job on the job system; a changed `.spv` file, whether
+    //! written by that job or by an external build, makes the pipeline registry recompile every
+    //! pipeline using it. update() only polls for changes and schedules jobs: reading SPIR-V,
+    //! running the compiler and creating pipelines happen on the workers, which the render thread
+    //! never helps with while it waits on its own jobs (see JobSystem::wait). The registry swaps the
+    //! new pipelines in at a frame boundary. Without workers the jobs, including the pipeline
+    //! compiles they schedule on the registry, run in update() instead.
+    class ShaderHotReloader {
+    public:
+        explicit ShaderHotReloader(VulkanPipelineRegistry& pipelineRegistry);
+        ~ShaderHotReloader();
+
+        ShaderHotReloader(const ShaderHotReloader&) = delete;
+        ShaderHotReloader& operator=(const ShaderHotReloader&) = delete;
+
+        //! Starts watching the configured shader directories. GLSL is compiled with
+        //! `configuration.shaderCompiler`, which must accept glslangValidator's `-V <in> -o <out>`.
+        void start(const VulkanConfiguration& configuration, core::JobSystem& jobSystem);
+
+        //! Stops watching and waits for running shader compilations.
+        void stop();
+
+        [[nodiscard]] bool isRunning() const { return jobSystem_ != nullptr; }
+
+        //! Polls for changed files and schedules their compilation and pipeline rebuilds. Call once
+        //! per frame; never blocks while the job system has workers.
+        void update();
+
+    private:
+        //! Compiles the GLSL file `source` to `source.spv`; runs on a job system thread.
+        void compileGlsl(const String& source);
+
+        //! Hands the changed SPIR-V files to the registry in one job, once the previous one is done,
+        //! so reloads of the same file are applied in the order they were seen.
+        void scheduleReloads();
+
+        VulkanPipelineRegistry& pipelineRegistry_;
+        core::JobSystem* jobSystem_ = nullptr;
+        utils::FileWatcher watcher_;
+        String compiler_;
+        core::JobCounter compileCounter_;
+        core::JobCounter reloadCounter_;
+        Vector<String> pendingReloads_;     // Changed .spv files not handed to a reload job yet
+        std::atomic<u32> compileSerial_ = 0; // Makes the temporary output of each compile unique
+    };
+}
@@ -0,0 +1,444 @@
+#include "shader_reflection.hpp"
+#include "core/logger.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <spirv_reflect.h>
+#include <unordered_set>
+
+namespace time_kill::graphics {
+    namespace {
+        constexpr u32 ReflectionVersion = 2;
+
+        constexpr std::array<char, 8> CacheFileMagic = { 'T', 'K', 'R', 'E', 'F', 'L', '\0', '\1' };
+        constexpr u32 CacheFileVersion = 3;
+
+        //! Owns a SpvReflectShaderModule for the duration of a reflection.
+        class ReflectModule {
+        public:
+            ReflectModule(const std::span<const u32> code, const String& name) {
+                if (spvReflectCreateShaderModule(code.size_bytes(), code.data(), &module_) != SPV_REFLECT_RESULT_SUCCESS) {
+                    throw std::runtime_error("Failed to reflect SPIR-V shader: " + name);
+                }
+            }
+            ~ReflectModule() { spvReflectDestroyShaderModule(&module_); }
+
+            ReflectModule(const ReflectModule&) = delete;
+            ReflectModule& operator=(const ReflectModule&) = delete;
+
+            template <typename T, typename F>
+            Vector<T*> enumerate(F enumerateFunc) {
+                u32 count = 0;
+                enumerateFunc(&module_, &count, nullptr);
+
+                Vector<T*> variables(count);
+                enumerateFunc(&module_, &count, variables.data());
+                return variables;
+            }
+
+            [[nodiscard]] VkShaderStageFlagBits getStage() const {
+                return static_cast<VkShaderStageFlagBits>(module_.shader_stage);
+            }
+
+        private:
+            SpvReflectShaderModule module_ = {};
+        };
+
+        void throwDuplicateLocationError(const String& filename, const u32 location, const bool input) {
+            std::ostringstream oss;
+            oss << "SPIRV-Reflect: Duplicate " << (input ? "input" : "output")
+                << " attribute location detected!\n"
+                << "File: " << filename << "\n"
+                << "Location: " << location << "\n";
+            throw std::runtime_error(oss.str());
+        }
+
+        //! Size in bytes of a (scalar or vector) interface variable.
+        u32 attributeSize(const SpvReflectInterfaceVariable& variable) {
+            const u32 components = std::max<u32>(variable.numeric.vector.component_count, 1);
+            return variable.numeric.scalar.width / 8 * components;
+        }
+
+        //=== Little helpers for the flat binary encoding
+
+        class Writer {
+        public:
+            template<typename T>
+            void put(const T& value) {
+                const auto* bytes = reinterpret_cast<const u8*>(&value);
+                data_.insert(data_.end(), bytes, bytes + sizeof(T));
+            }
+            void putBytes(const std::span<const u8> bytes) {
+                data_.insert(data_.end(), bytes.begin(), bytes.end());
+            }
+            Vector<u8>& data() { return data_; }
+
+        private:
+            Vector<u8> data_;
+        };
+
+        class Reader {
+        public:
+            explicit Reader(const std::span<const u8> data) : data_(data) {}
+
+            template<typename T>
+            bool get(T& value) {
+                if (data_.size() - position_ < sizeof(T)) {
+                    return false;
+                }
+                std::memcpy(&value, data_.data() + position_, sizeof(T));
+                position_ += sizeof(T);
+                return true;
+            }
+            bool getBytes(const usize size, std::span<const u8>& bytes) {
+                if (data_.size() - position_ < size) {
+                    return false;
+                }
+                bytes = data_.subspan(position_, size);
+                position_ += size;
+                return true;
+            }
+            [[nodiscard]] bool atEnd() const { return position_ == data_.size(); }
+
+        private:
+            std::span<const u8> data_;
+            usize position_ = 0;
+        };
+    }
+
+    //=== ShaderReflection
+
+    ShaderReflection ShaderReflection::reflect(const std::span<const u32> code, const String& name) {
+        ReflectModule module(code, name);
+
+        ShaderReflection reflection;
+        reflection.stage = module.getStage();
+
+        // Interface variables; built-ins (gl_VertexIndex, gl_Position, ...) have no location
+        std::unordered_set<u32> outputLocations;
+        for (const auto* variable : module.enumerate<SpvReflectInterfaceVariable>(spvReflectEnumerateOutputVariables)) {
+            if (variable->built_in != -1) continue;
+            if (!outputLocations.insert(variable->location).second) {
+                throwDuplicateLocationError(name, variable->location, false);
+            }
+        }
+
+        Vector<const SpvReflectInterfaceVariable*> inputs;
+        std::unordered_set<u32> inputLocations;
+        for (const auto* variable : module.enumerate<SpvReflectInterfaceVariable>(spvReflectEnumerateInputVariables)) {
+            if (variable->built_in != -1) continue;
+            if (!inputLocations.insert(variable->location).second) {
+                throwDuplicateLocationError(name, variable->location, true);
+            }
+            inputs.push_back(variable);
+        }
+
+        if (reflection.stage == VK_SHADER_STAGE_VERTEX_BIT) {
+            // Interleave the attributes in location order
+            std::ranges::sort(inputs, {}, &SpvReflectInterfaceVariable::location);
+            for (const auto* variable : inputs) {
+                VkVertexInputAttributeDescription attribute = {};
+                attribute.location = variable->location;
+                attribute.binding = 0;
+                attribute.format = static_cast<VkFormat>(variable->format);
+                attribute.offset = reflection.vertexStride;
+                reflection.vertexInputs.push_back(attribute);
+                reflection.vertexStride += attributeSize(*variable);
+            }
+        }
+
+        for (const auto* set : module.enumerate<SpvReflectDescriptorSet>(spvReflectEnumerateDescriptorSets)) {
+            for (u32 i = 0; i < set->binding_count; ++i) {
+                const auto* binding = set->bindings[i];
+                ShaderDescriptorBinding descriptor;
+                descriptor.set = set->set;
+                descriptor.binding = binding->binding;
+                descriptor.type = static_cast<VkDescriptorType>(binding->descriptor_type);
+                descriptor.count = binding->count;
+                reflection.descriptorBindings.push_back(descriptor);
+            }
+        }
+        std::ranges::sort(reflection.descriptorBindings, [](const auto& a, const auto& b) {
+            return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+        });
+
+        for (const auto* block : module.enumerate<SpvReflectBlockVariable>(spvReflectEnumeratePushConstantBlocks)) {
+            VkPushConstantRange range = {};
+            range.stageFlags = reflection.stage;
+            range.offset = block->offset;
+            range.size = block->size;
+            reflection.pushConstantRanges.push_back(range);
+        }
+
+        for (const auto* constant : module.enumerate<SpvReflectSpecializationConstant>(spvReflectEnumerateSpecializationConstants)) {
+            ShaderSpecializationConstant specializationConstant;
+            specializationConstant.constantId = constant->constant_id;
+            specializationConstant.name = constant->name != nullptr ? constant->name : "";
+            reflection.specializationConstants.push_back(std::move(specializationConstant));
+        }
+        std::ranges::sort(reflection.specializationConstants, {}, &ShaderSpecializationConstant::constantId);
+
+        return reflection;
+    }
+
+    Vector<u8> ShaderReflection::serialize() const {
+        Writer writer;
+        writer.put(ReflectionVersion);
+        writer.put(static_cast<u32>(stage));
+        writer.put(vertexStride);
+        writer.put(static_cast<u32>(vertexInputs.size()));
+        writer.put(static_cast<u32>(descriptorBindings.size()));
+        writer.put(static_cast<u32>(pushConstantRanges.size()));
+        writer.put(static_cast<u32>(specializationConstants.size()));
+        for (const auto& input : vertexInputs) {
+            writer.put(input.location);
+            writer.put(input.binding);
+            writer.put(static_cast<u32>(input.format));
+            writer.put(input.offset);
+        }
+        for (const auto& binding : descriptorBindings) {
+            writer.put(binding.set);
+            writer.put(binding.binding);
+            writer.put(static_cast<u32>(binding.type));
+            writer.put(binding.count);
+        }
+        for (const auto& range : pushConstantRanges) {
+            writer.put(static_cast<u32>(range.stageFlags));
+            writer.put(range.offset);
+            writer.put(range.size);
+        }
+        for (const auto& constant : specializationConstants) {
+            writer.put(constant.constantId);
+            writer.put(static_cast<u32>(constant.name.size()));
+            writer.putBytes({ reinterpret_cast<const u8*>(constant.name.data()), constant.name.size() });
+        }
+        return std::move(writer.data());
+    }
+
+    Optional<ShaderReflection> ShaderReflection::deserialize(const std::span<const u8> data) {
+        Reader reader(data);
+        u32 version = 0, stage = 0, inputCount = 0, bindingCount = 0, rangeCount = 0, constantCount = 0;
+        ShaderReflection reflection;
+        if (!reader.get(version) || version != ReflectionVersion || !reader.get(stage) ||
+            !reader.get(reflection.vertexStride) || !reader.get(inputCount) || !reader.get(bindingCount) ||
+            !reader.get(rangeCount) || !reader.get(constantCount)) {
+            return std::nullopt;
+        }
+        reflection.stage = static_cast<VkShaderStageFlagBits>(stage);
+
+        // Records are at least 12 bytes (8 for constants); reject counts the data cannot hold before allocating
+        if ((u64(inputCount) + bindingCount + rangeCount) * 12 + u64(constantCount) * 8 > data.size()) {
+            return std::nullopt;
+        }
+
+        reflection.vertexInputs.resize(inputCount);
+        for (auto& input : reflection.vertexInputs) {
+            u32 format = 0;
+            if (!reader.get(input.location) || !reader.get(input.binding) || !reader.get(format) || !reader.get(input.offset)) {
+                return std::nullopt;
+            }
+            input.format = static_cast<VkFormat>(format);
+        }
+        reflection.descriptorBindings.resize(bindingCount);
+        for (auto& binding : reflection.descriptorBindings) {
+            u32 type = 0;
+            if (!reader.get(binding.set) || !reader.get(binding.binding) || !reader.get(type) || !reader.get(binding.count)) {
+                return std::nullopt;
+            }
+            binding.type = static_cast<VkDescriptorType>(type);
+        }
+        reflection.pushConstantRanges.resize(rangeCount);
+        for (auto& range : reflection.pushConstantRanges) {
+            u32 stageFlags = 0;
+            if (!reader.get(stageFlags) || !reader.get(range.offset) || !reader.get(range.size)) {
+                return std::nullopt;
+            }
+            range.stageFlags = stageFlags;
+        }
+        reflection.specializationConstants.resize(constantCount);
+        for (auto& constant : reflection.specializationConstants) {
+            u32 nameSize = 0;
+            std::span<const u8> name;
+            if (!reader.get(constant.constantId) || !reader.get(nameSize) || !reader.getBytes(nameSize, name)) {
+                return std::nullopt;
+            }
+            constant.name.assign(reinterpret_cast<const char*>(name.data()), name.size());
+        }
+
+        if (!reader.atEnd()) {
+            return std::nullopt;
+        }
+        return reflection;
+    }
+
+    //=== ShaderReflectionCache
+
+    void ShaderReflectionCache::load(const String& path) {
+        std::lock_guard lock(mutex_);
+        path_ = path;
+        dirty_ = false;
+        if (path_.empty()) {
+            return;
+        }
+
+        std::ifstream file(path_, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            log_debug("No shader reflection cache at '{}'.", path_);
+            return;
+        }
+        Vector<u8> data(static_cast<usize>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+
+        Reader reader(data);
+        std::array<char, 8> magic = {};
+        u32 version = 0, count = 0;
+        if (!file || !reader.get(magic) || magic != CacheFileMagic || !reader.get(version) ||
+            version != CacheFileVersion || !reader.get(count)) {
+            log_warn("Ignoring shader reflection cache '{}': unknown format.", path_);
+            return;
+        }
+
+        std::unordered_multimap<u64, Entry> loaded;
+        for (u32 i = 0; i < count; ++i) {
+            u64 hash = 0;
+            u32 codeWords = 0;
+            u32 size = 0;
+            std::span<const u8> code;
+            std::span<const u8> bytes;
+            if (!reader.get(hash) || !reader.get(codeWords) || !reader.getBytes(usize(codeWords) * sizeof(u32), code) ||
+                !reader.get(size) || !reader.getBytes(size, bytes)) {
+                log_warn("Ignoring shader reflection cache '{}': file is truncated.", path_);
+                return;
+            }
+            auto reflection = ShaderReflection::deserialize(bytes);
+            if (!reflection) {
+                log_warn("Ignoring shader reflection cache '{}': entry {} is corrupt.", path_, i);
+                return;
+            }
+            Entry entry;
+            entry.code.resize(codeWords);
+            std::memcpy(entry.code.data(), code.data(), code.size());
+            entry.reflection = createSharedPtr<const ShaderReflection>(std::move(*reflection));
+            loaded.emplace(hash, std::move(entry));
+        }
+
+        reflections_.merge(loaded);
+        log_debug("Loaded {} shader reflections from '{}'.", count, path_);
+    }
+
+    bool ShaderReflectionCache::save() {
+        std::lock_guard lock(mutex_);
+        if (path_.empty() || !dirty_) {
+            return true;
+        }
+
+        Writer writer;
+        writer.put(CacheFileMagic);
+        writer.put(CacheFileVersion);
+        writer.put(static_cast<u32>(reflections_.size()));
+        for (const auto& [hash, entry] : reflections_) {
+            const auto bytes = entry.reflection->serialize();
+            writer.put(hash);
+            writer.put(static_cast<u32>(entry.code.size()));
+            writer.putBytes({ reinterpret_cast<const u8*>(entry.code.data()), entry.code.size() * sizeof(u32) });
+            writer.put(static_cast<u32>(bytes.size()));
+            writer.putBytes(bytes);
+        }
+
+        // Write next to the target and rename over it, so a crash never leaves a partial file
+        namespace fs = std::filesystem;
+        fs::path temporary(path_);
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(writer.data().data()), static_cast<std::streamsize>(writer.data().size()));
+            if (!file) {
+                log_warn("Failed to write shader reflection cache '{}'.", temporary.string());
+                return false;
+            }
+        }
+        std::error_code error;
+        fs::rename(temporary, path_, error);
+        if (error) {
+            log_warn("Failed to replace shader reflection cache '{}': {}", path_, error.message());
+            fs::remove(temporary, error);
+            return false;
+        }
+
+        dirty_ = false;
+        log_debug("Saved {} shader reflections to '{}'.", reflections_.size(), path_);
+        return true;
+    }
+
+    SharedPtr<const ShaderReflection> ShaderReflectionCache::get(const u64 contentHash, const std::span<const u32> code,
+                                                                 const String& name,
+                                                                 const std::span<const u8> precomputed) {
+        // A hit must be the very same module, not just one with the same hash
+        const auto find = [&]() -> SharedPtr<const ShaderReflection> {
+            const auto [first, last] = reflections_.equal_range(contentHash);
+            for (auto it = first; it != last; ++it) {
+                if (std::ranges::equal(it->second.code, code)) {
+                    return it->second.reflection;
+                }
+            }
+            return nullptr;
+        };
+
+        {
+            std::lock_guard lock(mutex_);
+            if (auto cached = find()) {
+                ++statistics_.hits;
+                return cached;
+            }
+        }
+
+        // Reflect outside the lock; two threads missing on the same module both reflect, one wins
+        Optional<ShaderReflection> reflection;
+        if (!precomputed.empty()) {
+            reflection = ShaderReflection::deserialize(precomputed);
+            if (!reflection) {
+                log_warn("Precomputed reflection of '{}' is invalid; reflecting the shader.", name);
+            }
+        }
+        const bool fromPrecomputed = reflection.has_value();
+        if (!reflection) {
+            reflection = ShaderReflection::reflect(code, name);
+            log_trace("Reflected shader '{}'.", name);
+        }
+
+        std::lock_guard lock(mutex_);
+        ++statistics_.misses;
+        if (fromPrecomputed) {
+            ++statistics_.precomputed;
+        }
+        if (auto cached = find()) {
+            return cached; // Another thread reflected it meanwhile
+        }
+        Entry entry;
+        entry.code.assign(code.begin(), code.end());
+        entry.reflection = createSharedPtr<const ShaderReflection>(std::move(*reflection));
+        const auto it = reflections_.emplace(contentHash, std::move(entry));
+        dirty_ = true;
+        return it->second.reflection;
+    }
+
+    void ShaderReflectionCache::clear() {
+        std::lock_guard lock(mutex_);
+        dirty_ = dirty_ || !reflections_.empty();
+        reflections_.clear();
+    }
+
+    usize ShaderReflectionCache::size() const {
+        std::lock_guard lock(mutex_);
+        return reflections_.size();
+    }
+
+    ShaderReflectionStatistics ShaderReflectionCache::getStatistics() const {
+        std::lock_guard lock(mutex_);
+        return statistics_;
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+namespace time_kill::graphics {
+    struct ShaderDescriptorBinding {
+        u32 set = 0;
+        u32 binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        u32 count = 1;
+    };
+
+    //! A specialization constant declared by a shader (`layout(constant_id = N) const ...`).
+    struct ShaderSpecializationConstant {
+        u32 constantId = 0;
+        String name;            //!< Empty if the module was stripped of debug names
+    };
+
+    //! Everything the engine needs to know about a SPIR-V module to build pipelines for it.
+    struct ShaderReflection {
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+
+        //! Vertex shader inputs sorted by location, tightly packed into binding 0.
+        Vector<VkVertexInputAttributeDescription> vertexInputs;
+        u32 vertexStride = 0;
+
+        Vector<ShaderDescriptorBinding> descriptorBindings;
+        Vector<VkPushConstantRange> pushConstantRanges;
+
+        //! Sorted by constant id.
+        Vector<ShaderSpecializationConstant> specializationConstants;
+
+        //! Runs SPIRV-Reflect on `code`. Throws if the module cannot be reflected or has duplicate
+        //! interface locations; `name` is used in error messages.
+        static ShaderReflection reflect(std::span<const u32> code, const String& name);
+
+        //! Compact binary form used by the on-disk cache and by shader bundles.
+        [[nodiscard]] Vector<u8> serialize() const;
+        static Optional<ShaderReflection> deserialize(std::span<const u8> data);
+    };
+
+    struct ShaderReflectionStatistics {
+        u32 hits = 0;
+        u32 misses = 0;         //!< Modules that had to be reflected
+        u32 precomputed = 0;    //!< Misses served from precomputed data (shader bundles)
+    };
+
+    //! Reflection results keyed by the content hash of the SPIR-V, so each module is reflected at
+    //! most once per run, and at most once ever if the cache is persisted. Thread-safe.
+    class ShaderReflectionCache {
+    public:
+        ShaderReflectionCache() = default;
+
+        //! Loads the entries stored in `path`; later saves go to the same file. A missing or invalid
+        //! file leaves the cache empty. An empty path keeps the cache in memory only.
+        void load(const String& path);
+
+        //! Writes the cache back if it changed since it was loaded; returns false if writing failed.
+        bool save();
+
+        //! Returns the reflection of `code`, whose content hash is `contentHash`. On a miss it is
+        //! taken from `precomputed` (a serialized ShaderReflection) if given, else reflected.
+        SharedPtr<const ShaderReflection> get(u64 contentHash, std::span<const u32> code, const String& name,
+                                              std::span<const u8> precomputed = {});
+
+        void clear();
+
+        [[nodiscard]] usize size() const;
+        [[nodiscard]] ShaderReflectionStatistics getStatistics() const;
+
+    private:
+        //! The module is kept to tell hash collisions from the same module.
+        struct Entry {
+            Vector<u32> code;
+            SharedPtr<const ShaderReflection> reflection;
+        };
+
+        String path_;
+        bool dirty_ = false;
+
+        mutable std::mutex mutex_;
+        std::unordered_multimap<u64, Entry> reflections_;
+        ShaderReflectionStatistics statistics_;
+    };
+}
@@ -1,8 +1,74 @@
 #pragma once
 
 #include "prerequisites.hpp"
+#include "core/job_system.hpp"
+#include <vulkan/vulkan.h>
 
 namespace time_kill::graphics {
+    //! How presentation trades latency against power and throughput.
+    struct LatencyPolicy {
+        //! Present modes in order of preference; the first the surface supports is used. FIFO is
+        //! always supported and used if none of them is.
+        Vector<VkPresentModeKHR> presentModes = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+
+        //! Swapchain images requested on top of the surface's minimum, clamped to its maximum.
+        uint32_t extraSwapchainImages = 1;
+
+        //! Number of frames the CPU may record ahead of the GPU.
+        uint32_t framesInFlight = 2;
+
+        //! Frame rate VulkanRenderer::waitForNextFrame paces the CPU to; 0 disables pacing.
+        f64 targetFrameRate = 0.0;
+
+        //! waitForNextFrame waits until the previous frame is on screen (VK_KHR_present_wait), so
+        //! input is sampled as late as possible. Ignored if the device lacks present wait.
+        bool waitForPresent = false;
+
+        //! Lowest input-to-present latency: no queueing on the CPU or in the swapchain, tearing
+        //! accepted if MAILBOX is unavailable.
+        static LatencyPolicy lowestLatency() {
+            LatencyPolicy policy;
+            policy.presentModes = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR,
+                                    VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR };
+            policy.framesInFlight = 1;
+            policy.waitForPresent = true;
+            return policy;
+        }
+
+        //! Lowest power: V-Sync and no images beyond the minimum, so the GPU idles between frames.
+        static LatencyPolicy lowestPower() {
+            LatencyPolicy policy;
+            policy.presentModes = { VK_PRESENT_MODE_FIFO_KHR };
+            policy.extraSwapchainImages = 0;
+            return policy;
+        }
+
+        //! Uncapped frame rate for benchmarking: no V-Sync and the CPU may run well ahead.
+        static LatencyPolicy uncapped() {
+            LatencyPolicy policy;
+            policy.presentModes = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+                                    VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR };
+            policy.framesInFlight = 3;
+            return policy;
+        }
+    };
+
+    //! Rendering without a window (VulkanContext constructed from a configuration only), e.g. batch
+    //! rendering, golden-image tests and benchmarks on servers without a display. Needs no present
+    //! queue or swapchain support, so CPU implementations such as lavapipe work.
+    struct HeadlessConfiguration {
+        //! Size of the render targets.
+        uint32_t width = 1280;
+        uint32_t height = 720;
+
+        //! Format of the offscreen color images, one per frame in flight.
+        VkFormat colorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+        //! Renders to a swapchain on a VK_EXT_headless_surface instead of offscreen images, so the
+        //! present path is exercised too. Falls back to offscreen images if the instance lacks it.
+        bool useHeadlessSurface = false;
+    };
+
     class VulkanConfiguration {
     public:
         VulkanConfiguration() = default;
@@ -15,6 +81,38 @@ namespace time_kill::graphics {
         bool enableExtensions = true;
         bool enableMSAA = false;
 
+        //! Renders with vkCmdBeginRendering (VK_KHR_dynamic_rendering, core in Vulkan 1.3) instead of a
+        //! VkRenderPass and framebuffers. Falls back to the render pass if the device lacks support.
+        bool dynamicRendering = false;
+
+        //! Present mode, swapchain image count, frames in flight and frame pacing.
+        LatencyPolicy latencyPolicy;
+
+        //! Render target settings of a headless context; ignored if there is a window.
+        HeadlessConfiguration headless;
+
+        //! Shader bundle created by the shaderpack tool, relative to the root directory. If it exists,
+        //! shaders are taken from it instead of scanning the shader directories.
+        String shaderBundlePath = "assets/shaders.bundle";
+
+        //! File the pipeline cache is loaded from and saved to, relative to the root directory. Empty
+        //! keeps the cache in memory only.
+        String pipelineCachePath = "pipeline_cache.bin";
+
+        //! File SPIR-V reflection results are loaded from and saved to, relative to the root directory.
+        //! Empty keeps them in memory only.
+        String reflectionCachePath = "reflection_cache.bin";
+
+        //! Watches the shader directories and rebuilds pipelines when shaders change; see
+        //! VulkanContext::processShaderReloads. Meant for development builds.
+        bool hotReloadShaders = false;
+
+        //! GLSL compiler used by hot reloading, invoked as `<shaderCompiler> -V <source> -o <output>`.
+        String shaderCompiler = "glslangValidator";
+
+        //! Job system for parallel work such as command recording. Defaults to JobSystem::getInstance().
+        core::JobSystem* jobSystem = nullptr;
+
         void setRootDirectory(const String& directory) {
             rootDirectory_ = directory;
         }
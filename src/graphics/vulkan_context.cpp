@@ -6,6 +6,7 @@
 #include <map>
 #include <iostream>
 #include <set>
+#include <filesystem>
 
 const std::vector<const char*> ValidationLayers = {
     "VK_LAYER_KHRONOS_validation"
@@ -16,40 +17,90 @@ const std::vector<const char*> DeviceExtensions = {
 
 namespace time_kill::graphics {
     VulkanContext::VulkanContext(const core::Window& window, const VulkanConfiguration& configuration)
+        : VulkanContext(&window, configuration) {}
+
+    VulkanContext::VulkanContext(const VulkanConfiguration& configuration)
+        : VulkanContext(nullptr, configuration) {}
+
+    VulkanContext::VulkanContext(const core::Window* window, const VulkanConfiguration& configuration)
         : debugEnabled_(configuration.debugEnabled),
+          headless_(window == nullptr),
           debugMessenger_(nullptr),
-          swapchain_(resources_),
+          memoryAllocator_(resources_),
+          swapchain_(resources_, memoryAllocator_, configuration.latencyPolicy),
           renderPass_(resources_),
-          graphicsPipeline_(resources_) {
-
-        if (!glfwVulkanSupported()) {
+          pipelineCache_(resources_),
+          layoutCache_(resources_),
+          pipelineRegistry_(resources_, pipelineCache_, reflectionCache_, layoutCache_),
+          graphicsPipeline_(resources_, pipelineRegistry_),
+          shaderHotReloader_(pipelineRegistry_),
+          renderer_(resources_, swapchain_),
+          frameReadback_(resources_, memoryAllocator_),
+          gpuProfiler_(resources_) {
+
+        // Headless, GLFW is not involved at all
+        if (window != nullptr && !glfwVulkanSupported()) {
             throw std::runtime_error("Vulkan is not supported by GLFW");
         }
 
-        createInstance(window);
-        createDebugMessenger(window);
+        createInstance(window, configuration);
+        createDebugMessenger();
         createSurface(window);
-        pickPhysicalDevice(window);
-        createLogicalDevice(window);
-
-        swapchain_.createSwapchain(window);
-        renderPass_.createRenderPass();
-        graphicsPipeline_.createGraphicsPipeline(window, configuration);
+        resources_.offscreen = resources_.surface == VK_NULL_HANDLE;
+        pickPhysicalDevice();
+        createLogicalDevice(configuration);
+        memoryAllocator_.createAllocator();
+        pipelineCache_.createPipelineCache(VulkanTools::resolvePath(configuration, configuration.pipelineCachePath));
+        reflectionCache_.load(VulkanTools::resolvePath(configuration, configuration.reflectionCachePath));
+
+        const auto& headless = configuration.headless;
+        if (window != nullptr) {
+            const auto [width, height] = window->getFramebufferSize();
+            swapchain_.createSwapchain({ static_cast<uint32_t>(width), static_cast<uint32_t>(height) });
+        } else if (!resources_.offscreen) {
+            swapchain_.createSwapchain({ headless.width, headless.height });
+        } else {
+            swapchain_.createOffscreenTargets({ headless.width, headless.height }, headless.colorFormat,
+                                              configuration.latencyPolicy.framesInFlight);
+        }
+        if (!resources_.dynamicRenderingEnabled) {
+            renderPass_.createRenderPass();
+        }
+        openShaderBundle(configuration);
+        pipelineRegistry_.createRegistry(configuration.jobSystem ? *configuration.jobSystem : core::JobSystem::getInstance(),
+                                         shaderBundle_.isOpen() ? &shaderBundle_ : nullptr);
+        graphicsPipeline_.createGraphicsPipeline(configuration, shaderBundle_);
+        renderer_.createRenderer(window, configuration.latencyPolicy,
+                                 configuration.jobSystem ? *configuration.jobSystem : core::JobSystem::getInstance());
+        if (configuration.hotReloadShaders) {
+            shaderHotReloader_.start(configuration,
+                                     configuration.jobSystem ? *configuration.jobSystem : core::JobSystem::getInstance());
+        }
     }
 
     VulkanContext::~VulkanContext() {
         auto& res = resources_;
         auto& log = core::Logger::getInstance();
 
+        shaderHotReloader_.stop();
+        frameReadback_.destroyReadback();
+        gpuProfiler_.destroyProfiler();
+        renderer_.destroyRenderer();
         if (res.graphicsPipeline != VK_NULL_HANDLE) {
             graphicsPipeline_.destroyGraphicsPipeline();
         }
+        pipelineRegistry_.destroyRegistry();
+        layoutCache_.destroyLayouts();
+        reflectionCache_.save();
+        shaderBundle_.close();
+        pipelineCache_.destroyPipelineCache();
         if (res.renderPass != VK_NULL_HANDLE) {
             renderPass_.destroyRenderPass();
         }
-        if (res.swapchain) {
+        if (res.swapchain || !res.swapchainImages.empty()) {
             swapchain_.destroySwapchain();
         }
+        memoryAllocator_.destroyAllocator();
         if (res.logicalDevice != nullptr) {
             queuesWaitIdle(true);
             vkDestroyDevice(res.logicalDevice, nullptr);
@@ -96,7 +147,7 @@ namespace time_kill::graphics {
         return VK_FALSE;
     }
 
-    void VulkanContext::createDebugMessenger(const core::Window& window) {
+    void VulkanContext::createDebugMessenger() {
         if (!debugEnabled_) {
             return;
         }
@@ -147,7 +198,7 @@ namespace time_kill::graphics {
         debugMessenger_ = nullptr;
     }
 
-    void VulkanContext::createInstance(const core::Window& window) {
+    void VulkanContext::createInstance(const core::Window* window, const VulkanConfiguration& configuration) {
         if (debugEnabled_ && !checkValidationLayerSupport(ValidationLayers)) {
             throw std::runtime_error("Validation layers requested, but not available!");
         }
@@ -164,13 +215,24 @@ namespace time_kill::graphics {
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         createInfo.pApplicationInfo = &appInfo;
 
-        // Retrieve GLFW extensions
-        uint32_t extensionCount = 0;
-        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
-        logGlfwVulkanExtensions(extensionCount, glfwExtensions);
-
-        // Enable extensions (aka getRequiredExtensions)
-        Vector<const char*> extensions(glfwExtensions, glfwExtensions + extensionCount);
+        // Enable extensions (aka getRequiredExtensions): the window's surface extensions from GLFW, or
+        // the headless surface if asked for and available
+        Vector<const char*> extensions;
+        if (window != nullptr) {
+            uint32_t extensionCount = 0;
+            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+            logGlfwVulkanExtensions(extensionCount, glfwExtensions);
+            extensions.assign(glfwExtensions, glfwExtensions + extensionCount);
+        } else if (configuration.headless.useHeadlessSurface) {
+            headlessSurfaceEnabled_ = VulkanTools::isInstanceExtensionSupported(VK_KHR_SURFACE_EXTENSION_NAME) &&
+                                      VulkanTools::isInstanceExtensionSupported(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+            if (headlessSurfaceEnabled_) {
+                extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+                extensions.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+            } else {
+                log_warn("VK_EXT_headless_surface is not available; rendering to offscreen images.");
+            }
+        }
         if (debugEnabled_) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
         }
@@ -195,18 +257,41 @@ namespace time_kill::graphics {
         log_debug("Created Vulkan instance successfully.");
     }
 
-    void VulkanContext::createSurface(const core::Window& window) {
+    void VulkanContext::createSurface(const core::Window* window) {
+        auto& res = resources_;
+
+        if (window == nullptr) {
+            if (!headlessSurfaceEnabled_) {
+                log_info("Headless context without surface; rendering to offscreen images.");
+                return;
+            }
+
+            const auto vkCreateHeadlessSurfaceEXT = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(
+                vkGetInstanceProcAddr(res.instance, "vkCreateHeadlessSurfaceEXT")
+            );
+            if (!vkCreateHeadlessSurfaceEXT) {
+                throw std::runtime_error("Failed to load vkCreateHeadlessSurfaceEXT!");
+            }
+
+            VkHeadlessSurfaceCreateInfoEXT createInfo = {};
+            createInfo.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+            if (vkCreateHeadlessSurfaceEXT(res.instance, &createInfo, nullptr, &res.surface) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create headless surface!");
+            }
+
+            core::Logger::getInstance().info("Vulkan headless surface created successfully.");
+            return;
+        }
 
         // Use GLFW to crate a Vulkan surface
-        if (auto& res = resources_;
-            glfwCreateWindowSurface(res.instance, window.window_.get(), nullptr, &res.surface) != VK_SUCCESS) {
+        if (glfwCreateWindowSurface(res.instance, window->window_.get(), nullptr, &res.surface) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create window surface!");
         }
 
         core::Logger::getInstance().info("Vulkan surface created successfully.");
     }
 
-    void VulkanContext::pickPhysicalDevice(const core::Window &window) {
+    void VulkanContext::pickPhysicalDevice() {
         auto& res = resources_;
 
         uint32_t deviceCount = 0;
@@ -221,13 +306,13 @@ namespace time_kill::graphics {
 
         std::multimap<int, VkPhysicalDevice> candidates;
         for (const auto& device : devices) {
-            int score = rateDeviceSuitability(device, window);
+            int score = rateDeviceSuitability(device);
             candidates.insert(std::make_pair(score, device));
         }
 
-        // Select the best device (highest score)
-        if (candidates.rbegin()->first == 0) {
-            res.physicalDevice = candidates.begin()->second;
+        // Select the best device (highest score); a score of 0 means the device is unsuitable
+        if (candidates.rbegin()->first > 0) {
+            res.physicalDevice = candidates.rbegin()->second;
             const auto deviceName = VulkanTools::getDeviceName(res.physicalDevice);
             core::Logger::getInstance().info("Vulkan physical device found: " + deviceName);
         } else {
@@ -235,7 +320,7 @@ namespace time_kill::graphics {
         }
     }
 
-    int VulkanContext::rateDeviceSuitability(VkPhysicalDevice device, const core::Window& window) const {
+    int VulkanContext::rateDeviceSuitability(VkPhysicalDevice device) const {
         // Properties
         VkPhysicalDeviceProperties deviceProperties;
         vkGetPhysicalDeviceProperties(device, &deviceProperties);
@@ -261,21 +346,27 @@ namespace time_kill::graphics {
 
         const auto res = resources_;
 
-        // Check the support for required queue families
-        if (const QueueFamilyIndices indices =
-            VulkanTools::findQueueFamilies(res.instance, res.surface, device); !indices.isComplete()) {
+        // Check the support for required queue families; offscreen only a graphics queue is needed
+        const QueueFamilyIndices indices = VulkanTools::findQueueFamilies(res.instance, res.surface, device);
+        if (!indices.graphicsFamily.has_value()) {
             return 0;
         }
 
-        // Check whether the GPU supports the required extensions
-        if (!checkDeviceExtensionSupport(device)) {
-            return 0;
-        }
+        if (res.surface != VK_NULL_HANDLE) {
+            if (!indices.isComplete()) {
+                return 0;
+            }
 
-        // Check swapchain support
-        SwapchainSupportDetails swapChainSupport = querySwapchainSupport(device, window);
-        if (swapChainSupport.formats.empty() || swapChainSupport.presentModes.empty()) {
-            return 0;
+            // Check whether the GPU supports the required extensions
+            if (!checkDeviceExtensionSupport(device)) {
+                return 0;
+            }
+
+            // Check swapchain support
+            SwapchainSupportDetails swapChainSupport = querySwapchainSupport(device);
+            if (swapChainSupport.formats.empty() || swapChainSupport.presentModes.empty()) {
+                return 0;
+            }
         }
 
         // Consider memory size (can be important for applications with large textures or models)
@@ -299,7 +390,7 @@ namespace time_kill::graphics {
 
         // Support for modern Vulkan features (optional)
         VkPhysicalDeviceFeatures2  supportedFeatures = {};
-        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
         vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
 
         if (supportedFeatures.features.multiViewport) {
@@ -322,7 +413,33 @@ namespace time_kill::graphics {
         return score;
     }
 
-    void VulkanContext::createLogicalDevice(const core::Window& window) {
+    usize VulkanContext::processShaderReloads() {
+        if (!shaderHotReloader_.isRunning()) {
+            return 0;
+        }
+
+        shaderHotReloader_.update();
+        const usize swapped = pipelineRegistry_.applyReloads(renderer_.getFrameNumber(), renderer_.getFramesInFlight());
+        if (swapped > 0) {
+            graphicsPipeline_.refreshGraphicsPipeline();
+        }
+        return swapped;
+    }
+
+    void VulkanContext::openShaderBundle(const VulkanConfiguration& configuration) {
+        if (configuration.shaderBundlePath.empty()) {
+            return;
+        }
+
+        const String path = VulkanTools::resolvePath(configuration, configuration.shaderBundlePath);
+        if (!std::filesystem::exists(path)) {
+            log_debug("No shader bundle at '{}'; scanning the shader directories.", path);
+            return;
+        }
+        shaderBundle_.open(path);
+    }
+
+    void VulkanContext::createLogicalDevice(const VulkanConfiguration& configuration) {
         auto& res = resources_;
 
         if (res.physicalDevice == nullptr) {
@@ -334,13 +451,16 @@ namespace time_kill::graphics {
         const auto [graphicsFamily, presentFamily] =
             VulkanTools::findQueueFamilies(res.instance, res.surface, res.physicalDevice);
 
-        if (!graphicsFamily.has_value() || !presentFamily.has_value()) {
+        // Offscreen nothing is presented, so the graphics queue stands in for the present queue
+        const bool presenting = res.surface != VK_NULL_HANDLE;
+        if (!graphicsFamily.has_value() || (presenting && !presentFamily.has_value())) {
             throw std::runtime_error("Failed to find required queue families!");
         }
+        const uint32_t presentQueueFamily = presentFamily.value_or(graphicsFamily.value());
 
         // Create a set of unique queue families
         Vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { graphicsFamily.value(), presentFamily.value() };
+        std::set<uint32_t> uniqueQueueFamilies = { graphicsFamily.value(), presentQueueFamily };
 
         // Define queue priorities
         float queuePriority = 1.0f;
@@ -355,9 +475,13 @@ namespace time_kill::graphics {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
-        //  Specify device features
+        //  Specify device features; anisotropy is optional (e.g. for software rasterizers)
+        VkPhysicalDeviceFeatures supportedDeviceFeatures = {};
+        vkGetPhysicalDeviceFeatures(res.physicalDevice, &supportedDeviceFeatures);
         VkPhysicalDeviceFeatures deviceFeatures = {};
-        deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.samplerAnisotropy = supportedDeviceFeatures.samplerAnisotropy;
+        deviceFeatures.pipelineStatisticsQuery = supportedDeviceFeatures.pipelineStatisticsQuery;
+        res.pipelineStatisticsSupported = supportedDeviceFeatures.pipelineStatisticsQuery == VK_TRUE;
         deviceFeatures.geometryShader = VK_TRUE;
 
         // Create logical device info
@@ -367,9 +491,83 @@ namespace time_kill::graphics {
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.pEnabledFeatures = &deviceFeatures;
 
-        // Enable device extensions
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(DeviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = DeviceExtensions.data();
+        // Enable device extensions; the memory budget extension only feeds allocator statistics
+        Vector<const char*> extensions;
+        if (presenting) {
+            extensions.assign(DeviceExtensions.begin(), DeviceExtensions.end());
+        }
+        res.memoryBudgetSupported = VulkanTools::isDeviceExtensionSupported(res.physicalDevice,
+                                                                            VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (res.memoryBudgetSupported) {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        // Pipeline creation feedback reports pipeline cache hits; it is core since Vulkan 1.3
+        VkPhysicalDeviceProperties deviceProperties = {};
+        vkGetPhysicalDeviceProperties(res.physicalDevice, &deviceProperties);
+        if (deviceProperties.apiVersion >= VK_API_VERSION_1_3) {
+            res.pipelineCreationFeedbackSupported = true;
+        } else if (VulkanTools::isDeviceExtensionSupported(res.physicalDevice,
+                                                           VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME)) {
+            res.pipelineCreationFeedbackSupported = true;
+            extensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+        }
+
+        // Extended dynamic state is core (and mandatory) since Vulkan 1.3
+        res.extendedDynamicStateSupported = deviceProperties.apiVersion >= VK_API_VERSION_1_3;
+
+        // Dynamic rendering is a Vulkan 1.3 feature; without it frames use the classic render pass
+        VkPhysicalDeviceVulkan13Features vulkan13Features = {};
+        vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        res.dynamicRenderingEnabled = false;
+        if (configuration.dynamicRendering && deviceProperties.apiVersion >= VK_API_VERSION_1_3) {
+            VkPhysicalDeviceFeatures2 supportedFeatures = {};
+            supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures.pNext = &vulkan13Features;
+            vkGetPhysicalDeviceFeatures2(res.physicalDevice, &supportedFeatures);
+
+            res.dynamicRenderingEnabled = vulkan13Features.dynamicRendering == VK_TRUE;
+            vulkan13Features = {};
+            vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+            vulkan13Features.dynamicRendering = VK_TRUE;
+            if (res.dynamicRenderingEnabled) {
+                createInfo.pNext = &vulkan13Features;
+            }
+        }
+        if (configuration.dynamicRendering && !res.dynamicRenderingEnabled) {
+            log_warn("Dynamic rendering is not supported by {}; using a render pass.", deviceName);
+        }
+
+        // Present wait lets the renderer block until the previous frame is on screen; it needs present ids
+        const bool waitForPresent = configuration.latencyPolicy.waitForPresent && presenting;
+        VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+        presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+        VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+        presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+        res.presentWaitSupported = false;
+        if (waitForPresent &&
+            VulkanTools::isDeviceExtensionSupported(res.physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+            VulkanTools::isDeviceExtensionSupported(res.physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+            presentIdFeatures.pNext = &presentWaitFeatures;
+            VkPhysicalDeviceFeatures2 supportedFeatures = {};
+            supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            supportedFeatures.pNext = &presentIdFeatures;
+            vkGetPhysicalDeviceFeatures2(res.physicalDevice, &supportedFeatures);
+
+            res.presentWaitSupported = presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+            if (res.presentWaitSupported) {
+                extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+                extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+                presentWaitFeatures.pNext = const_cast<void*>(createInfo.pNext);
+                createInfo.pNext = &presentIdFeatures;
+            }
+        }
+        if (waitForPresent && !res.presentWaitSupported) {
+            log_warn("Present wait is not supported by {}; latency is estimated from fences.", deviceName);
+        }
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         // Enable validation layers (if debug is enabled)
         if (debugEnabled_) {
@@ -388,8 +586,10 @@ namespace time_kill::graphics {
         }
 
         // Retrieve queue handles
+        res.graphicsQueueFamily = graphicsFamily.value();
+        res.presentQueueFamily = presentQueueFamily;
         vkGetDeviceQueue(res.logicalDevice, graphicsFamily.value(), 0, &res.graphicsQueue);
-        vkGetDeviceQueue(res.logicalDevice, presentFamily.value(), 0, &res.presentQueue);
+        vkGetDeviceQueue(res.logicalDevice, presentQueueFamily, 0, &res.presentQueue);
 
         if (res.graphicsQueue == nullptr) {
             throw std::runtime_error("Failed to create graphics queue!");
@@ -398,7 +598,16 @@ namespace time_kill::graphics {
             throw std::runtime_error("Failed to create presenting queue!");
         }
 
-        core::Logger::getInstance().debug("Created logical device for GPU: " + deviceName);
+        // Timestamp support of the graphics queue, for GPU profiling
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(res.physicalDevice, &queueFamilyCount, nullptr);
+        Vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(res.physicalDevice, &queueFamilyCount, queueFamilies.data());
+        res.timestampValidBits = queueFamilies[res.graphicsQueueFamily].timestampValidBits;
+        res.timestampPeriod = deviceProperties.limits.timestampPeriod;
+
+        log_debug("Created logical device for GPU: {}{}{}", deviceName,
+                  res.dynamicRenderingEnabled ? " (dynamic rendering)" : "", presenting ? "" : " (offscreen)");
     }
 
     void VulkanContext::logGlfwVulkanExtensions(const uint32_t extensionCount, const char** glfwExtensions) {
@@ -421,7 +630,7 @@ namespace time_kill::graphics {
             }
         });
 
-        core::Logger::getInstance().debug("GLFW required Vulkan extensions: " + extensions);
+        log_debug("GLFW required Vulkan extensions: {}", extensions);
     }
 
     bool VulkanContext::checkDeviceExtensionSupport(const VkPhysicalDevice device) {
@@ -440,10 +649,7 @@ namespace time_kill::graphics {
         return requiredExtensions.empty();
     }
 
-    SwapchainSupportDetails VulkanContext::querySwapchainSupport(
-        const VkPhysicalDevice device,
-        const core::Window& window
-    ) const {
+    SwapchainSupportDetails VulkanContext::querySwapchainSupport(const VkPhysicalDevice device) const {
         SwapchainSupportDetails details = {};
 
         const auto res = resources_;
@@ -452,9 +658,9 @@ namespace time_kill::graphics {
         vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, res.surface, &details.capabilities);
 
         // Retrieve supported Surface formats
-        uint32_t formatCount;
+        uint32_t formatCount = 0;
         vkGetPhysicalDeviceSurfaceFormatsKHR(device, res.surface, &formatCount, nullptr);
-        if (formatCount == 0) {
+        if (formatCount != 0) {
             details.formats.resize(formatCount);
             vkGetPhysicalDeviceSurfaceFormatsKHR(device, res.surface, &formatCount, details.formats.data());
         }
@@ -462,7 +668,7 @@ namespace time_kill::graphics {
         // Retrieve supported presentation modes
         uint32_t presentModeCount = 0;
         vkGetPhysicalDeviceSurfacePresentModesKHR(device, res.surface, &presentModeCount, nullptr);
-        if (presentModeCount == 0) {
+        if (presentModeCount != 0) {
             details.presentModes.resize(presentModeCount);
             vkGetPhysicalDeviceSurfacePresentModesKHR(device, res.surface, &presentModeCount, details.presentModes.data());
         }
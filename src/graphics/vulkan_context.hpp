@@ -4,9 +4,19 @@
 
 #include "core/window.hpp"
 #include "vulkan_resources.hpp"
+#include "vulkan_memory_allocator.hpp"
 #include "vulkan_swapchain.hpp"
 #include "vulkan_render_pass.hpp"
+#include "vulkan_pipeline_cache.hpp"
+#include "shader_bundle.hpp"
+#include "shader_reflection.hpp"
+#include "vulkan_layout_cache.hpp"
+#include "vulkan_pipeline_registry.hpp"
+#include "shader_hot_reloader.hpp"
 #include "vulkan_graphics_pipeline.hpp"
+#include "vulkan_renderer.hpp"
+#include "vulkan_frame_readback.hpp"
+#include "gpu_profiler.hpp"
 #include "vulkan_configuration.hpp"
 #include <vulkan/vulkan.h>
 
@@ -33,13 +43,47 @@ namespace time_kill::graphics {
         //! @param configuration
         explicit VulkanContext(const core::Window& window, const VulkanConfiguration& configuration);
 
+        //! @brief Constructs a headless VulkanContext that renders without a window, to offscreen images
+        //! or a VK_EXT_headless_surface as VulkanConfiguration::headless describes.
+        //! @param configuration
+        explicit VulkanContext(const VulkanConfiguration& configuration);
+
         //! @brief Destroys the VulkanContext and releases all allocated resources.
         ~VulkanContext();
 
         //! @brief Waits for all operations on the graphics and present queues to complete.
         void queuesWaitIdle(bool waitForDevice = false) const;
 
+        //! @brief Returns the device memory sub-allocator shared by all GPU resources.
+        [[nodiscard]] VulkanMemoryAllocator& getMemoryAllocator() { return memoryAllocator_; }
+
+        //! @brief Returns the registry that compiles and owns all graphics pipelines.
+        [[nodiscard]] VulkanPipelineRegistry& getPipelineRegistry() { return pipelineRegistry_; }
+
+        //! @brief Returns the frame loop (acquire, record, submit, present).
+        [[nodiscard]] VulkanRenderer& getRenderer() { return renderer_; }
+
+        //! @brief Returns the asynchronous frame readback; call createReadback on it before capturing.
+        [[nodiscard]] VulkanFrameReadback& getFrameReadback() { return frameReadback_; }
+
+        //! @brief Returns the GPU timestamp and pipeline statistics profiler; call createProfiler on it first.
+        [[nodiscard]] GpuProfiler& getGpuProfiler() { return gpuProfiler_; }
+
+        //! @brief Returns the Vulkan objects shared by all parts of the context.
+        [[nodiscard]] const VulkanResources& getResources() const { return resources_; }
+
+        //! @brief True if the context was created without a window.
+        [[nodiscard]] bool isHeadless() const { return headless_; }
+
+        //! @brief Picks up changed shaders and swaps in rebuilt pipelines; call once per frame, between
+        //! frames. Does nothing unless VulkanConfiguration::hotReloadShaders is set.
+        //! @return The number of pipelines swapped in.
+        usize processShaderReloads();
+
     private:
+        //! Shared by both public constructors; `window` is null for a headless context.
+        VulkanContext(const core::Window* window, const VulkanConfiguration& configuration);
+
         //=== Debug methods
 
         /// @brief Callback function used by the Vulkan validation layers to report debug messages.
@@ -56,42 +100,61 @@ namespace time_kill::graphics {
         );
 
         //! Called after the Vulkan instance is created to set up the debug messenger for validation layer messages.
-        void createDebugMessenger(const core::Window& window);
+        void createDebugMessenger();
 
         //! Called during destruction to clean up the debug messenger.
         void cleanupDebugMessenger();
 
         //=== Instance and surface creation
 
-        //! Initializes the Vulkan instance. This is the first major Vulkan object to create.
-        void createInstance(const core::Window& window);
+        //! Initializes the Vulkan instance. This is the first major Vulkan object to create. Headless, it
+        //! enables VK_EXT_headless_surface if the configuration asks for it and the loader has it.
+        void createInstance(const core::Window* window, const VulkanConfiguration& configuration);
 
         //! Creates a surface for rendering (e.g., using GLFW). This is typically done after the instance is created.
-        void createSurface(const core::Window& window);
+        //! Headless, it creates a headless surface if enabled, and no surface otherwise.
+        void createSurface(const core::Window* window);
 
         //=== Physical device selection
 
         //! Enumerates and selects a physical device (GPU) that supports the required features.
-        void pickPhysicalDevice(const core::Window& window);
+        void pickPhysicalDevice();
+
+        //! Enables dynamic rendering if the configuration asks for it and the device supports it.
+        void createLogicalDevice(const VulkanConfiguration& configuration);
 
-        void createLogicalDevice(const core::Window& window);
+        //! Opens the configured shader bundle if it exists.
+        void openShaderBundle(const VulkanConfiguration& configuration);
 
         //! A helper function used by pickPhysicalDevice to score and select the best physical device.
-        int rateDeviceSuitability(VkPhysicalDevice device, const core::Window& window) const;
+        //! Without a surface, present and swapchain support are not required.
+        int rateDeviceSuitability(VkPhysicalDevice device) const;
 
         //=== Helper methods
 
         //! A utility function to log GLFW extensions (optional, used during instance creation).
         static void logGlfwVulkanExtensions(uint32_t extensionCount, const char** glfwExtensions);
         static bool checkDeviceExtensionSupport(VkPhysicalDevice device);
-        SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device, const core::Window& window) const;
+        SwapchainSupportDetails querySwapchainSupport(VkPhysicalDevice device) const;
 
         //=== Member variables
         bool debugEnabled_ = false;                 ///< Enables debug features if true.
+        bool headless_ = false;                     ///< Created without a window.
+        bool headlessSurfaceEnabled_ = false;       ///< VK_EXT_headless_surface is enabled on the instance.
         VkDebugUtilsMessengerEXT debugMessenger_;   ///< Debug messenger for validation layers.
         VulkanResources resources_;
+        VulkanMemoryAllocator memoryAllocator_;
         VulkanSwapchain swapchain_;
         VulkanRenderPass renderPass_;
+        VulkanPipelineCache pipelineCache_;
+        ShaderBundle shaderBundle_;
+        ShaderReflectionCache reflectionCache_;
+        VulkanLayoutCache layoutCache_;
+        VulkanPipelineRegistry pipelineRegistry_;
         VulkanGraphicsPipeline graphicsPipeline_;
+        ShaderHotReloader shaderHotReloader_;
+        VulkanRenderer renderer_;
+        VulkanFrameReadback frameReadback_;
+        GpuProfiler gpuProfiler_;
     };
 }
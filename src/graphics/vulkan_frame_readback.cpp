@@ -0,0 +1,250 @@
+#include "vulkan_frame_readback.hpp"
+#include "core/logger.hpp"
+#include "utils/image_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <fstream>
+
+namespace time_kill::graphics {
+    VulkanFrameReadback::VulkanFrameReadback(VulkanResources& resources, VulkanMemoryAllocator& memoryAllocator)
+        : resources_(resources), memoryAllocator_(memoryAllocator) {}
+
+    VulkanFrameReadback::~VulkanFrameReadback() {
+        destroyReadback();
+    }
+
+    void VulkanFrameReadback::createReadback(const uint32_t slotCount) {
+        if (resources_.logicalDevice == VK_NULL_HANDLE) {
+            throw std::runtime_error("Unable to create frame readback; logical device is null!");
+        }
+        if (slotCount == 0) {
+            throw std::runtime_error("Unable to create frame readback; at least one staging buffer is required!");
+        }
+
+        destroyReadback();
+        slots_.resize(slotCount);
+        capturedCount_ = 0;
+        skippedCount_ = 0;
+
+        log_debug("Created frame readback with {} staging buffers.", slotCount);
+    }
+
+    void VulkanFrameReadback::destroyReadback() {
+        if (slots_.empty()) {
+            return;
+        }
+
+        // Copies may still be executing
+        vkDeviceWaitIdle(resources_.logicalDevice);
+
+        for (auto& slot : slots_) {
+            destroySlot(slot);
+        }
+        slots_.clear();
+    }
+
+    bool VulkanFrameReadback::capture(const FrameContext& frame) {
+        const auto& res = resources_;
+
+        const uint32_t bytesPerPixel = getBytesPerPixel(res.swapchainImageFormat);
+        if (bytesPerPixel == 0) {
+            throw std::runtime_error("Unable to read back frame; unsupported color target format!");
+        }
+        if (!res.colorTargetReadable) {
+            throw std::runtime_error("Unable to read back frame; the color target does not allow transfer reads!");
+        }
+
+        const auto it = std::ranges::find(slots_, SlotState::Free, &Slot::state);
+        if (it == slots_.end()) {
+            ++skippedCount_;
+            return false;
+        }
+        Slot& slot = *it;
+
+        const VkDeviceSize size = VkDeviceSize(frame.extent.width) * frame.extent.height * bytesPerPixel;
+        ensureCapacity(slot, size);
+
+        // The color target was just written by the render pass (and is still to be presented). The
+        // render pass' outgoing dependency, or the barrier after dynamic rendering, already made those
+        // writes visible to transfers; this barrier chains onto its transfer stage scope
+        std::array<VkImageMemoryBarrier, 2> imageBarriers = {};
+        imageBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarriers[0].srcAccessMask = 0;
+        imageBarriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarriers[0].oldLayout = res.colorTargetLayout;
+        imageBarriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarriers[0].image = frame.image;
+        imageBarriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imageBarriers[0]);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;     // Tightly packed
+        region.bufferImageHeight = 0;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { frame.extent.width, frame.extent.height, 1 };
+        vkCmdCopyImageToBuffer(frame.commandBuffer, frame.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               slot.buffer, 1, &region);
+
+        // Make the copy visible to the host, and give the image back its end-of-frame layout
+        VkBufferMemoryBarrier bufferBarrier = {};
+        bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        bufferBarrier.buffer = slot.buffer;
+        bufferBarrier.offset = 0;
+        bufferBarrier.size = size;
+
+        imageBarriers[1] = imageBarriers[0];
+        imageBarriers[1].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarriers[1].dstAccessMask = 0;
+        imageBarriers[1].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarriers[1].newLayout = res.colorTargetLayout;
+
+        vkCmdPipelineBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                             0, nullptr, 1, &bufferBarrier, 1, &imageBarriers[1]);
+
+        slot.state = SlotState::Pending;
+        slot.frameNumber = frame.frameNumber;
+        slot.extent = frame.extent;
+        slot.format = res.swapchainImageFormat;
+        ++capturedCount_;
+        return true;
+    }
+
+    Optional<ReadbackImage> VulkanFrameReadback::poll(const u64 completedFrames) {
+        Slot* oldest = nullptr;
+        for (auto& slot : slots_) {
+            if (slot.state == SlotState::Pending && slot.frameNumber < completedFrames &&
+                (oldest == nullptr || slot.frameNumber < oldest->frameNumber)) {
+                oldest = &slot;
+            }
+        }
+        if (oldest == nullptr) {
+            return std::nullopt;
+        }
+
+        // The memory is host-coherent and the frame's fence has signaled; no invalidate or copy needed
+        oldest->state = SlotState::Held;
+
+        const uint32_t bytesPerPixel = getBytesPerPixel(oldest->format);
+        ReadbackImage image;
+        image.frameNumber = oldest->frameNumber;
+        image.extent = oldest->extent;
+        image.format = oldest->format;
+        image.rowPitch = oldest->extent.width * bytesPerPixel;
+        image.pixels = { static_cast<const u8*>(oldest->allocation.mappedData),
+                         usize(image.rowPitch) * oldest->extent.height };
+        image.slot = static_cast<uint32_t>(oldest - slots_.data());
+        return image;
+    }
+
+    void VulkanFrameReadback::release(const ReadbackImage& image) {
+        if (image.slot >= slots_.size() || slots_[image.slot].state != SlotState::Held) {
+            log_warn("Released frame readback image {} that is not held.", image.frameNumber);
+            return;
+        }
+        slots_[image.slot].state = SlotState::Free;
+    }
+
+    void VulkanFrameReadback::writeImage(std::ostream& out, const ReadbackImage& image, const ImageFileFormat format) {
+        const uint32_t width = image.extent.width;
+        const uint32_t height = image.extent.height;
+
+        if (format == ImageFileFormat::Raw) {
+            out.write(reinterpret_cast<const char*>(image.pixels.data()), static_cast<std::streamsize>(image.pixels.size()));
+            if (!out) {
+                throw std::runtime_error("Failed to write raw image");
+            }
+            return;
+        }
+
+        // Reorder into RGB(A) rows; SRGB formats already hold display-ready values
+        const bool bgra = isBgra(image.format);
+        const uint32_t channels = format == ImageFileFormat::Ppm ? 3 : 4;
+        Vector<u8> pixels(usize(width) * height * channels);
+        for (uint32_t y = 0; y < height; ++y) {
+            const u8* source = image.pixels.data() + usize(y) * image.rowPitch;
+            u8* target = pixels.data() + usize(y) * width * channels;
+            for (uint32_t x = 0; x < width; ++x, source += 4, target += channels) {
+                target[0] = bgra ? source[2] : source[0];
+                target[1] = source[1];
+                target[2] = bgra ? source[0] : source[2];
+                if (channels == 4) {
+                    target[3] = source[3];
+                }
+            }
+        }
+
+        if (format == ImageFileFormat::Ppm) {
+            utils::writePpm(out, width, height, pixels);
+        } else {
+            utils::writePng(out, width, height, pixels);
+        }
+    }
+
+    void VulkanFrameReadback::saveImage(const ReadbackImage& image, const String& path, const ImageFileFormat format) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open image file: " + path);
+        }
+        writeImage(file, image, format);
+    }
+
+    void VulkanFrameReadback::ensureCapacity(Slot& slot, const VkDeviceSize size) const {
+        if (slot.capacity >= size) {
+            return;
+        }
+        destroySlot(slot);
+
+        VkBufferCreateInfo bufferInfo = {};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateBuffer(resources_.logicalDevice, &bufferInfo, nullptr, &slot.buffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create readback staging buffer!");
+        }
+        try {
+            slot.allocation = memoryAllocator_.allocateForBuffer(slot.buffer, MemoryUsage::Readback);
+        } catch (const std::exception&) {
+            destroySlot(slot);
+            throw;
+        }
+        slot.capacity = size;
+    }
+
+    void VulkanFrameReadback::destroySlot(Slot& slot) const {
+        if (slot.buffer != VK_NULL_HANDLE) {
+            vkDestroyBuffer(resources_.logicalDevice, slot.buffer, nullptr);
+            slot.buffer = VK_NULL_HANDLE;
+        }
+        memoryAllocator_.free(slot.allocation);
+        slot.capacity = 0;
+    }
+
+    uint32_t VulkanFrameReadback::getBytesPerPixel(const VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+    bool VulkanFrameReadback::isBgra(const VkFormat format) {
+        return format == VK_FORMAT_B8G8R8A8_UNORM || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+}
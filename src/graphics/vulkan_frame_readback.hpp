@@ -0,0 +1,101 @@
+#pragma once
+
+#include "graphics/vulkan_resources.hpp"
+#include "graphics/vulkan_renderer.hpp"
+#include <ostream>
+#include <span>
+
+namespace time_kill::graphics {
+    enum class ImageFileFormat : u8 {
+        Ppm,    //!< Binary PPM (P6), RGB
+        Png,    //!< PNG, RGBA, uncompressed
+        Raw     //!< The pixels as read back, in the color target's format, without a header
+    };
+
+    //! A frame read back by VulkanFrameReadback. `pixels` points into the mapped staging buffer: it is
+    //! valid until the image is handed back with VulkanFrameReadback::release.
+    struct ReadbackImage {
+        u64 frameNumber = 0;
+        VkExtent2D extent = {};
+        VkFormat format = VK_FORMAT_UNDEFINED;  //!< 8-bit RGBA or BGRA, UNORM or SRGB
+        uint32_t rowPitch = 0;                  //!< Bytes per row; rows are tightly packed
+        std::span<const u8> pixels;             //!< Top row first
+        uint32_t slot = 0;                      //!< Staging buffer it lives in
+    };
+
+    //! Reads rendered frames back to CPU memory without stalling the frame loop.
+    //!
+    //! capture() records a copy of the frame's color target into one of a ring of host-visible
+    //! staging buffers, in the frame's own command buffer. The copy is picked up frames later by
+    //! poll(), once the renderer's fences report the frame complete, and handed out as a view of the
+    //! mapped memory: nothing is copied on the CPU. If every staging buffer is still pending or held,
+    //! the frame is skipped rather than waited for.
+    //!
+    //! Staging buffers are (re)allocated on demand when the target size changes. Use from the thread
+    //! that drives the frame loop only.
+    class VulkanFrameReadback {
+    public:
+        VulkanFrameReadback(VulkanResources& resources, VulkanMemoryAllocator& memoryAllocator);
+        ~VulkanFrameReadback();
+
+        VulkanFrameReadback(const VulkanFrameReadback&) = delete;
+        VulkanFrameReadback& operator=(const VulkanFrameReadback&) = delete;
+
+        //! Sets up `slotCount` staging buffers. Copies complete after the frames in flight, so the ring
+        //! needs more slots than frames in flight plus the images the app holds at once.
+        void createReadback(uint32_t slotCount);
+
+        //! Waits for the device and frees all staging buffers; held images become dangling.
+        void destroyReadback();
+
+        //! Records the copy of `frame`'s color target; call after endRenderPass and before endFrame.
+        //! Returns false if no staging buffer is free and the frame was skipped. Throws if the color
+        //! target cannot be read back (unsupported format or usage).
+        bool capture(const FrameContext& frame);
+
+        //! Returns the oldest captured frame below `completedFrames` (see
+        //! VulkanRenderer::getCompletedFrameCount), or nothing if none is complete yet.
+        [[nodiscard]] Optional<ReadbackImage> poll(u64 completedFrames);
+
+        //! Hands the staging buffer of `image` back to the ring.
+        void release(const ReadbackImage& image);
+
+        //! Writes `image` in `format`; PPM and PNG convert to RGB(A) order. Throws on errors.
+        static void writeImage(std::ostream& out, const ReadbackImage& image, ImageFileFormat format);
+        static void saveImage(const ReadbackImage& image, const String& path, ImageFileFormat format);
+
+        [[nodiscard]] uint32_t getSlotCount() const { return static_cast<uint32_t>(slots_.size()); }
+        [[nodiscard]] u64 getCapturedCount() const { return capturedCount_; }
+        [[nodiscard]] u64 getSkippedCount() const { return skippedCount_; }
+
+    private:
+        enum class SlotState : u8 {
+            Free,
+            Pending,    // Copy recorded, frame not known to be complete
+            Held        // Handed out by poll, waiting for release
+        };
+
+        struct Slot {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            MemoryAllocation allocation;
+            VkDeviceSize capacity = 0;
+            SlotState state = SlotState::Free;
+            u64 frameNumber = 0;
+            VkExtent2D extent = {};
+            VkFormat format = VK_FORMAT_UNDEFINED;
+        };
+
+        void ensureCapacity(Slot& slot, VkDeviceSize size) const;
+        void destroySlot(Slot& slot) const;
+
+        //! 4 for the supported 8-bit RGBA/BGRA formats, 0 for everything else.
+        static uint32_t getBytesPerPixel(VkFormat format);
+        static bool isBgra(VkFormat format);
+
+        VulkanResources& resources_;
+        VulkanMemoryAllocator& memoryAllocator_;
+        Vector<Slot> slots_;
+        u64 capturedCount_ = 0;
+        u64 skippedCount_ = 0;
+    };
+}
@@ -2,29 +2,36 @@
 
 #include "graphics/vulkan_resources.hpp"
 #include "graphics/vulkan_configuration.hpp"
-
-namespace time_kill::core {
-    class Window;
-}
+#include "graphics/vulkan_pipeline_registry.hpp"
+#include "graphics/shader_bundle.hpp"
 
 namespace time_kill::graphics {
     //! The graphics pipeline in Vulkan is responsible for processing and rendering graphics on the GPU.
     //! It consists of several stages, ranging from the processing of the input data to the final display
     //! on the screen. In contrast to OpenGL, where many things are configured at runtime, in Vulkan the
     //! entire pipeline must be created and optimised in advance.
+    //!
+    //! This is the default pipeline built from the configured shader directories; it is compiled
+    //! through the pipeline registry and published as VulkanResources::graphicsPipeline.
     class VulkanGraphicsPipeline {
     public:
-        explicit VulkanGraphicsPipeline(VulkanResources& resources);
+        explicit VulkanGraphicsPipeline(VulkanResources& resources, VulkanPipelineRegistry& pipelineRegistry);
         ~VulkanGraphicsPipeline();
 
-        void createGraphicsPipeline(const core::Window& window, const VulkanConfiguration& configuration) const;
-        void destroyGraphicsPipeline() const;
+        //! Uses every shader of `shaderBundle` if it is open, otherwise the configured shader directories.
+        void createGraphicsPipeline(const VulkanConfiguration& configuration, const ShaderBundle& shaderBundle);
 
-    private:
+        //! Releases the pipeline; the registry destroys it.
+        void destroyGraphicsPipeline();
 
-        static Vector<char> readSpirvFile(const String& filename);
-        static VkShaderModule createShaderModule(const Vector<char>& code, VkDevice device, const String& filename);
+        //! Publishes the current pipeline of the handle again, after a hot reload swapped it.
+        void refreshGraphicsPipeline();
 
+        [[nodiscard]] const PipelineHandle& getHandle() const { return handle_; }
+
+    private:
         VulkanResources& resources_;
+        VulkanPipelineRegistry& pipelineRegistry_;
+        PipelineHandle handle_;
     };
 }
@@ -0,0 +1,215 @@
+#include "vulkan_layout_cache.hpp"
+#include "shader_reflection.hpp"
+#include "core/logger.hpp"
+#include "utils/hash.hpp"
+#include <algorithm>
+#include <map>
+#include <ranges>
+
+namespace time_kill::graphics {
+    namespace {
+        void hashBinding(utils::Hasher& hasher, const VkDescriptorSetLayoutBinding& binding) {
+            hasher.add(binding.binding)
+                  .add(binding.descriptorType)
+                  .add(binding.descriptorCount)
+                  .add(binding.stageFlags);
+        }
+
+        void hashPushConstantRange(utils::Hasher& hasher, const VkPushConstantRange& range) {
+            hasher.add(range.stageFlags).add(range.offset).add(range.size);
+        }
+
+        // Compare what is hashed; immutable samplers are never used
+        bool isSameBinding(const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) {
+            return a.binding == b.binding && a.descriptorType == b.descriptorType &&
+                   a.descriptorCount == b.descriptorCount && a.stageFlags == b.stageFlags;
+        }
+
+        bool isSamePushConstantRange(const VkPushConstantRange& a, const VkPushConstantRange& b) {
+            return a.stageFlags == b.stageFlags && a.offset == b.offset && a.size == b.size;
+        }
+    }
+
+    //=== PipelineInterface
+
+    PipelineInterface PipelineInterface::merge(const std::span<const SharedPtr<const ShaderReflection>> stages,
+                                               const StringView pipelineName) {
+        PipelineInterface shaderInterface;
+
+        // Descriptor bindings, keyed by (set, binding)
+        std::map<std::pair<u32, u32>, VkDescriptorSetLayoutBinding> bindings;
+        for (const auto& stage : stages) {
+            for (const auto& descriptor : stage->descriptorBindings) {
+                auto [it, inserted] = bindings.try_emplace({ descriptor.set, descriptor.binding });
+                auto& binding = it->second;
+                if (inserted) {
+                    binding.binding = descriptor.binding;
+                    binding.descriptorType = descriptor.type;
+                    binding.descriptorCount = descriptor.count;
+                    binding.stageFlags = stage->stage;
+                    binding.pImmutableSamplers = nullptr;
+                    continue;
+                }
+                if (binding.descriptorType != descriptor.type) {
+                    throw std::runtime_error(std::format("Pipeline '{}': set {} binding {} is declared with different "
+                                                         "descriptor types in different stages!",
+                                                         pipelineName, descriptor.set, descriptor.binding));
+                }
+                binding.descriptorCount = std::max(binding.descriptorCount, descriptor.count);
+                binding.stageFlags |= stage->stage;
+            }
+        }
+        for (const auto& [location, binding] : bindings) {
+            if (shaderInterface.descriptorSets.size() <= location.first) {
+                shaderInterface.descriptorSets.resize(location.first + 1);
+            }
+            shaderInterface.descriptorSets[location.first].push_back(binding);
+        }
+
+        // Vulkan allows each stage in at most one push-constant range: cover all blocks of a stage
+        // with one range, then share ranges between stages that use the same bytes
+        Vector<VkPushConstantRange> stageRanges;
+        for (const auto& stage : stages) {
+            if (stage->pushConstantRanges.empty()) {
+                continue;
+            }
+            u32 begin = UINT32_MAX, end = 0;
+            for (const auto& range : stage->pushConstantRanges) {
+                begin = std::min(begin, range.offset);
+                end = std::max(end, range.offset + range.size);
+            }
+            stageRanges.push_back({ static_cast<VkShaderStageFlags>(stage->stage), begin, end - begin });
+        }
+        for (const auto& range : stageRanges) {
+            const auto shared = std::ranges::find_if(shaderInterface.pushConstantRanges, [&range](const auto& other) {
+                return other.offset == range.offset && other.size == range.size;
+            });
+            if (shared != shaderInterface.pushConstantRanges.end()) {
+                shared->stageFlags |= range.stageFlags;
+            } else {
+                shaderInterface.pushConstantRanges.push_back(range);
+            }
+        }
+
+        return shaderInterface;
+    }
+
+    //=== VulkanLayoutCache
+
+    VulkanLayoutCache::VulkanLayoutCache(VulkanResources& resources) : resources_(resources) {}
+
+    VulkanLayoutCache::~VulkanLayoutCache() {
+        destroyLayouts();
+    }
+
+    void VulkanLayoutCache::destroyLayouts() {
+        const auto& res = resources_;
+        std::lock_guard lock(mutex_);
+        if (pipelineLayouts_.empty() && descriptorSetLayouts_.empty()) {
+            return;
+        }
+
+        for (const auto& entry : pipelineLayouts_ | std::views::values) {
+            vkDestroyPipelineLayout(res.logicalDevice, entry.layout, nullptr);
+        }
+        for (const auto& entry : descriptorSetLayouts_ | std::views::values) {
+            vkDestroyDescriptorSetLayout(res.logicalDevice, entry.layout, nullptr);
+        }
+        log_debug("Destroyed {} pipeline layouts and {} descriptor set layouts.",
+                  pipelineLayouts_.size(), descriptorSetLayouts_.size());
+        pipelineLayouts_.clear();
+        descriptorSetLayouts_.clear();
+    }
+
+    VkDescriptorSetLayout VulkanLayoutCache::getDescriptorSetLayout(const std::span<const VkDescriptorSetLayoutBinding> bindings) {
+        const auto& res = resources_;
+
+        utils::Hasher hasher;
+        hasher.add(bindings.size());
+        for (const auto& binding : bindings) {
+            hashBinding(hasher, binding);
+        }
+        const u64 key = hasher.get();
+
+        // Layout creation is cheap, so it is done under the lock to never create duplicates
+        std::lock_guard lock(mutex_);
+        const auto [first, last] = descriptorSetLayouts_.equal_range(key);
+        for (auto it = first; it != last; ++it) {
+            if (std::ranges::equal(it->second.bindings, bindings, isSameBinding)) {
+                return it->second.layout;
+            }
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+
+        VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+        if (vkCreateDescriptorSetLayout(res.logicalDevice, &layoutInfo, nullptr, &layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create descriptor set layout!");
+        }
+        descriptorSetLayouts_.emplace(key, DescriptorSetLayoutEntry { { bindings.begin(), bindings.end() }, layout });
+        log_trace("Created descriptor set layout with {} bindings ({:016x}).", bindings.size(), key);
+        return layout;
+    }
+
+    PipelineLayoutHandle VulkanLayoutCache::getPipelineLayout(const PipelineInterface& shaderInterface) {
+        const auto& res = resources_;
+
+        PipelineLayoutHandle handle;
+        handle.descriptorSetLayouts.reserve(shaderInterface.descriptorSets.size());
+        for (const auto& bindings : shaderInterface.descriptorSets) {
+            handle.descriptorSetLayouts.push_back(getDescriptorSetLayout(bindings));
+        }
+
+        // Equal set layouts are equal handles, so hashing the handles identifies the layout
+        utils::Hasher hasher;
+        hasher.add(handle.descriptorSetLayouts.size());
+        for (const auto setLayout : handle.descriptorSetLayouts) {
+            hasher.add(reinterpret_cast<std::uintptr_t>(setLayout));
+        }
+        hasher.add(shaderInterface.pushConstantRanges.size());
+        for (const auto& range : shaderInterface.pushConstantRanges) {
+            hashPushConstantRange(hasher, range);
+        }
+        const u64 key = hasher.get();
+
+        std::lock_guard lock(mutex_);
+        const auto [first, last] = pipelineLayouts_.equal_range(key);
+        for (auto it = first; it != last; ++it) {
+            if (it->second.descriptorSetLayouts == handle.descriptorSetLayouts &&
+                std::ranges::equal(it->second.pushConstantRanges, shaderInterface.pushConstantRanges,
+                                   isSamePushConstantRange)) {
+                handle.layout = it->second.layout;
+                return handle;
+            }
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(handle.descriptorSetLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = handle.descriptorSetLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(shaderInterface.pushConstantRanges.size());
+        pipelineLayoutInfo.pPushConstantRanges = shaderInterface.pushConstantRanges.data();
+
+        if (vkCreatePipelineLayout(res.logicalDevice, &pipelineLayoutInfo, nullptr, &handle.layout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+        pipelineLayouts_.emplace(key, PipelineLayoutEntry { handle.descriptorSetLayouts,
+                                                            shaderInterface.pushConstantRanges, handle.layout });
+        log_trace("Created pipeline layout with {} sets and {} push-constant ranges ({:016x}).",
+                  handle.descriptorSetLayouts.size(), shaderInterface.pushConstantRanges.size(), key);
+        return handle;
+    }
+
+    usize VulkanLayoutCache::getDescriptorSetLayoutCount() const {
+        std::lock_guard lock(mutex_);
+        return descriptorSetLayouts_.size();
+    }
+
+    usize VulkanLayoutCache::getPipelineLayoutCount() const {
+        std::lock_guard lock(mutex_);
+        return pipelineLayouts_.size();
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "graphics/vulkan_resources.hpp"
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+namespace time_kill::graphics {
+    struct ShaderReflection;
+
+    //! Descriptor and push-constant interface of a whole pipeline, merged over all its stages.
+    struct PipelineInterface {
+        //! Bindings per descriptor set index; sets a pipeline skips are present but empty.
+        Vector<Vector<VkDescriptorSetLayoutBinding>> descriptorSets;
+        Vector<VkPushConstantRange> pushConstantRanges;
+
+        //! Merges the reflections of all stages of a pipeline. A binding used by several stages gets
+        //! the union of their stage flags; push-constant ranges are merged per stage. Throws if two
+        //! stages declare the same binding with different descriptor types.
+        static PipelineInterface merge(std::span<const SharedPtr<const ShaderReflection>> stages, StringView pipelineName);
+    };
+
+    //! A pipeline layout owned by VulkanLayoutCache, with the descriptor set layouts it was built from.
+    struct PipelineLayoutHandle {
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+        Vector<VkDescriptorSetLayout> descriptorSetLayouts;   //!< Indexed by set number
+    };
+
+    //! Creates and owns descriptor set layouts and pipeline layouts, deduplicated by their contents.
+    //!
+    //! Pipelines with the same shader interface get the very same VkPipelineLayout, and pipelines
+    //! sharing a set layout get the same VkDescriptorSetLayout, so descriptor sets bound for one
+    //! pipeline stay valid after switching to another (pipeline layout compatibility). Thread-safe;
+    //! called from the pipeline compile jobs.
+    class VulkanLayoutCache {
+    public:
+        explicit VulkanLayoutCache(VulkanResources& resources);
+        ~VulkanLayoutCache();
+
+        VulkanLayoutCache(const VulkanLayoutCache&) = delete;
+        VulkanLayoutCache& operator=(const VulkanLayoutCache&) = delete;
+
+        //! Destroys all layouts. No pipeline using them may still exist.
+        void destroyLayouts();
+
+        [[nodiscard]] VkDescriptorSetLayout getDescriptorSetLayout(std::span<const VkDescriptorSetLayoutBinding> bindings);
+        [[nodiscard]] PipelineLayoutHandle getPipelineLayout(const PipelineInterface& shaderInterface);
+
+        [[nodiscard]] usize getDescriptorSetLayoutCount() const;
+        [[nodiscard]] usize getPipelineLayoutCount() const;
+
+    private:
+        // The contents are kept to tell hash collisions from equal layouts
+        struct DescriptorSetLayoutEntry {
+            Vector<VkDescriptorSetLayoutBinding> bindings;
+            VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+        };
+
+        struct PipelineLayoutEntry {
+            Vector<VkDescriptorSetLayout> descriptorSetLayouts;
+            Vector<VkPushConstantRange> pushConstantRanges;
+            VkPipelineLayout layout = VK_NULL_HANDLE;
+        };
+
+        VulkanResources& resources_;
+
+        mutable std::mutex mutex_;
+        std::unordered_multimap<u64, DescriptorSetLayoutEntry> descriptorSetLayouts_;
+        std::unordered_multimap<u64, PipelineLayoutEntry> pipelineLayouts_;
+    };
+}
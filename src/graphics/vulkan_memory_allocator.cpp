@@ -0,0 +1,450 @@
+#include "vulkan_memory_allocator.hpp"
+#include "vulkan_resources.hpp"
+#include "core/logger.hpp"
+#include <algorithm>
+#include <bit>
+#include <unordered_map>
+
+namespace time_kill::graphics {
+    struct MemoryBlock {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+        uint32_t memoryType = 0;
+        MemoryPool pool = MemoryPool::Linear;
+        bool dedicated = false;
+        utils::BuddyAllocator buddy;                                   // Unused for dedicated blocks
+        std::unordered_map<VkDeviceSize, VkDeviceSize> requestedSizes; // Live offset -> requested size
+
+        [[nodiscard]] bool isEmpty() const { return requestedSizes.empty(); }
+        [[nodiscard]] VkDeviceSize getAllocatedBytes() const {
+            return dedicated ? (isEmpty() ? 0 : size) : buddy.getUsed();
+        }
+    };
+
+    namespace {
+        constexpr f64 MiB = 1024.0 * 1024.0;
+
+        constexpr uint32_t PoolsPerMemoryType = 2;
+
+        // Without VK_EXT_memory_budget, assume the process may use this share of a heap
+        constexpr VkDeviceSize FallbackBudgetPercent = 80;
+
+        MemoryAllocation makeAllocation(MemoryBlock& block, const VkDeviceSize offset, const VkDeviceSize size) {
+            MemoryAllocation allocation;
+            allocation.memory = block.memory;
+            allocation.offset = offset;
+            allocation.size = size;
+            allocation.mappedData = block.mapped != nullptr ? static_cast<u8*>(block.mapped) + offset : nullptr;
+            allocation.memoryType = block.memoryType;
+            allocation.block = &block;
+            return allocation;
+        }
+    }
+
+    VulkanMemoryAllocator::VulkanMemoryAllocator(VulkanResources& resources) : resources_(resources) {}
+
+    VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+        destroyAllocator();
+    }
+
+    void VulkanMemoryAllocator::createAllocator(const MemoryAllocatorConfig& config) {
+        const auto& res = resources_;
+        if (res.physicalDevice == VK_NULL_HANDLE || res.logicalDevice == VK_NULL_HANDLE) {
+            throw std::runtime_error("Unable to create memory allocator; physical and logical device are required!");
+        }
+
+        destroyAllocator();
+
+        std::lock_guard lock(mutex_);
+        config_ = config;
+        config_.blockSize = std::bit_ceil(std::max(config_.blockSize, config_.minAllocationSize));
+        config_.minAllocationSize = std::bit_ceil(std::max<VkDeviceSize>(config_.minAllocationSize, 1));
+
+        vkGetPhysicalDeviceMemoryProperties(res.physicalDevice, &memoryProperties_);
+
+        // Small heaps (e.g. a 256 MiB host-visible VRAM window) get smaller blocks
+        heapBlockSizes_.resize(memoryProperties_.memoryHeapCount);
+        for (uint32_t heap = 0; heap < memoryProperties_.memoryHeapCount; ++heap) {
+            const VkDeviceSize heapSize = memoryProperties_.memoryHeaps[heap].size;
+            const VkDeviceSize maxBlockSize = std::bit_floor(std::max<VkDeviceSize>(heapSize / 8, config_.minAllocationSize));
+            heapBlockSizes_[heap] = std::min(config_.blockSize, maxBlockSize);
+        }
+
+        pools_.resize(static_cast<usize>(memoryProperties_.memoryTypeCount) * PoolsPerMemoryType);
+
+        log_debug("Created memory allocator ({} MiB blocks, {} memory types, budget extension {}).",
+                  config_.blockSize / (1024 * 1024), memoryProperties_.memoryTypeCount,
+                  res.memoryBudgetSupported ? "enabled" : "unavailable");
+    }
+
+    void VulkanMemoryAllocator::destroyAllocator() {
+        std::lock_guard lock(mutex_);
+        if (pools_.empty()) {
+            return;
+        }
+
+        usize leaked = 0;
+        for (auto& pool : pools_) {
+            for (const auto& block : pool) {
+                leaked += block->requestedSizes.size();
+                destroyBlock(*block);
+            }
+        }
+        pools_.clear();
+        heapBlockSizes_.clear();
+
+        if (leaked > 0) {
+            log_warn("Memory allocator destroyed with {} allocations still alive.", leaked);
+        }
+    }
+
+    MemoryAllocation VulkanMemoryAllocator::allocate(const VkMemoryRequirements& requirements, const MemoryUsage usage,
+                                                     const MemoryPool pool) {
+        VkMemoryPropertyFlags required = 0;
+        VkMemoryPropertyFlags preferred = 0;
+        switch (usage) {
+            case MemoryUsage::GpuOnly:
+                preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+                break;
+            case MemoryUsage::Upload:
+                required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+                break;
+            case MemoryUsage::Readback:
+                required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+                preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+                break;
+        }
+
+        std::lock_guard lock(mutex_);
+        if (pools_.empty()) {
+            throw std::runtime_error("Memory allocator has not been created!");
+        }
+
+        const auto memoryType = findMemoryType(requirements.memoryTypeBits, required, preferred);
+        if (!memoryType) {
+            throw std::runtime_error("Failed to find a suitable memory type!");
+        }
+
+        const uint32_t heap = memoryProperties_.memoryTypes[*memoryType].heapIndex;
+        const VkDeviceSize blockSize = heapBlockSizes_[heap];
+
+        // Large resources get their own memory instead of most of a block
+        if (requirements.size >= config_.dedicatedThreshold || requirements.size > blockSize / 2) {
+            MemoryBlock& block = createBlock(*memoryType, pool, requirements.size, true);
+            block.requestedSizes.emplace(0, requirements.size);
+            return makeAllocation(block, 0, requirements.size);
+        }
+
+        const usize index = poolIndex(*memoryType, pool);
+        if (auto allocation = allocateFromBlocks(index, requirements.size, requirements.alignment)) {
+            return *allocation;
+        }
+
+        createBlock(*memoryType, pool, blockSize, false);
+        if (auto allocation = allocateFromBlocks(index, requirements.size, requirements.alignment)) {
+            return *allocation;
+        }
+        throw std::runtime_error("Failed to sub-allocate " + std::to_string(requirements.size) + " bytes from a new block!");
+    }
+
+    MemoryAllocation VulkanMemoryAllocator::allocateForImage(const VkImage image, const MemoryUsage usage,
+                                                             const VkImageTiling tiling) {
+        const auto& res = resources_;
+
+        VkMemoryRequirements requirements;
+        vkGetImageMemoryRequirements(res.logicalDevice, image, &requirements);
+
+        MemoryAllocation allocation = allocate(requirements, usage,
+                                               tiling == VK_IMAGE_TILING_OPTIMAL ? MemoryPool::Optimal : MemoryPool::Linear);
+        if (vkBindImageMemory(res.logicalDevice, image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+            free(allocation);
+            throw std::runtime_error("Failed to bind image memory!");
+        }
+        return allocation;
+    }
+
+    MemoryAllocation VulkanMemoryAllocator::allocateForBuffer(const VkBuffer buffer, const MemoryUsage usage) {
+        const auto& res = resources_;
+
+        VkMemoryRequirements requirements;
+        vkGetBufferMemoryRequirements(res.logicalDevice, buffer, &requirements);
+
+        MemoryAllocation allocation = allocate(requirements, usage, MemoryPool::Linear);
+        if (vkBindBufferMemory(res.logicalDevice, buffer, allocation.memory, allocation.offset) != VK_SUCCESS) {
+            free(allocation);
+            throw std::runtime_error("Failed to bind buffer memory!");
+        }
+        return allocation;
+    }
+
+    void VulkanMemoryAllocator::free(MemoryAllocation& allocation) {
+        if (!allocation.isValid() || allocation.block == nullptr) {
+            return;
+        }
+
+        std::lock_guard lock(mutex_);
+        MemoryBlock& block = *allocation.block;
+        const usize index = poolIndex(block.memoryType, block.pool);
+
+        releaseFromBlock(block, allocation.offset);
+        allocation = {};
+
+        if (block.dedicated) {
+            trimEmptyBlocks(index, UINT32_MAX);
+        } else if (block.isEmpty()) {
+            trimEmptyBlocks(index, config_.maxEmptyBlocks);
+        }
+    }
+
+    DefragmentationResult VulkanMemoryAllocator::defragment(const MoveCallback& move, const f32 maxBlockUsage) {
+        struct PlannedMove {
+            MemoryAllocation source;
+            MemoryAllocation target;
+            usize pool = 0;
+            bool moved = false;
+        };
+
+        // Plan under the lock: reserve a target for every allocation to evacuate. The sources stay
+        // allocated until the moves are committed, so nothing else can take their place meanwhile
+        Vector<PlannedMove> moves;
+        {
+            std::lock_guard lock(mutex_);
+            for (usize index = 0; index < pools_.size(); ++index) {
+                auto& pool = pools_[index];
+
+                // Sparsest blocks first; they are emptied into the fuller ones
+                Vector<MemoryBlock*> candidates;
+                for (const auto& block : pool) {
+                    if (!block->dedicated && !block->isEmpty() &&
+                        static_cast<f32>(block->getAllocatedBytes()) <= maxBlockUsage * static_cast<f32>(block->size)) {
+                        candidates.push_back(block.get());
+                    }
+                }
+                if (candidates.empty() || candidates.size() == pool.size()) {
+                    continue; // Nothing sparse, or nowhere to move to
+                }
+                std::ranges::sort(candidates, {}, &MemoryBlock::getAllocatedBytes);
+
+                for (MemoryBlock* block : candidates) {
+                    for (const VkDeviceSize offset : block->buddy.getAllocatedOffsets()) {
+                        const VkDeviceSize size = block->requestedSizes.at(offset);
+                        // The block size is the allocation's alignment, so the new place is aligned just as well
+                        auto target = allocateFromBlocks(index, size, block->buddy.getBlockSize(offset), candidates);
+                        if (!target) {
+                            break; // The remaining blocks are full; this one cannot be emptied
+                        }
+                        moves.push_back({ makeAllocation(*block, offset, size), *target, index });
+                    }
+                }
+            }
+        }
+
+        // The callbacks run without the lock, so they may allocate (e.g. a staging buffer) or free
+        for (auto& planned : moves) {
+            planned.moved = move(planned.source, planned.target);
+        }
+
+        // Commit: release whichever side of every move is no longer used
+        DefragmentationResult result;
+        std::lock_guard lock(mutex_);
+        for (const auto& planned : moves) {
+            if (planned.moved) {
+                releaseFromBlock(*planned.source.block, planned.source.offset);
+                ++result.allocationsMoved;
+            } else {
+                releaseFromBlock(*planned.target.block, planned.target.offset);
+            }
+        }
+        for (usize index = 0; index < pools_.size(); ++index) {
+            if (std::ranges::find(moves, index, &PlannedMove::pool) != moves.end()) {
+                result.bytesFreed += trimEmptyBlocks(index, 0, &result.blocksFreed);
+            }
+        }
+
+        if (result.allocationsMoved > 0) {
+            log_debug("Defragmentation moved {} allocations and freed {} blocks ({:.1f} MiB).",
+                      result.allocationsMoved, result.blocksFreed, static_cast<f64>(result.bytesFreed) / MiB);
+        }
+        return result;
+    }
+
+    void VulkanMemoryAllocator::releaseEmptyBlocks() {
+        std::lock_guard lock(mutex_);
+        for (usize index = 0; index < pools_.size(); ++index) {
+            trimEmptyBlocks(index, 0);
+        }
+    }
+
+    Vector<MemoryHeapStatistics> VulkanMemoryAllocator::getHeapStatistics() const {
+        const auto& res = resources_;
+        std::lock_guard lock(mutex_);
+
+        Vector<MemoryHeapStatistics> statistics(memoryProperties_.memoryHeapCount);
+        for (uint32_t heap = 0; heap < memoryProperties_.memoryHeapCount; ++heap) {
+            auto& stats = statistics[heap];
+            stats.heapIndex = heap;
+            stats.heapSize = memoryProperties_.memoryHeaps[heap].size;
+            stats.deviceLocal = (memoryProperties_.memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        }
+
+        for (const auto& pool : pools_) {
+            for (const auto& block : pool) {
+                auto& stats = statistics[memoryProperties_.memoryTypes[block->memoryType].heapIndex];
+                stats.blockBytes += block->size;
+                stats.allocatedBytes += block->getAllocatedBytes();
+                stats.blockCount += 1;
+                stats.allocationCount += static_cast<uint32_t>(block->requestedSizes.size());
+            }
+        }
+
+        if (res.memoryBudgetSupported) {
+            VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+            budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+            VkPhysicalDeviceMemoryProperties2 properties = {};
+            properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+            properties.pNext = &budgetProperties;
+            vkGetPhysicalDeviceMemoryProperties2(res.physicalDevice, &properties);
+
+            for (auto& stats : statistics) {
+                stats.budget = budgetProperties.heapBudget[stats.heapIndex];
+                stats.usage = budgetProperties.heapUsage[stats.heapIndex];
+            }
+        } else {
+            for (auto& stats : statistics) {
+                stats.budget = stats.heapSize / 100 * FallbackBudgetPercent;
+                stats.usage = stats.blockBytes;
+            }
+        }
+
+        return statistics;
+    }
+
+    void VulkanMemoryAllocator::logStatistics() const {
+        for (const auto& stats : getHeapStatistics()) {
+            log_info("Memory heap {} ({}, {:.0f} MiB): {:.1f}/{:.1f} MiB used of budget, {} blocks with {:.1f} MiB, "
+                     "{} allocations with {:.1f} MiB",
+                     stats.heapIndex, stats.deviceLocal ? "device local" : "host", static_cast<f64>(stats.heapSize) / MiB,
+                     static_cast<f64>(stats.usage) / MiB, static_cast<f64>(stats.budget) / MiB,
+                     stats.blockCount, static_cast<f64>(stats.blockBytes) / MiB,
+                     stats.allocationCount, static_cast<f64>(stats.allocatedBytes) / MiB);
+        }
+    }
+
+    Optional<uint32_t> VulkanMemoryAllocator::findMemoryType(const uint32_t typeBits, const VkMemoryPropertyFlags required,
+                                                             const VkMemoryPropertyFlags preferred) const {
+        // First pass with the preferred flags, second pass with the required ones only
+        for (const VkMemoryPropertyFlags flags : { required | preferred, required }) {
+            for (uint32_t type = 0; type < memoryProperties_.memoryTypeCount; ++type) {
+                if ((typeBits & (1u << type)) != 0 &&
+                    (memoryProperties_.memoryTypes[type].propertyFlags & flags) == flags) {
+                    return type;
+                }
+            }
+        }
+        return std::nullopt;
+    }
+
+    usize VulkanMemoryAllocator::poolIndex(const uint32_t memoryType, const MemoryPool pool) const {
+        return static_cast<usize>(memoryType) * PoolsPerMemoryType + static_cast<usize>(pool);
+    }
+
+    Optional<MemoryAllocation> VulkanMemoryAllocator::allocateFromBlocks(const usize pool, const VkDeviceSize size,
+                                                                         const VkDeviceSize alignment,
+                                                                         const std::span<MemoryBlock* const> excluded) {
+        for (const auto& block : pools_[pool]) {
+            if (block->dedicated || std::ranges::find(excluded, block.get()) != excluded.end()) {
+                continue;
+            }
+            if (const auto offset = block->buddy.allocate(size, alignment)) {
+                block->requestedSizes.emplace(*offset, size);
+                return makeAllocation(*block, *offset, size);
+            }
+        }
+        return std::nullopt;
+    }
+
+    MemoryBlock& VulkanMemoryAllocator::createBlock(const uint32_t memoryType, const MemoryPool pool,
+                                                    const VkDeviceSize size, const bool dedicated) {
+        const auto& res = resources_;
+
+        auto block = createUniquePtr<MemoryBlock>();
+        block->size = size;
+        block->memoryType = memoryType;
+        block->pool = pool;
+        block->dedicated = dedicated;
+
+        VkMemoryAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryType;
+        if (vkAllocateMemory(res.logicalDevice, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate " + std::to_string(size) + " bytes of device memory (type " +
+                                     std::to_string(memoryType) + ")!");
+        }
+
+        if (memoryProperties_.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(res.logicalDevice, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+                vkFreeMemory(res.logicalDevice, block->memory, nullptr);
+                throw std::runtime_error("Failed to map host-visible device memory!");
+            }
+        }
+
+        if (!dedicated) {
+            block->buddy = utils::BuddyAllocator(size, config_.minAllocationSize);
+        }
+
+        log_trace("Allocated {} memory block of {:.1f} MiB (type {}, {} pool).", dedicated ? "dedicated" : "shared",
+                  static_cast<f64>(size) / MiB, memoryType, pool == MemoryPool::Optimal ? "optimal" : "linear");
+
+        auto& blocks = pools_[poolIndex(memoryType, pool)];
+        blocks.push_back(std::move(block));
+        return *blocks.back();
+    }
+
+    void VulkanMemoryAllocator::releaseFromBlock(MemoryBlock& block, const VkDeviceSize offset) {
+        if (block.requestedSizes.erase(offset) == 0) {
+            throw std::runtime_error("Freeing memory that was not allocated from this block!");
+        }
+        if (!block.dedicated) {
+            block.buddy.free(offset);
+        }
+    }
+
+    void VulkanMemoryAllocator::destroyBlock(MemoryBlock& block) const {
+        const auto& res = resources_;
+        if (block.mapped != nullptr) {
+            vkUnmapMemory(res.logicalDevice, block.memory);
+            block.mapped = nullptr;
+        }
+        if (block.memory != VK_NULL_HANDLE) {
+            vkFreeMemory(res.logicalDevice, block.memory, nullptr);
+            block.memory = VK_NULL_HANDLE;
+        }
+    }
+
+    VkDeviceSize VulkanMemoryAllocator::trimEmptyBlocks(const usize pool, const uint32_t keep, uint32_t* blocksFreed) {
+        auto& blocks = pools_[pool];
+
+        VkDeviceSize bytesFreed = 0;
+        uint32_t kept = 0;
+        std::erase_if(blocks, [&](const UniquePtr<MemoryBlock>& block) {
+            if (!block->isEmpty()) {
+                return false;
+            }
+            if (!block->dedicated && kept < keep) {
+                ++kept;
+                return false;
+            }
+
+            bytesFreed += block->size;
+            if (blocksFreed != nullptr) {
+                ++*blocksFreed;
+            }
+            destroyBlock(*block);
+            return true;
+        });
+        return bytesFreed;
+    }
+}
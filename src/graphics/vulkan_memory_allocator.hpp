@@ -0,0 +1,141 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include "utils/buddy_allocator.hpp"
+#include <functional>
+#include <mutex>
+#include <span>
+#include <vulkan/vulkan.h>
+
+namespace time_kill::graphics {
+    class VulkanResources;
+
+    //! Intended access pattern of an allocation; selects the memory type.
+    enum class MemoryUsage {
+        GpuOnly,  //!< DEVICE_LOCAL; render targets, static geometry, textures
+        Upload,   //!< HOST_VISIBLE | HOST_COHERENT, persistently mapped; staging and per-frame data
+        Readback  //!< HOST_VISIBLE | HOST_COHERENT, HOST_CACHED if available; GPU -> CPU copies
+    };
+
+    //! Resources with linear and optimal tiling never share a block, so bufferImageGranularity can be
+    //! ignored inside a block.
+    enum class MemoryPool {
+        Linear,  //!< Buffers and linear-tiling images
+        Optimal  //!< Optimal-tiling images
+    };
+
+    struct MemoryBlock;
+
+    //! A sub-range of a VkDeviceMemory block handed out by VulkanMemoryAllocator.
+    struct MemoryAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;          //!< Requested size
+        void* mappedData = nullptr;     //!< Host pointer to `offset` for host-visible memory, otherwise null
+        uint32_t memoryType = 0;
+        MemoryBlock* block = nullptr;   //!< Owning block (opaque)
+
+        [[nodiscard]] bool isValid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    struct MemoryAllocatorConfig {
+        VkDeviceSize blockSize = 64ull * 1024 * 1024;    //!< Size of the blocks requests are carved from (power of two)
+        VkDeviceSize minAllocationSize = 256;            //!< Smallest buddy block
+        VkDeviceSize dedicatedThreshold = 32ull * 1024 * 1024; //!< Requests at least this large get their own VkDeviceMemory
+        uint32_t maxEmptyBlocks = 1;                     //!< Empty blocks kept per pool for reuse, the rest are freed
+    };
+
+    struct MemoryHeapStatistics {
+        uint32_t heapIndex = 0;
+        VkDeviceSize heapSize = 0;
+        bool deviceLocal = false;
+        VkDeviceSize budget = 0;          //!< Memory this process can use (VK_EXT_memory_budget, else 80% of the heap)
+        VkDeviceSize usage = 0;           //!< Memory this process uses (VK_EXT_memory_budget, else our block bytes)
+        VkDeviceSize blockBytes = 0;      //!< Allocated from Vulkan by this allocator
+        VkDeviceSize allocatedBytes = 0;  //!< Handed out to resources, including buddy rounding
+        uint32_t blockCount = 0;
+        uint32_t allocationCount = 0;
+    };
+
+    struct DefragmentationResult {
+        uint32_t allocationsMoved = 0;
+        uint32_t blocksFreed = 0;
+        VkDeviceSize bytesFreed = 0;
+    };
+
+    //! Sub-allocates device memory from large per-memory-type blocks instead of calling vkAllocateMemory
+    //! per resource, which would run into maxMemoryAllocationCount and fragment device memory.
+    //!
+    //! Every memory type has a linear and an optimal pool; each pool owns blocks of `blockSize` bytes
+    //! carved up by a buddy allocator. Large requests get a dedicated VkDeviceMemory. Host-visible
+    //! blocks stay mapped for their lifetime. All methods are thread-safe.
+    class VulkanMemoryAllocator {
+    public:
+        //! Asked to move a resource from `from` to `to`: copy its contents, bind it to the new memory
+        //! and replace the stored allocation, then return true. Returning false keeps it where it is.
+        //! Called without the allocator's lock, so it may allocate and free other memory; it must not
+        //! free `from` or `to`, the allocator releases whichever one is left over.
+        using MoveCallback = std::function<bool(const MemoryAllocation& from, const MemoryAllocation& to)>;
+
+        explicit VulkanMemoryAllocator(VulkanResources& resources);
+        ~VulkanMemoryAllocator();
+
+        VulkanMemoryAllocator(const VulkanMemoryAllocator&) = delete;
+        VulkanMemoryAllocator& operator=(const VulkanMemoryAllocator&) = delete;
+
+        //! Requires the physical and the logical device.
+        void createAllocator(const MemoryAllocatorConfig& config = {});
+
+        //! Frees all blocks; logs the allocations that were never freed.
+        void destroyAllocator();
+
+        [[nodiscard]] MemoryAllocation allocate(const VkMemoryRequirements& requirements, MemoryUsage usage, MemoryPool pool);
+
+        //! Allocates memory for `image` and binds it.
+        [[nodiscard]] MemoryAllocation allocateForImage(VkImage image, MemoryUsage usage, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL);
+
+        //! Allocates memory for `buffer` and binds it.
+        [[nodiscard]] MemoryAllocation allocateForBuffer(VkBuffer buffer, MemoryUsage usage);
+
+        //! Returns the allocation to its block and resets it. Invalid allocations are ignored.
+        void free(MemoryAllocation& allocation);
+
+        //! Defragmentation hook: evacuates allocations from blocks that are at most `maxBlockUsage` full
+        //! into other blocks of the same pool through `move`, then frees the blocks that became empty.
+        //! The moves are planned first and the callbacks run after the lock is released. The resources
+        //! involved must not be in use by the GPU (or `move` must synchronize), and must not be freed
+        //! by other threads until defragment returns.
+        DefragmentationResult defragment(const MoveCallback& move, f32 maxBlockUsage = 0.25f);
+
+        //! Frees every empty block, including the ones kept for reuse.
+        void releaseEmptyBlocks();
+
+        [[nodiscard]] Vector<MemoryHeapStatistics> getHeapStatistics() const;
+        void logStatistics() const;
+
+        [[nodiscard]] const MemoryAllocatorConfig& getConfig() const { return config_; }
+
+    private:
+        [[nodiscard]] Optional<uint32_t> findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags required,
+                                                        VkMemoryPropertyFlags preferred) const;
+        [[nodiscard]] usize poolIndex(uint32_t memoryType, MemoryPool pool) const;
+
+        //! Places the request in an existing block of the pool that is not in `excluded`.
+        [[nodiscard]] Optional<MemoryAllocation> allocateFromBlocks(usize pool, VkDeviceSize size, VkDeviceSize alignment,
+                                                                    std::span<MemoryBlock* const> excluded = {});
+        MemoryBlock& createBlock(uint32_t memoryType, MemoryPool pool, VkDeviceSize size, bool dedicated);
+        void releaseFromBlock(MemoryBlock& block, VkDeviceSize offset);
+        void destroyBlock(MemoryBlock& block) const;
+
+        //! Frees empty blocks of `pool` beyond the first `keep`; returns the number of bytes freed.
+        VkDeviceSize trimEmptyBlocks(usize pool, uint32_t keep, uint32_t* blocksFreed = nullptr);
+
+        VulkanResources& resources_;
+        MemoryAllocatorConfig config_;
+        VkPhysicalDeviceMemoryProperties memoryProperties_ = {};
+        Vector<VkDeviceSize> heapBlockSizes_; // Block size per heap, smaller for small heaps
+
+        mutable std::mutex mutex_;
+        Vector<Vector<UniquePtr<MemoryBlock>>> pools_; // Indexed by poolIndex(memoryType, pool)
+    };
+}
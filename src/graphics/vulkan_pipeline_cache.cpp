@@ -0,0 +1,294 @@
+#include "vulkan_pipeline_cache.hpp"
+#include "core/logger.hpp"
+#include "utils/hash.hpp"
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace time_kill::graphics {
+    namespace {
+        constexpr u32 CacheFileMagic = 0x43505554; // "TUPC" little endian
+        constexpr u32 CacheFileVersion = 1;
+
+        //! Precedes the driver data in the cache file.
+        struct CacheFileHeader {
+            u32 magic = CacheFileMagic;
+            u32 version = CacheFileVersion;
+            u32 vendorID = 0;
+            u32 deviceID = 0;
+            u32 driverVersion = 0;
+            u8 pipelineCacheUUID[VK_UUID_SIZE] = {};
+            u32 reserved = 0; // Explicit padding, so no uninitialized bytes reach the file
+            u64 dataSize = 0;
+            u64 dataHash = 0;
+        };
+        static_assert(sizeof(CacheFileHeader) == 6 * sizeof(u32) + VK_UUID_SIZE + 2 * sizeof(u64),
+                      "CacheFileHeader must not contain implicit padding");
+
+        f64 elapsedMilliseconds(const std::chrono::steady_clock::time_point start) {
+            return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        //! Forces the contents of a written file to disk, so a rename over the old file cannot leave
+        //! an empty or partial file behind after a crash.
+        bool syncFile(const std::filesystem::path& path) {
+#if defined(_WIN32) || defined(_WIN64)
+            const int fd = _wopen(path.c_str(), _O_RDWR | _O_BINARY);
+            if (fd < 0) {
+                return false;
+            }
+            const bool synced = _commit(fd) == 0;
+            _close(fd);
+#else
+            const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+            if (fd < 0) {
+                return false;
+            }
+            const bool synced = ::fsync(fd) == 0;
+            ::close(fd);
+#endif
+            return synced;
+        }
+    }
+
+    VulkanPipelineCache::VulkanPipelineCache(VulkanResources& resources) : resources_(resources) {}
+
+    VulkanPipelineCache::~VulkanPipelineCache() {
+        destroyPipelineCache();
+    }
+
+    void VulkanPipelineCache::createPipelineCache(const String& path) {
+        auto& res = resources_;
+        if (res.logicalDevice == VK_NULL_HANDLE) {
+            throw std::runtime_error("Unable to create pipeline cache; the logical device reference is invalid!");
+        }
+
+        vkGetPhysicalDeviceProperties(res.physicalDevice, &deviceProperties_);
+        path_ = path;
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto initialData = path_.empty() ? std::nullopt : loadCacheData(path_);
+
+        VkPipelineCacheCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        if (initialData) {
+            createInfo.initialDataSize = initialData->size();
+            createInfo.pInitialData = initialData->data();
+        }
+
+        VkResult result = vkCreatePipelineCache(res.logicalDevice, &createInfo, nullptr, &res.pipelineCache);
+        if (result != VK_SUCCESS && initialData) {
+            // The driver rejected data that passed our checks; start over with an empty cache
+            log_warn("Driver rejected pipeline cache '{}'; starting with an empty cache.", path_);
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+            result = vkCreatePipelineCache(res.logicalDevice, &createInfo, nullptr, &res.pipelineCache);
+        }
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline cache!");
+        }
+
+        if (initialData) {
+            log_debug("Loaded pipeline cache '{}' ({} bytes) in {:.2f} ms.", path_, initialData->size(),
+                      elapsedMilliseconds(start));
+        } else {
+            log_debug("Created empty pipeline cache.");
+        }
+    }
+
+    void VulkanPipelineCache::destroyPipelineCache() {
+        auto& res = resources_;
+        if (res.pipelineCache == VK_NULL_HANDLE) {
+            return;
+        }
+
+        save();
+        logStatistics();
+
+        vkDestroyPipelineCache(res.logicalDevice, res.pipelineCache, nullptr);
+        res.pipelineCache = VK_NULL_HANDLE;
+        log_trace("Destroyed pipeline cache.");
+    }
+
+    bool VulkanPipelineCache::save() const {
+        const auto& res = resources_;
+        if (path_.empty() || res.pipelineCache == VK_NULL_HANDLE) {
+            return false;
+        }
+
+        size_t dataSize = 0;
+        if (vkGetPipelineCacheData(res.logicalDevice, res.pipelineCache, &dataSize, nullptr) != VK_SUCCESS) {
+            log_warn("Failed to query pipeline cache size; cache not saved.");
+            return false;
+        }
+        Vector<u8> data(dataSize);
+        if (vkGetPipelineCacheData(res.logicalDevice, res.pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+            log_warn("Failed to read pipeline cache data; cache not saved.");
+            return false;
+        }
+        data.resize(dataSize);
+
+        CacheFileHeader header = {};
+        header.vendorID = deviceProperties_.vendorID;
+        header.deviceID = deviceProperties_.deviceID;
+        header.driverVersion = deviceProperties_.driverVersion;
+        std::memcpy(header.pipelineCacheUUID, deviceProperties_.pipelineCacheUUID, VK_UUID_SIZE);
+        header.dataSize = data.size();
+        header.dataHash = utils::fnv1a(data.data(), data.size());
+
+        // Write next to the target and rename over it, so readers never see a partial file
+        namespace fs = std::filesystem;
+        const fs::path target(path_);
+        fs::path temporary = target;
+        temporary += ".tmp";
+
+        std::error_code error;
+        if (target.has_parent_path()) {
+            fs::create_directories(target.parent_path(), error);
+        }
+
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            file.close();
+            if (!file || !syncFile(temporary)) {
+                log_warn("Failed to write pipeline cache '{}'.", temporary.string());
+                fs::remove(temporary, error);
+                return false;
+            }
+        }
+
+        fs::rename(temporary, target, error);
+        if (error) {
+            log_warn("Failed to replace pipeline cache '{}': {}", path_, error.message());
+            fs::remove(temporary, error);
+            return false;
+        }
+
+        log_debug("Saved pipeline cache '{}' ({} bytes).", path_, data.size());
+        return true;
+    }
+
+    VkPipeline VulkanPipelineCache::createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo,
+                                                           const StringView name) {
+        const auto& res = resources_;
+
+        VkGraphicsPipelineCreateInfo pipelineInfo = createInfo;
+        VkPipelineCreationFeedback feedback = {};
+        VkPipelineCreationFeedbackCreateInfo feedbackInfo = {};
+        if (res.pipelineCreationFeedbackSupported) {
+            feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+            feedbackInfo.pNext = pipelineInfo.pNext;
+            feedbackInfo.pPipelineCreationFeedback = &feedback;
+            pipelineInfo.pNext = &feedbackInfo;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        if (vkCreateGraphicsPipelines(res.logicalDevice, res.pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create graphics pipeline '" + String(name) + "'!");
+        }
+        f64 milliseconds = elapsedMilliseconds(start);
+
+        std::lock_guard lock(statisticsMutex_);
+        if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT) != 0) {
+            milliseconds = static_cast<f64>(feedback.duration) / 1.0e6;
+            if ((feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) != 0) {
+                ++statistics_.hits;
+                statistics_.hitMilliseconds += milliseconds;
+                log_debug("Created graphics pipeline '{}' in {:.2f} ms (cache hit).", name, milliseconds);
+            } else {
+                ++statistics_.misses;
+                statistics_.missMilliseconds += milliseconds;
+                log_debug("Created graphics pipeline '{}' in {:.2f} ms (cache miss).", name, milliseconds);
+            }
+        } else {
+            ++statistics_.unknown;
+            statistics_.unknownMilliseconds += milliseconds;
+            log_debug("Created graphics pipeline '{}' in {:.2f} ms.", name, milliseconds);
+        }
+
+        return pipeline;
+    }
+
+    PipelineCacheStatistics VulkanPipelineCache::getStatistics() const {
+        std::lock_guard lock(statisticsMutex_);
+        return statistics_;
+    }
+
+    void VulkanPipelineCache::logStatistics() const {
+        const auto stats = getStatistics();
+        if (stats.hits + stats.misses + stats.unknown == 0) {
+            return;
+        }
+
+        log_info("Pipeline cache: {} hits ({:.2f} ms), {} misses ({:.2f} ms), {} without feedback ({:.2f} ms).",
+                 stats.hits, stats.hitMilliseconds, stats.misses, stats.missMilliseconds,
+                 stats.unknown, stats.unknownMilliseconds);
+    }
+
+    Optional<Vector<u8>> VulkanPipelineCache::loadCacheData(const String& path) const {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            log_debug("No pipeline cache at '{}'.", path);
+            return std::nullopt;
+        }
+
+        const auto fileSize = static_cast<usize>(file.tellg());
+        if (fileSize < sizeof(CacheFileHeader)) {
+            log_warn("Ignoring pipeline cache '{}': file is truncated.", path);
+            return std::nullopt;
+        }
+
+        CacheFileHeader header;
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (header.magic != CacheFileMagic || header.version != CacheFileVersion) {
+            log_warn("Ignoring pipeline cache '{}': unknown file format.", path);
+            return std::nullopt;
+        }
+        if (header.vendorID != deviceProperties_.vendorID || header.deviceID != deviceProperties_.deviceID ||
+            header.driverVersion != deviceProperties_.driverVersion ||
+            std::memcmp(header.pipelineCacheUUID, deviceProperties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            log_info("Ignoring pipeline cache '{}': it was created for a different device or driver.", path);
+            return std::nullopt;
+        }
+        if (header.dataSize != fileSize - sizeof(CacheFileHeader)) {
+            log_warn("Ignoring pipeline cache '{}': size mismatch.", path);
+            return std::nullopt;
+        }
+
+        Vector<u8> data(header.dataSize);
+        file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file || utils::fnv1a(data.data(), data.size()) != header.dataHash) {
+            log_warn("Ignoring pipeline cache '{}': data is corrupt.", path);
+            return std::nullopt;
+        }
+
+        // The driver's own header must agree as well
+        VkPipelineCacheHeaderVersionOne driverHeader = {};
+        if (data.size() < sizeof(driverHeader)) {
+            log_warn("Ignoring pipeline cache '{}': driver data is truncated.", path);
+            return std::nullopt;
+        }
+        std::memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+        if (driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+            driverHeader.vendorID != deviceProperties_.vendorID || driverHeader.deviceID != deviceProperties_.deviceID ||
+            std::memcmp(driverHeader.pipelineCacheUUID, deviceProperties_.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+            log_warn("Ignoring pipeline cache '{}': driver header does not match the device.", path);
+            return std::nullopt;
+        }
+
+        return data;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "graphics/vulkan_resources.hpp"
+#include <mutex>
+
+namespace time_kill::graphics {
+    struct PipelineCacheStatistics {
+        uint32_t hits = 0;           //!< Pipelines the driver found in the cache
+        uint32_t misses = 0;         //!< Pipelines the driver had to compile
+        uint32_t unknown = 0;        //!< Pipelines created without creation feedback
+        f64 hitMilliseconds = 0.0;
+        f64 missMilliseconds = 0.0;
+        f64 unknownMilliseconds = 0.0;
+    };
+
+    //! Persistent VkPipelineCache shared by all pipeline creations.
+    //!
+    //! The cache is stored as a small header followed by the driver's cache data. The header records
+    //! the vendor, device, driver version and pipelineCacheUUID the data was produced with, plus the
+    //! size and a hash of the data; a file that does not match the current device is ignored instead
+    //! of being handed to the driver. The file is replaced atomically (write to a temporary file, then
+    //! rename), so a crash while saving never leaves a truncated cache behind.
+    class VulkanPipelineCache {
+    public:
+        explicit VulkanPipelineCache(VulkanResources& resources);
+        ~VulkanPipelineCache();
+
+        VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+        VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+        //! Creates the cache, seeded from `path` if it holds a cache for this device. An empty path
+        //! keeps the cache in memory only. Stores the handle in VulkanResources::pipelineCache.
+        void createPipelineCache(const String& path);
+
+        //! Saves the cache (if it has a path), logs the statistics and destroys it.
+        void destroyPipelineCache();
+
+        //! Writes the cache to its path; returns false if there is no path or writing failed.
+        bool save() const;
+
+        //! Creates a graphics pipeline through the cache and records whether it was a cache hit and
+        //! how long it took. Throws if the pipeline cannot be created.
+        VkPipeline createGraphicsPipeline(const VkGraphicsPipelineCreateInfo& createInfo, StringView name);
+
+        [[nodiscard]] VkPipelineCache getHandle() const { return resources_.pipelineCache; }
+        [[nodiscard]] PipelineCacheStatistics getStatistics() const;
+        void logStatistics() const;
+
+    private:
+        //! Returns the driver data stored in `path`, or nothing if it is missing or does not match
+        //! the current device.
+        [[nodiscard]] Optional<Vector<u8>> loadCacheData(const String& path) const;
+
+        VulkanResources& resources_;
+        VkPhysicalDeviceProperties deviceProperties_ = {};
+        String path_;
+
+        mutable std::mutex statisticsMutex_;
+        PipelineCacheStatistics statistics_;
+    };
+}
@@ -0,0 +1,894 @@
+#include "vulkan_pipeline_registry.hpp"
+#include "vulkan_pipeline_cache.hpp"
+#include "shader_reflection.hpp"
+#include "vulkan_layout_cache.hpp"
+#include "shader_bundle.hpp"
+#include "vulkan_mappings.hpp"
+#include "vulkan_tools.hpp"
+#include "core/logger.hpp"
+#include "utils/hash.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <ranges>
+#include <sstream>
+
+namespace time_kill::graphics {
+    //! SPIR-V of one stage, either read from a file or pointing into the shader bundle.
+    struct ShaderSource {
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+        Vector<u32> storage;                       // Code read from a file
+        std::span<const u32> bundleCode;           // Code in the mapped bundle, used if storage is empty
+        u64 contentHash = 0;
+        std::span<const u8> precomputedReflection; // Serialized by the bundle
+
+        [[nodiscard]] std::span<const u32> getCode() const {
+            return storage.empty() ? bundleCode : std::span<const u32>(storage);
+        }
+    };
+
+    //! What the key of a pipeline hashes of one of its shaders.
+    struct ShaderIdentity {
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+        u64 contentHash = 0;
+
+        bool operator==(const ShaderIdentity&) const = default;
+    };
+
+    struct PipelineEntry {
+        u64 key = 0;
+        String name;
+
+        PipelineDescription description; // Kept to recompile the pipeline when a shader is reloaded
+        Vector<ShaderSource> shaders;    // Parallel to description.shaderFiles, released once compiled
+        Vector<ShaderIdentity> shaderIdentities; // Kept to tell key collisions from shared pipelines
+
+        std::atomic<PipelineState> state = PipelineState::Pending;
+        VkPipeline pipeline = VK_NULL_HANDLE;       // Valid once state is Ready
+        VkPipelineLayout layout = VK_NULL_HANDLE;         // Owned by the layout cache
+        Vector<VkDescriptorSetLayout> descriptorSetLayouts;
+        Vector<ShaderSpecializationConstant> specializationConstants;
+        String error;                               // Set once state is Failed
+        core::JobCounter counter;
+        u32 reloadGeneration = 0;                   // Latest reload requested; guarded by the registry mutex
+    };
+
+    namespace {
+        //! Topologies a pipeline with dynamic topology may switch between without being recreated.
+        enum class TopologyClass : u8 {
+            Point,
+            Line,
+            Triangle,
+            Patch
+        };
+
+        TopologyClass getTopologyClass(const VkPrimitiveTopology topology) {
+            switch (topology) {
+                case VK_PRIMITIVE_TOPOLOGY_POINT_LIST:
+                    return TopologyClass::Point;
+                case VK_PRIMITIVE_TOPOLOGY_LINE_LIST:
+                case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP:
+                case VK_PRIMITIVE_TOPOLOGY_LINE_LIST_WITH_ADJACENCY:
+                case VK_PRIMITIVE_TOPOLOGY_LINE_STRIP_WITH_ADJACENCY:
+                    return TopologyClass::Line;
+                case VK_PRIMITIVE_TOPOLOGY_PATCH_LIST:
+                    return TopologyClass::Patch;
+                default:
+                    return TopologyClass::Triangle;
+            }
+        }
+
+        u64 hashDescription(const PipelineDescription& description, const Vector<ShaderSource>& shaders) {
+            utils::Hasher hasher;
+            for (const auto& shader : shaders) {
+                hasher.add(shader.stage).add(shader.contentHash);
+            }
+            hasher.add(description.vertexBindings)
+                  .add(description.vertexAttributes)
+                  .add(description.polygonMode)
+                  .add(description.blendEnable)
+                  .add(description.dynamicViewport)
+                  .add(description.dynamicCullMode)
+                  .add(description.dynamicTopology)
+                  .add(description.dynamicDepthState);
+
+            // States set while recording are not part of the pipeline
+            if (description.dynamicTopology) {
+                hasher.add(getTopologyClass(description.topology));
+            } else {
+                hasher.add(description.topology);
+            }
+            if (!description.dynamicCullMode) {
+                hasher.add(description.cullMode).add(description.frontFace);
+            }
+            if (!description.dynamicDepthState) {
+                hasher.add(description.depthTestEnable).add(description.depthWriteEnable).add(description.depthCompareOp);
+            }
+            if (!description.dynamicViewport) {
+                hasher.add(description.viewportExtent);
+            }
+
+            // The order values were set in does not matter
+            Vector<const SpecializationValue*> values;
+            for (const auto& value : description.specializationValues) {
+                values.push_back(&value);
+            }
+            std::ranges::sort(values, {}, &SpecializationValue::name);
+            for (const auto* value : values) {
+                hasher.add(value->name).add(value->value);
+            }
+
+            hasher.add(reinterpret_cast<std::uintptr_t>(description.renderPass))
+                  .add(description.subpass)
+                  .add(description.colorAttachmentFormats)
+                  .add(description.depthAttachmentFormat);
+            return hasher.get();
+        }
+
+        template<typename T>
+        bool bytesEqual(const Vector<T>& a, const Vector<T>& b) {
+            return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+        }
+
+        Vector<ShaderIdentity> getShaderIdentities(const Vector<ShaderSource>& shaders) {
+            Vector<ShaderIdentity> identities;
+            identities.reserve(shaders.size());
+            for (const auto& shader : shaders) {
+                identities.push_back({ shader.stage, shader.contentHash });
+            }
+            return identities;
+        }
+
+        //! Compares everything hashDescription hashes, so a key collision is never taken for an
+        //! identical pipeline.
+        bool isSamePipeline(const PipelineEntry& entry, const PipelineDescription& description,
+                            const Vector<ShaderIdentity>& shaders) {
+            const auto& other = entry.description;
+            if (entry.shaderIdentities != shaders ||
+                !bytesEqual(other.vertexBindings, description.vertexBindings) ||
+                !bytesEqual(other.vertexAttributes, description.vertexAttributes) ||
+                other.polygonMode != description.polygonMode ||
+                other.blendEnable != description.blendEnable ||
+                other.dynamicViewport != description.dynamicViewport ||
+                other.dynamicCullMode != description.dynamicCullMode ||
+                other.dynamicTopology != description.dynamicTopology ||
+                other.dynamicDepthState != description.dynamicDepthState ||
+                other.renderPass != description.renderPass ||
+                other.subpass != description.subpass ||
+                other.colorAttachmentFormats != description.colorAttachmentFormats ||
+                other.depthAttachmentFormat != description.depthAttachmentFormat) {
+                return false;
+            }
+
+            if (description.dynamicTopology
+                    ? getTopologyClass(other.topology) != getTopologyClass(description.topology)
+                    : other.topology != description.topology) {
+                return false;
+            }
+            if (!description.dynamicCullMode &&
+                (other.cullMode != description.cullMode || other.frontFace != description.frontFace)) {
+                return false;
+            }
+            if (!description.dynamicDepthState &&
+                (other.depthTestEnable != description.depthTestEnable ||
+                 other.depthWriteEnable != description.depthWriteEnable ||
+                 other.depthCompareOp != description.depthCompareOp)) {
+                return false;
+            }
+            if (!description.dynamicViewport &&
+                (other.viewportExtent.width != description.viewportExtent.width ||
+                 other.viewportExtent.height != description.viewportExtent.height)) {
+                return false;
+            }
+
+            // The order values were set in does not matter
+            if (other.specializationValues.size() != description.specializationValues.size()) {
+                return false;
+            }
+            return std::ranges::all_of(description.specializationValues, [&](const SpecializationValue& value) {
+                const auto it = std::ranges::find(other.specializationValues, value.name, &SpecializationValue::name);
+                return it != other.specializationValues.end() && it->value == value.value;
+            });
+        }
+
+        //! True if `path` is the file of shader `name`: either the same path, or `name` is relative
+        //! to a shader directory (as in the shader bundle) and `path` is that file in the directory.
+        bool isShaderFile(const String& name, const String& path) {
+            namespace fs = std::filesystem;
+            const String normalizedName = fs::path(name).lexically_normal().generic_string();
+            const String normalizedPath = fs::path(path).lexically_normal().generic_string();
+            return normalizedName == normalizedPath ||
+                   (fs::path(name).is_relative() && normalizedPath.ends_with("/" + normalizedName));
+        }
+    }
+
+    //=== PipelineDescription
+
+    PipelineDescription& PipelineDescription::specialize(const StringView name, const u32 value) {
+        const auto it = std::ranges::find(specializationValues, name, &SpecializationValue::name);
+        if (it != specializationValues.end()) {
+            it->value = value;
+        } else {
+            specializationValues.push_back({ String(name), value });
+        }
+        return *this;
+    }
+
+    PipelineDescription& PipelineDescription::specialize(const StringView name, const i32 value) {
+        return specialize(name, std::bit_cast<u32>(value));
+    }
+
+    PipelineDescription& PipelineDescription::specialize(const StringView name, const f32 value) {
+        return specialize(name, std::bit_cast<u32>(value));
+    }
+
+    PipelineDescription& PipelineDescription::specialize(const StringView name, const bool value) {
+        return specialize(name, static_cast<u32>(value ? VK_TRUE : VK_FALSE));
+    }
+
+    PipelineDescription& PipelineDescription::useSwapchainTarget(const VulkanResources& resources) {
+        if (resources.dynamicRenderingEnabled) {
+            renderPass = VK_NULL_HANDLE;
+            subpass = 0;
+            colorAttachmentFormats = { resources.swapchainImageFormat };
+            depthAttachmentFormat = resources.depthFormat;
+        } else {
+            renderPass = resources.renderPass;
+            subpass = 0;
+            colorAttachmentFormats.clear();
+            depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+        }
+        return *this;
+    }
+
+    //=== PipelineHandle
+
+    PipelineState PipelineHandle::getState() const {
+        return entry_->state.load(std::memory_order_acquire);
+    }
+
+    VkPipeline PipelineHandle::get() const {
+        return isReady() ? entry_->pipeline : VK_NULL_HANDLE;
+    }
+
+    VkPipelineLayout PipelineHandle::getLayout() const {
+        return isReady() ? entry_->layout : VK_NULL_HANDLE;
+    }
+
+    Vector<VkDescriptorSetLayout> PipelineHandle::getDescriptorSetLayouts() const {
+        if (!isReady()) {
+            return {};
+        }
+        return entry_->descriptorSetLayouts;
+    }
+
+    Vector<ShaderSpecializationConstant> PipelineHandle::getSpecializationConstants() const {
+        if (!isReady()) {
+            return {};
+        }
+        return entry_->specializationConstants;
+    }
+
+    VkPipeline PipelineHandle::wait() const {
+        if (!isValid()) {
+            throw std::runtime_error("Waiting on an invalid pipeline handle!");
+        }
+        if (getState() == PipelineState::Pending) {
+            jobSystem_->wait(entry_->counter);
+        }
+        if (getState() == PipelineState::Failed) {
+            throw std::runtime_error("Pipeline '" + entry_->name + "' failed to compile: " + entry_->error);
+        }
+        return entry_->pipeline;
+    }
+
+    u64 PipelineHandle::getKey() const {
+        return entry_->key;
+    }
+
+    const String& PipelineHandle::getName() const {
+        return entry_->name;
+    }
+
+    //=== VulkanPipelineRegistry
+
+    VulkanPipelineRegistry::VulkanPipelineRegistry(VulkanResources& resources, VulkanPipelineCache& pipelineCache,
+                                                   ShaderReflectionCache& reflectionCache, VulkanLayoutCache& layoutCache)
+        : resources_(resources), pipelineCache_(pipelineCache), reflectionCache_(reflectionCache),
+          layoutCache_(layoutCache) {}
+
+    VulkanPipelineRegistry::~VulkanPipelineRegistry() {
+        destroyRegistry();
+    }
+
+    void VulkanPipelineRegistry::createRegistry(core::JobSystem& jobSystem, const ShaderBundle* shaderBundle) {
+        jobSystem_ = &jobSystem;
+        shaderBundle_ = shaderBundle;
+    }
+
+    void VulkanPipelineRegistry::destroyRegistry() {
+        if (jobSystem_ == nullptr) {
+            return;
+        }
+        waitAll();
+
+        const auto& res = resources_;
+        std::lock_guard lock(mutex_);
+        const auto destroyPipeline = [&res](const VkPipeline pipeline) {
+            if (pipeline != VK_NULL_HANDLE) {
+                vkDestroyPipeline(res.logicalDevice, pipeline, nullptr);
+            }
+        };
+        for (const auto& entry : pipelines_ | std::views::values) {
+            destroyPipeline(entry->pipeline);
+        }
+        for (const auto& entry : detachedPipelines_) {
+            destroyPipeline(entry->pipeline);
+        }
+        for (const auto& reload : reloads_) {
+            destroyPipeline(reload.replacement->pipeline);
+        }
+        for (const auto& retired : retiredPipelines_) {
+            destroyPipeline(retired.pipeline);
+        }
+        if (!pipelines_.empty()) {
+            log_debug("Destroyed {} pipelines.", pipelines_.size());
+        }
+        pipelines_.clear();
+        detachedPipelines_.clear();
+        reloads_.clear();
+        retiredPipelines_.clear();
+        shaderOverrides_.clear();
+        jobSystem_ = nullptr;
+    }
+
+    PipelineHandle VulkanPipelineRegistry::request(const PipelineDescription& description) {
+        if (jobSystem_ == nullptr) {
+            throw std::runtime_error("Pipeline registry has not been created!");
+        }
+
+        Vector<ShaderSource> shaders;
+        shaders.reserve(description.shaderFiles.size());
+        for (const auto& file : description.shaderFiles) {
+            shaders.push_back(loadShader(file));
+        }
+        return request(description, std::move(shaders));
+    }
+
+    Vector<PipelineHandle> VulkanPipelineRegistry::requestVariants(const PipelineDescription& base,
+                                                                   const std::span<const SpecializationAxis> axes) {
+        if (jobSystem_ == nullptr) {
+            throw std::runtime_error("Pipeline registry has not been created!");
+        }
+
+        usize variantCount = 1;
+        for (const auto& axis : axes) {
+            variantCount *= axis.values.size();
+        }
+        if (variantCount == 0) {
+            return {};
+        }
+
+        Vector<ShaderSource> shaders;
+        shaders.reserve(base.shaderFiles.size());
+        for (const auto& file : base.shaderFiles) {
+            shaders.push_back(loadShader(file));
+        }
+
+        Vector<PipelineHandle> handles;
+        handles.reserve(variantCount);
+        for (usize variant = 0; variant < variantCount; ++variant) {
+            PipelineDescription description = base;
+            String suffix;
+
+            // Decompose the variant index, last axis fastest
+            usize remainder = variant;
+            Vector<usize> indices(axes.size());
+            for (usize axis = axes.size(); axis-- > 0;) {
+                indices[axis] = remainder % axes[axis].values.size();
+                remainder /= axes[axis].values.size();
+            }
+            for (usize axis = 0; axis < axes.size(); ++axis) {
+                const u32 value = axes[axis].values[indices[axis]];
+                description.specialize(axes[axis].name, value);
+                suffix += std::format("{}{}={}", suffix.empty() ? "" : ",", axes[axis].name, value);
+            }
+            if (!suffix.empty()) {
+                description.name = std::format("{}[{}]", base.name, suffix);
+            }
+            handles.push_back(request(description, shaders));
+        }
+
+        log_debug("Requested {} variants of pipeline '{}'.", variantCount, base.name);
+        return handles;
+    }
+
+    PipelineHandle VulkanPipelineRegistry::request(const PipelineDescription& description, Vector<ShaderSource> shaders) {
+        const u64 key = hashDescription(description, shaders);
+        Vector<ShaderIdentity> shaderIdentities = getShaderIdentities(shaders);
+
+        SharedPtr<PipelineEntry> entry;
+        {
+            std::lock_guard lock(mutex_);
+            bool collision = false;
+            if (const auto it = pipelines_.find(key); it != pipelines_.end()) {
+                if (isSamePipeline(*it->second, description, shaderIdentities)) {
+                    log_trace("Pipeline '{}' shares compiled pipeline '{}' ({:016x}).", description.name, it->second->name, key);
+                    return { it->second, jobSystem_ };
+                }
+
+                // A different pipeline with the same key lives on detached from the map
+                collision = true;
+                for (const auto& detached : detachedPipelines_) {
+                    if (detached->key == key && isSamePipeline(*detached, description, shaderIdentities)) {
+                        return { detached, jobSystem_ };
+                    }
+                }
+                log_warn("Pipeline '{}' collides with pipeline '{}' ({:016x}); compiling it separately.",
+                         description.name, it->second->name, key);
+            }
+
+            entry = createSharedPtr<PipelineEntry>();
+            entry->key = key;
+            entry->name = description.name.empty() ? std::format("{:016x}", key) : description.name;
+            entry->description = description;
+            entry->shaders = std::move(shaders);
+            entry->shaderIdentities = std::move(shaderIdentities);
+            if (collision) {
+                detachedPipelines_.push_back(entry);
+            } else {
+                pipelines_.emplace(key, entry);
+            }
+        }
+
+        scheduleCompile(entry);
+        return { entry, jobSystem_ };
+    }
+
+    usize VulkanPipelineRegistry::reloadShader(const String& path) {
+        if (jobSystem_ == nullptr) {
+            return 0;
+        }
+
+        Vector<SharedPtr<PipelineEntry>> affected;
+        {
+            std::lock_guard lock(mutex_);
+            const auto collect = [&](const SharedPtr<PipelineEntry>& entry) {
+                for (const auto& name : entry->description.shaderFiles) {
+                    if (isShaderFile(name, path)) {
+                        shaderOverrides_[name] = path;
+                        affected.push_back(entry);
+                        break;
+                    }
+                }
+            };
+            for (const auto& entry : pipelines_ | std::views::values) {
+                collect(entry);
+            }
+            for (const auto& entry : detachedPipelines_) {
+                collect(entry);
+            }
+        }
+
+        usize scheduled = 0;
+        for (const auto& target : affected) {
+            auto replacement = createSharedPtr<PipelineEntry>();
+            replacement->name = target->name;
+            replacement->description = target->description;
+            try {
+                for (const auto& file : replacement->description.shaderFiles) {
+                    replacement->shaders.push_back(loadShader(file));
+                }
+            } catch (const std::exception& e) {
+                log_error("Failed to reload pipeline '{}': {}", target->name, e.what());
+                continue;
+            }
+            replacement->key = hashDescription(replacement->description, replacement->shaders);
+            replacement->shaderIdentities = getShaderIdentities(replacement->shaders);
+
+            {
+                std::lock_guard lock(mutex_);
+                replacement->reloadGeneration = ++target->reloadGeneration;
+                reloads_.push_back({ target, replacement });
+            }
+            scheduleCompile(replacement);
+            ++scheduled;
+        }
+
+        if (scheduled > 0) {
+            log_debug("Shader '{}' changed; recompiling {} pipelines.", path, scheduled);
+        }
+        return scheduled;
+    }
+
+    usize VulkanPipelineRegistry::applyReloads(const u64 frameNumber, const u32 framesInFlight) {
+        const auto& res = resources_;
+        std::lock_guard lock(mutex_);
+
+        // Frames begun before a pipeline was retired have all finished once `framesInFlight` more began
+        std::erase_if(retiredPipelines_, [&](const RetiredPipeline& retired) {
+            if (frameNumber < retired.frameNumber + framesInFlight) {
+                return false;
+            }
+            vkDestroyPipeline(res.logicalDevice, retired.pipeline, nullptr);
+            return true;
+        });
+
+        usize swapped = 0;
+        std::erase_if(reloads_, [&](const PendingReload& reload) {
+            const auto& target = reload.target;
+            const auto& replacement = reload.replacement;
+            const auto replacementState = replacement->state.load(std::memory_order_acquire);
+            if (replacementState == PipelineState::Pending ||
+                target->state.load(std::memory_order_acquire) == PipelineState::Pending) {
+                return false;
+            }
+
+            // A newer reload of the same pipeline supersedes this one; a failed one keeps the old pipeline
+            if (replacement->reloadGeneration != target->reloadGeneration || replacementState == PipelineState::Failed) {
+                if (replacement->pipeline != VK_NULL_HANDLE) {
+                    vkDestroyPipeline(res.logicalDevice, replacement->pipeline, nullptr);
+                }
+                if (replacementState == PipelineState::Failed) {
+                    log_warn("Keeping the previous version of pipeline '{}'.", target->name);
+                }
+                return true;
+            }
+
+            if (target->pipeline != VK_NULL_HANDLE) {
+                retiredPipelines_.push_back({ target->pipeline, frameNumber });
+            }
+            target->pipeline = replacement->pipeline;
+            target->layout = replacement->layout;
+            target->descriptorSetLayouts = replacement->descriptorSetLayouts;
+            target->specializationConstants = replacement->specializationConstants;
+            target->shaderIdentities = replacement->shaderIdentities;
+            target->error.clear();
+            target->state.store(PipelineState::Ready, std::memory_order_release);
+
+            // Re-key the entry under its new state; if an identical pipeline exists, it just stays alive
+            if (const auto it = pipelines_.find(target->key); it != pipelines_.end() && it->second == target) {
+                pipelines_.erase(it);
+            } else {
+                std::erase(detachedPipelines_, target);
+            }
+            target->key = replacement->key;
+            if (!pipelines_.try_emplace(target->key, target).second) {
+                detachedPipelines_.push_back(target);
+            }
+
+            log_info("Reloaded pipeline '{}'.", target->name);
+            ++swapped;
+            return true;
+        });
+        return swapped;
+    }
+
+    void VulkanPipelineRegistry::waitAll() {
+        Vector<SharedPtr<PipelineEntry>> entries;
+        {
+            std::lock_guard lock(mutex_);
+            for (const auto& entry : pipelines_ | std::views::values) {
+                entries.push_back(entry);
+            }
+            for (const auto& entry : detachedPipelines_) {
+                entries.push_back(entry);
+            }
+            for (const auto& reload : reloads_) {
+                entries.push_back(reload.replacement);
+            }
+        }
+        for (const auto& entry : entries) {
+            jobSystem_->wait(entry->counter);
+        }
+    }
+
+    usize VulkanPipelineRegistry::getPipelineCount() const {
+        std::lock_guard lock(mutex_);
+        return pipelines_.size();
+    }
+
+    usize VulkanPipelineRegistry::getPendingCount() const {
+        std::lock_guard lock(mutex_);
+        return static_cast<usize>(std::ranges::count_if(pipelines_ | std::views::values, [](const auto& entry) {
+            return entry->state.load(std::memory_order_acquire) == PipelineState::Pending;
+        }));
+    }
+
+    void VulkanPipelineRegistry::scheduleCompile(const SharedPtr<PipelineEntry>& entry) {
+        // The job keeps the entry alive even if destroyRegistry() races with it
+        jobSystem_->schedule([this, entry] {
+            try {
+                compile(*entry);
+                entry->state.store(PipelineState::Ready, std::memory_order_release);
+            } catch (const std::exception& e) {
+                entry->error = e.what();
+                entry->state.store(PipelineState::Failed, std::memory_order_release);
+                log_error("Failed to compile pipeline '{}': {}", entry->name, e.what());
+            }
+            entry->shaders = {};
+        }, entry->counter);
+    }
+
+    ShaderSource VulkanPipelineRegistry::loadShader(const String& name) const {
+        ShaderSource shader;
+
+        // Reloaded shaders are read from the changed file, even if the bundle has them
+        String path = name;
+        {
+            std::lock_guard lock(mutex_);
+            if (const auto it = shaderOverrides_.find(name); it != shaderOverrides_.end()) {
+                path = it->second;
+            }
+        }
+
+        if (shaderBundle_ != nullptr && path == name) {
+            if (auto bundled = shaderBundle_->find(name)) {
+                shader.stage = bundled->stage;
+                shader.bundleCode = bundled->code;
+                shader.contentHash = bundled->contentHash;
+                shader.precomputedReflection = bundled->reflection;
+                return shader;
+            }
+        }
+
+        shader.stage = VulkanTools::getShaderStage(path);
+        shader.storage = VulkanTools::readSpirvFile(path);
+        shader.contentHash = utils::fnv1a(shader.storage.data(), shader.storage.size() * sizeof(u32));
+        return shader;
+    }
+
+    void VulkanPipelineRegistry::compile(PipelineEntry& entry) const {
+        const auto& res = resources_;
+        const auto& description = entry.description;
+
+        Vector<VkPipelineShaderStageCreateInfo> shaderStages;
+        Vector<VkShaderModule> shaderModules;
+        Vector<SharedPtr<const ShaderReflection>> reflections;
+        Vector<VkVertexInputBindingDescription> vertexBindings = description.vertexBindings;
+        Vector<VkVertexInputAttributeDescription> vertexAttributes = description.vertexAttributes;
+        const bool reflectVertexInput = vertexBindings.empty() && vertexAttributes.empty();
+
+        // Shader modules are only needed while the pipeline is created
+        const auto destroyShaderModules = [&] {
+            for (const auto shaderModule : shaderModules) {
+                vkDestroyShaderModule(res.logicalDevice, shaderModule, nullptr);
+            }
+        };
+
+        // Specialization data per stage; sized up front so the pointers handed to Vulkan stay valid
+        const usize stageCount = description.shaderFiles.size();
+        Vector<Vector<VkSpecializationMapEntry>> specializationEntries(stageCount);
+        Vector<Vector<u32>> specializationData(stageCount);
+        Vector<VkSpecializationInfo> specializationInfos(stageCount);
+        Vector<bool> specializationValueUsed(description.specializationValues.size(), false);
+        Vector<ShaderSpecializationConstant> specializationConstants;
+
+        try {
+            for (usize i = 0; i < stageCount; ++i) {
+                const auto& file = description.shaderFiles[i];
+                const auto& shader = entry.shaders[i];
+                const auto code = shader.getCode();
+                const VkShaderStageFlagBits stage = shader.stage;
+
+                // Prevent duplicate shader types
+                if (std::ranges::any_of(shaderStages, [stage](const VkPipelineShaderStageCreateInfo& ssi) {
+                        return ssi.stage == stage;
+                    })) {
+                    VulkanMappings mappings;
+                    std::ostringstream oss;
+                    oss << "SPIRV-Reflect: Multiple shaders of the same type detected! " << "\n"
+                        << "Shader: " << file << "\n"
+                        << "conflicts with shader type: " << mappings.getShaderStageDescription(stage);
+                    throw std::runtime_error(oss.str());
+                }
+
+                shaderModules.push_back(VulkanTools::createShaderModule(code, res.logicalDevice, file));
+
+                const auto reflection = reflectionCache_.get(shader.contentHash, code, file,
+                                                             shader.precomputedReflection);
+                reflections.push_back(reflection);
+
+                // Specialization constants of this stage that the description sets a value for
+                auto& mapEntries = specializationEntries[i];
+                auto& data = specializationData[i];
+                for (const auto& constant : reflection->specializationConstants) {
+                    if (std::ranges::find(specializationConstants, constant.constantId,
+                                          &ShaderSpecializationConstant::constantId) == specializationConstants.end()) {
+                        specializationConstants.push_back(constant);
+                    }
+                    for (usize v = 0; v < description.specializationValues.size(); ++v) {
+                        if (constant.name.empty() || description.specializationValues[v].name != constant.name) {
+                            continue;
+                        }
+                        mapEntries.push_back({ constant.constantId, static_cast<uint32_t>(data.size() * sizeof(u32)),
+                                               sizeof(u32) });
+                        data.push_back(description.specializationValues[v].value);
+                        specializationValueUsed[v] = true;
+                        break;
+                    }
+                }
+                specializationInfos[i].mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+                specializationInfos[i].pMapEntries = mapEntries.data();
+                specializationInfos[i].dataSize = data.size() * sizeof(u32);
+                specializationInfos[i].pData = data.data();
+
+                VkPipelineShaderStageCreateInfo shaderStage = {};
+                shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                shaderStage.stage = stage;
+                shaderStage.module = shaderModules.back();
+                shaderStage.pName = "main"; // Defines the shader entry point
+                shaderStage.pSpecializationInfo = mapEntries.empty() ? nullptr : &specializationInfos[i];
+                shaderStages.push_back(shaderStage);
+
+                // If it is a vertex shader, take its inputs as one interleaved vertex buffer
+                if (reflectVertexInput && stage == VK_SHADER_STAGE_VERTEX_BIT) {
+                    vertexAttributes = reflection->vertexInputs;
+                    if (!vertexAttributes.empty()) {
+                        vertexBindings.push_back({ 0, reflection->vertexStride, VK_VERTEX_INPUT_RATE_VERTEX });
+                    }
+                }
+            }
+
+            // A value no stage declares is most likely a typo; don't silently build the unspecialized pipeline
+            for (usize v = 0; v < specializationValueUsed.size(); ++v) {
+                if (!specializationValueUsed[v]) {
+                    throw std::runtime_error("No shader declares specialization constant '" +
+                                             description.specializationValues[v].name + "'");
+                }
+            }
+            std::ranges::sort(specializationConstants, {}, &ShaderSpecializationConstant::constantId);
+            entry.specializationConstants = std::move(specializationConstants);
+
+            // Vertex Input
+            VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+            vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexBindings.size());
+            vertexInputInfo.pVertexBindingDescriptions = vertexBindings.data();
+            vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
+            vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
+
+            // Input assembly
+            VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+            inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+            inputAssembly.topology = description.topology;
+            inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+            // Viewport & Scissor
+            VkViewport viewport = {};
+            viewport.x = 0.0f;
+            viewport.y = 0.0f;
+            viewport.width = static_cast<float>(description.viewportExtent.width);
+            viewport.height = static_cast<float>(description.viewportExtent.height);
+            viewport.minDepth = 0.0f;
+            viewport.maxDepth = 1.0f;
+
+            VkRect2D scissor = {};
+            scissor.offset = {0, 0};
+            scissor.extent = description.viewportExtent;
+
+            VkPipelineViewportStateCreateInfo viewportState = {};
+            viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+            viewportState.viewportCount = 1;
+            viewportState.pViewports = description.dynamicViewport ? nullptr : &viewport;
+            viewportState.scissorCount = 1;
+            viewportState.pScissors = description.dynamicViewport ? nullptr : &scissor;
+
+            // Dynamic state
+            const bool extendedDynamicState = description.dynamicCullMode || description.dynamicTopology ||
+                                              description.dynamicDepthState;
+            if (extendedDynamicState && !res.extendedDynamicStateSupported) {
+                throw std::runtime_error("Extended dynamic state requires Vulkan 1.3");
+            }
+            Vector<VkDynamicState> dynamicStates;
+            if (description.dynamicViewport) {
+                dynamicStates.insert(dynamicStates.end(), { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR });
+            }
+            if (description.dynamicCullMode) {
+                dynamicStates.insert(dynamicStates.end(), { VK_DYNAMIC_STATE_CULL_MODE, VK_DYNAMIC_STATE_FRONT_FACE });
+            }
+            if (description.dynamicTopology) {
+                dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY);
+            }
+            if (description.dynamicDepthState) {
+                dynamicStates.insert(dynamicStates.end(), { VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE,
+                                                            VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+                                                            VK_DYNAMIC_STATE_DEPTH_COMPARE_OP });
+            }
+
+            VkPipelineDynamicStateCreateInfo dynamicState = {};
+            dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+            dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+            dynamicState.pDynamicStates = dynamicStates.data();
+
+            // Rasterizer
+            VkPipelineRasterizationStateCreateInfo rasterizer = {};
+            rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+            rasterizer.depthClampEnable = VK_FALSE;
+            rasterizer.rasterizerDiscardEnable = VK_FALSE;
+            rasterizer.polygonMode = description.polygonMode;
+            rasterizer.lineWidth = 1.0f;
+            rasterizer.cullMode = description.cullMode;
+            rasterizer.frontFace = description.frontFace;
+            rasterizer.depthBiasEnable = VK_FALSE;
+
+            // Multisampling (no MSAA for now)
+            VkPipelineMultisampleStateCreateInfo multisampling = {};
+            multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+            multisampling.sampleShadingEnable = VK_FALSE;
+            multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+            // Color Blending (overwrite, or standard alpha blending)
+            VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+            colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT
+                                                | VK_COLOR_COMPONENT_G_BIT
+                                                | VK_COLOR_COMPONENT_B_BIT
+                                                | VK_COLOR_COMPONENT_A_BIT;
+            colorBlendAttachment.blendEnable = description.blendEnable ? VK_TRUE : VK_FALSE;
+            colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+            colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+            colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+            colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+            colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+            colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+            VkPipelineColorBlendStateCreateInfo colorBlending = {};
+            colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+            colorBlending.logicOpEnable = VK_FALSE;
+            colorBlending.attachmentCount = 1;
+            colorBlending.pAttachments = &colorBlendAttachment;
+
+            // Depth Stencil
+            VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+            depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+            depthStencil.depthTestEnable = description.depthTestEnable ? VK_TRUE : VK_FALSE;
+            depthStencil.depthWriteEnable = description.depthWriteEnable ? VK_TRUE : VK_FALSE;
+            depthStencil.depthCompareOp = description.depthCompareOp;
+            depthStencil.depthBoundsTestEnable = VK_FALSE;
+            depthStencil.stencilTestEnable = VK_FALSE;
+
+            // Pipeline Layout, merged from the descriptors and push constants of all stages
+            auto layout = layoutCache_.getPipelineLayout(PipelineInterface::merge(reflections, entry.name));
+            entry.layout = layout.layout;
+            entry.descriptorSetLayouts = std::move(layout.descriptorSetLayouts);
+
+            // Create pipeline
+            VkGraphicsPipelineCreateInfo pipelineInfo = {};
+            pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+            pipelineInfo.pStages = shaderStages.data();
+            pipelineInfo.pVertexInputState = &vertexInputInfo;
+            pipelineInfo.pInputAssemblyState = &inputAssembly;
+            pipelineInfo.pViewportState = &viewportState;
+            pipelineInfo.pRasterizationState = &rasterizer;
+            pipelineInfo.pMultisampleState = &multisampling;
+            pipelineInfo.pColorBlendState = &colorBlending;
+            pipelineInfo.pDepthStencilState = &depthStencil;
+            pipelineInfo.pDynamicState = dynamicStates.empty() ? nullptr : &dynamicState;
+            pipelineInfo.layout = entry.layout;
+            pipelineInfo.renderPass = description.renderPass;
+            pipelineInfo.subpass = description.subpass;
+
+            // Without a render pass the attachment formats come from the description (dynamic rendering)
+            VkPipelineRenderingCreateInfo renderingInfo = {};
+            renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+            renderingInfo.colorAttachmentCount = static_cast<uint32_t>(description.colorAttachmentFormats.size());
+            renderingInfo.pColorAttachmentFormats = description.colorAttachmentFormats.data();
+            renderingInfo.depthAttachmentFormat = description.depthAttachmentFormat;
+            if (description.renderPass == VK_NULL_HANDLE) {
+                pipelineInfo.pNext = &renderingInfo;
+            }
+
+            entry.pipeline = pipelineCache_.createGraphicsPipeline(pipelineInfo, entry.name);
+        } catch (...) {
+            destroyShaderModules();
+            entry.layout = VK_NULL_HANDLE;
+            entry.descriptorSetLayouts.clear();
+            entry.specializationConstants.clear();
+            throw;
+        }
+
+        destroyShaderModules();
+    }
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "graphics/vulkan_resources.hpp"
+#include "graphics/shader_reflection.hpp"
+#include "core/job_system.hpp"
+#include <atomic>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+
+namespace time_kill::graphics {
+    class VulkanPipelineCache;
+    class ShaderBundle;
+    class VulkanLayoutCache;
+    struct ShaderSource;
+
+    //! Value of a specialization constant, as the raw 32 bits of a bool (VkBool32), int, uint or float.
+    struct SpecializationValue {
+        String name;                    //!< Name of the constant in the shaders
+        u32 value = 0;
+    };
+
+    //! A specialization constant and the values to generate pipeline variants for.
+    struct SpecializationAxis {
+        String name;
+        Vector<u32> values;
+    };
+
+    //! Complete state of a graphics pipeline. Everything except `name` is part of the registry key.
+    struct PipelineDescription {
+        String name;                    //!< Used in log messages only
+
+        //! SPIR-V shaders, one per stage. Names found in the shader bundle are taken from it, all
+        //! others are read as files; the stage is derived from the file name (e.g. `.vert.spv`).
+        Vector<String> shaderFiles;
+
+        //! Vertex input layout. If both are empty it is reflected from the vertex shader: all inputs,
+        //! in location order, tightly interleaved in binding 0.
+        Vector<VkVertexInputBindingDescription> vertexBindings;
+        Vector<VkVertexInputAttributeDescription> vertexAttributes;
+
+        VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+        VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+        VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+
+        bool blendEnable = false;       //!< Standard alpha blending if enabled
+
+        bool depthTestEnable = true;
+        bool depthWriteEnable = true;
+        VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
+
+        //! Values of specialization constants, matched by name against the constants the shaders
+        //! declare; constants without a value keep their default. A name no shader declares fails
+        //! the pipeline. Only 32-bit constants are supported.
+        Vector<SpecializationValue> specializationValues;
+
+        //! Viewport and scissor are set while recording (VulkanRenderer does it for the whole frame),
+        //! so resizing the swapchain never invalidates the pipeline. If false, they are baked from
+        //! `viewportExtent`.
+        bool dynamicViewport = true;
+        VkExtent2D viewportExtent = {};     //!< Only used (and part of the key) without dynamic viewport
+
+        //! Extended dynamic state, core in Vulkan 1.3. Enabled states must be set while recording; the
+        //! corresponding members above are ignored and not part of the key, so one pipeline serves
+        //! every combination.
+        bool dynamicCullMode = false;       //!< vkCmdSetCullMode, vkCmdSetFrontFace
+        bool dynamicTopology = false;       //!< vkCmdSetPrimitiveTopology, within the class of `topology`
+        bool dynamicDepthState = false;     //!< vkCmdSetDepthTestEnable, ...WriteEnable, ...CompareOp
+
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        uint32_t subpass = 0;
+
+        //! Attachment formats for dynamic rendering, used if `renderPass` is VK_NULL_HANDLE.
+        Vector<VkFormat> colorAttachmentFormats;
+        VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+        //! Targets the swapchain: its render pass, or its formats if dynamic rendering is enabled.
+        PipelineDescription& useSwapchainTarget(const VulkanResources& resources);
+
+        //! Sets (or replaces) the value of specialization constant `name`.
+        PipelineDescription& specialize(StringView name, u32 value);
+        PipelineDescription& specialize(StringView name, i32 value);
+        PipelineDescription& specialize(StringView name, f32 value);
+        PipelineDescription& specialize(StringView name, bool value);
+    };
+
+    enum class PipelineState : u8 {
+        Pending,
+        Ready,
+        Failed
+    };
+
+    struct PipelineEntry;
+
+    //! Shared handle to a pipeline owned by VulkanPipelineRegistry. Pipelines compile in the
+    //! background; check isReady() each frame or block with wait(). When a shader is hot-reloaded the
+    //! handle keeps working and returns the new pipeline once VulkanPipelineRegistry::applyReloads
+    //! swapped it in, so read it on the render thread and don't keep the VkPipeline across frames.
+    class PipelineHandle {
+    public:
+        PipelineHandle() = default;
+
+        [[nodiscard]] bool isValid() const { return entry_ != nullptr; }
+        [[nodiscard]] PipelineState getState() const;
+        [[nodiscard]] bool isReady() const { return isValid() && getState() == PipelineState::Ready; }
+        [[nodiscard]] bool isFailed() const { return isValid() && getState() == PipelineState::Failed; }
+
+        //! The pipeline, or VK_NULL_HANDLE while it is still compiling or if it failed.
+        [[nodiscard]] VkPipeline get() const;
+        [[nodiscard]] VkPipelineLayout getLayout() const;
+
+        //! Descriptor set layouts of the pipeline layout, indexed by set number. Pipelines with the
+        //! same reflected interface share the layout and all set layouts. Returned as a copy: a hot
+        //! reload replaces the list in applyReloads.
+        [[nodiscard]] Vector<VkDescriptorSetLayout> getDescriptorSetLayouts() const;
+
+        //! Specialization constants declared by the pipeline's shaders, sorted by constant id; a
+        //! copy, like getDescriptorSetLayouts.
+        [[nodiscard]] Vector<ShaderSpecializationConstant> getSpecializationConstants() const;
+
+        //! Blocks until the pipeline is compiled, running other jobs meanwhile. Throws if it failed.
+        VkPipeline wait() const;
+
+        [[nodiscard]] u64 getKey() const;
+        [[nodiscard]] const String& getName() const;
+
+    private:
+        friend class VulkanPipelineRegistry;
+
+        PipelineHandle(SharedPtr<PipelineEntry> entry, core::JobSystem* jobSystem)
+            : entry_(std::move(entry)), jobSystem_(jobSystem) {}
+
+        SharedPtr<PipelineEntry> entry_;
+        core::JobSystem* jobSystem_ = nullptr;
+    };
+
+    //! Creates and owns graphics pipelines, keyed by a hash of their full state.
+    //!
+    //! request() returns immediately; the pipeline is compiled by a job on the job system, so many
+    //! pipelines compile concurrently. Requests with an identical description (including the SPIR-V
+    //! contents) share one pipeline; a key hit is confirmed against the stored description, so a
+    //! hash collision gets a pipeline of its own. The app can render with a fallback pipeline until
+    //! the handle it actually wants is ready.
+    //!
+    //! For hot reloading, reloadShader() recompiles the pipelines using a changed shader in the
+    //! background and applyReloads() swaps them in between frames.
+    class VulkanPipelineRegistry {
+    public:
+        VulkanPipelineRegistry(VulkanResources& resources, VulkanPipelineCache& pipelineCache,
+                               ShaderReflectionCache& reflectionCache, VulkanLayoutCache& layoutCache);
+        ~VulkanPipelineRegistry();
+
+        VulkanPipelineRegistry(const VulkanPipelineRegistry&) = delete;
+        VulkanPipelineRegistry& operator=(const VulkanPipelineRegistry&) = delete;
+
+        //! Shaders are looked up in `shaderBundle` first, if given; it must outlive the registry.
+        void createRegistry(core::JobSystem& jobSystem, const ShaderBundle* shaderBundle = nullptr);
+
+        //! Waits for pending compilations and destroys all pipelines. Handles become dangling.
+        void destroyRegistry();
+
+        //! Returns the pipeline for `description`, scheduling its compilation if it is new. Shader
+        //! files are read on the calling thread (their contents are part of the key); throws if one
+        //! cannot be read. Bundled shaders contribute their precomputed content hash.
+        [[nodiscard]] PipelineHandle request(const PipelineDescription& description);
+
+        //! Requests one variant of `base` per combination of the axes' values, so a family of
+        //! specialized pipelines compiles in parallel instead of branching at runtime in one uber
+        //! shader. Shaders are read once for all variants. Handles are in row-major order (the last
+        //! axis varies fastest); variant names get the values appended, e.g. `lit[LIGHTS=4,MSAA=1]`.
+        [[nodiscard]] Vector<PipelineHandle> requestVariants(const PipelineDescription& base,
+                                                             std::span<const SpecializationAxis> axes);
+
+        //! Recompiles every pipeline that uses the SPIR-V file at `path` in the background. From now
+        //! on that shader is read from `path`, also if it came from the shader bundle. The shaders
+        //! are read on the calling thread, so call it from a job (as ShaderHotReloader does) rather
+        //! than the render thread. Returns the number of pipelines scheduled; pipelines whose
+        //! shaders cannot be read are skipped.
+        usize reloadShader(const String& path);
+
+        //! Swaps in the recompiled pipelines that are ready; call once per frame between frames, on
+        //! the render thread. Failed recompilations keep the previous pipeline. Replaced pipelines are
+        //! destroyed once `framesInFlight` further frames have begun. Returns the number swapped.
+        usize applyReloads(u64 frameNumber, u32 framesInFlight);
+
+        //! Blocks until every requested pipeline (including reloads) is compiled or failed.
+        void waitAll();
+
+        [[nodiscard]] usize getPipelineCount() const;
+        [[nodiscard]] usize getPendingCount() const;
+
+    private:
+        struct PendingReload {
+            SharedPtr<PipelineEntry> target;       //!< Entry the handles point to
+            SharedPtr<PipelineEntry> replacement;  //!< Recompiled version, swapped into target when ready
+        };
+
+        struct RetiredPipeline {
+            VkPipeline pipeline = VK_NULL_HANDLE;
+            u64 frameNumber = 0;                   //!< Frame number when it was replaced
+        };
+
+        [[nodiscard]] PipelineHandle request(const PipelineDescription& description, Vector<ShaderSource> shaders);
+        void scheduleCompile(const SharedPtr<PipelineEntry>& entry);
+        [[nodiscard]] ShaderSource loadShader(const String& name) const;
+
+        //! Compiles the pipeline of `entry`; runs on a job system thread.
+        void compile(PipelineEntry& entry) const;
+
+        VulkanResources& resources_;
+        VulkanPipelineCache& pipelineCache_;
+        ShaderReflectionCache& reflectionCache_;
+        VulkanLayoutCache& layoutCache_;
+        core::JobSystem* jobSystem_ = nullptr;
+        const ShaderBundle* shaderBundle_ = nullptr;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<u64, SharedPtr<PipelineEntry>> pipelines_;
+        Vector<SharedPtr<PipelineEntry>> detachedPipelines_;    // Key collisions, or reloaded into a state another entry had
+        std::unordered_map<String, String> shaderOverrides_;    // Shader name -> reloaded file
+        Vector<PendingReload> reloads_;
+        Vector<RetiredPipeline> retiredPipelines_;
+    };
+}
@@ -0,0 +1,710 @@
+#include "vulkan_renderer.hpp"
+#include "vulkan_swapchain.hpp"
+#include "vulkan_tools.hpp"
+#include "core/logger.hpp"
+#include "core/window.hpp"
+#include <algorithm>
+#include <array>
+
+namespace time_kill::graphics {
+    VulkanRenderer::VulkanRenderer(VulkanResources& resources, VulkanSwapchain& swapchain)
+        : resources_(resources), swapchain_(swapchain) {}
+
+    VulkanRenderer::~VulkanRenderer() {
+        destroyRenderer();
+    }
+
+    void VulkanRenderer::createRenderer(const core::Window* window, const LatencyPolicy& latencyPolicy,
+                                        core::JobSystem& jobSystem) {
+        const uint32_t framesInFlight = latencyPolicy.framesInFlight;
+        const auto& res = resources_;
+        if (res.logicalDevice == VK_NULL_HANDLE) {
+            throw std::runtime_error("Unable to create renderer; logical device is null!");
+        }
+        if (res.swapchainImages.empty() || (res.renderPass == VK_NULL_HANDLE && !res.dynamicRenderingEnabled)) {
+            throw std::runtime_error("Unable to create renderer; swapchain and render pass are required!");
+        }
+        if (res.offscreen && res.swapchainImages.size() < framesInFlight) {
+            throw std::runtime_error("Unable to create renderer; every frame in flight needs an offscreen image!");
+        }
+        if (framesInFlight == 0) {
+            throw std::runtime_error("Unable to create renderer; at least one frame in flight is required!");
+        }
+
+        destroyRenderer();
+
+        jobSystem_ = &jobSystem;
+        window_ = window;
+        framebufferSize_ = window ? window->getFramebufferSize() : FramebufferSize {};
+        swapchainDirty_ = false;
+
+        framePacer_.setTargetFrameRate(latencyPolicy.targetFrameRate);
+        waitForPresent_ = latencyPolicy.waitForPresent && res.presentWaitSupported;
+        vkWaitForPresent_ = nullptr;
+        if (waitForPresent_) {
+            vkWaitForPresent_ = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+                vkGetDeviceProcAddr(res.logicalDevice, "vkWaitForPresentKHR"));
+            if (!vkWaitForPresent_) {
+                log_warn("Failed to load vkWaitForPresentKHR; not waiting for presents.");
+                waitForPresent_ = false;
+            }
+        }
+        pendingInputTime_.reset();
+        lastPresentId_ = 0;
+        lastPresentSwapchain_ = VK_NULL_HANDLE;
+        latencyStatistics_ = {};
+
+        if (!res.dynamicRenderingEnabled) {
+            createFramebuffers();
+        }
+        createFrameResources(framesInFlight);
+
+        log_debug("Created renderer with {} frames in flight and {} recording threads{}.",
+                  framesInFlight, jobSystem_->getThreadCount(), waitForPresent_ ? ", waiting for presents" : "");
+    }
+
+    void VulkanRenderer::destroyRenderer() {
+        if (resources_.logicalDevice == VK_NULL_HANDLE) {
+            return;
+        }
+        if (frames_.empty() && resources_.swapchainFramebuffers.empty()) {
+            return;
+        }
+
+        // Frames may still be executing
+        vkDeviceWaitIdle(resources_.logicalDevice);
+
+        releaseRetired(UINT64_MAX, UINT64_MAX);
+        imagesAcquired_.clear();
+        unacquiredImages_ = 0;
+        presentedFrames_ = 0;
+        destroyFrameResources();
+        destroyFramebuffers();
+    }
+
+    void VulkanRenderer::waitForNextFrame() {
+        const auto& res = resources_;
+
+        // Only a present on the current swapchain can complete; a recreated one never shows the old id
+        if (waitForPresent_ && lastPresentId_ != 0 && lastPresentSwapchain_ == res.swapchain) {
+            const VkResult result = vkWaitForPresent_(res.logicalDevice, res.swapchain, lastPresentId_,
+                                                      PresentWaitTimeout);
+            if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+                addLatencySample(lastPresentInputTime_, true);
+            } else if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+                swapchainDirty_ = true;
+            } else if (result != VK_TIMEOUT) {
+                throw std::runtime_error("Failed to wait for present!");
+            }
+            lastPresentId_ = 0; // Measured (or given up on) once
+        }
+
+        pendingInputTime_ = framePacer_.wait();
+    }
+
+    Optional<FrameContext> VulkanRenderer::beginFrame() {
+        auto& res = resources_;
+        FrameResources& frame = frames_[currentFrame_];
+
+        // The only point where the CPU waits for the GPU: the slot's previous frame must be finished.
+        // Its fence also covers every earlier submission, so all frames up to it are complete.
+        vkWaitForFences(res.logicalDevice, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+        if (frame.submittedFrame) {
+            completedFrames_ = std::max(completedFrames_, *frame.submittedFrame + 1);
+            if (!waitForPresent_) {
+                addLatencySample(frame.inputTime, false);
+            }
+            frame.submittedFrame.reset();
+        }
+        releaseRetired(completedFrames_, std::min(completedFrames_, presentedFrames_));
+
+        // A minimized window has nothing to present to; headless targets keep their size
+        if (window_ != nullptr) {
+            const FramebufferSize framebufferSize = window_->getFramebufferSize();
+            if (framebufferSize.width == 0 || framebufferSize.height == 0) {
+                return std::nullopt;
+            }
+            if (framebufferSize.width != framebufferSize_.width || framebufferSize.height != framebufferSize_.height) {
+                framebufferSize_ = framebufferSize;
+                swapchainDirty_ = true;
+            }
+        }
+        if (swapchainDirty_ && !res.offscreen) {
+            recreateSwapchain();
+        }
+
+        // Offscreen, every slot owns an image, which the fence wait above has made free again
+        uint32_t imageIndex = currentFrame_;
+        if (!res.offscreen) {
+            VkResult acquireResult = vkAcquireNextImageKHR(res.logicalDevice, res.swapchain, UINT64_MAX,
+                                                           frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+            if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+                // The semaphore was not signaled, so it can be used again right away
+                recreateSwapchain();
+                acquireResult = vkAcquireNextImageKHR(res.logicalDevice, res.swapchain, UINT64_MAX,
+                                                      frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+                if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+                    swapchainDirty_ = true;
+                    return std::nullopt;
+                }
+            }
+            if (acquireResult != VK_SUCCESS && acquireResult != VK_SUBOPTIMAL_KHR) {
+                throw std::runtime_error("Failed to acquire swapchain image!");
+            }
+            if (acquireResult == VK_SUBOPTIMAL_KHR) {
+                // The image can still be presented; recreate before the next frame
+                swapchainDirty_ = true;
+            }
+            noteAcquired(imageIndex);
+        }
+
+        // Only reset the fence once work is certain to be submitted for this slot
+        vkResetFences(res.logicalDevice, 1, &frame.inFlight);
+        frame.inputTime = pendingInputTime_.value_or(core::FramePacer::Clock::now());
+        pendingInputTime_.reset();
+        vkResetCommandPool(res.logicalDevice, frame.commandPool, 0);
+        for (auto& threadPool : frame.threadPools) {
+            if (threadPool.used > 0) {
+                vkResetCommandPool(res.logicalDevice, threadPool.commandPool, 0);
+                threadPool.used = 0;
+            }
+        }
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        if (vkBeginCommandBuffer(frame.commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording command buffer!");
+        }
+
+        FrameContext context;
+        context.frameIndex = currentFrame_;
+        context.imageIndex = imageIndex;
+        context.frameNumber = frameNumber_++;
+        context.commandBuffer = frame.commandBuffer;
+        context.framebuffer = res.dynamicRenderingEnabled ? VK_NULL_HANDLE : res.swapchainFramebuffers[imageIndex];
+        context.image = res.swapchainImages[imageIndex];
+        context.imageView = res.swapchainImageViews[imageIndex];
+        context.extent = res.swapchainExtent;
+        return context;
+    }
+
+    void VulkanRenderer::beginRenderPass(const FrameContext& frame, const VkClearColorValue& clearColor,
+                                         const VkSubpassContents contents) const {
+        // Pipelines take viewport and scissor as dynamic state, so resizes don't invalidate them
+        if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+            setViewport(frame.commandBuffer, frame.extent);
+        }
+
+        if (resources_.dynamicRenderingEnabled) {
+            beginRendering(frame, clearColor, contents);
+            return;
+        }
+
+        std::array<VkClearValue, 2> clearValues = {};
+        clearValues[0].color = clearColor;
+        clearValues[1].depthStencil = { 1.0f, 0 };
+
+        VkRenderPassBeginInfo renderPassInfo = {};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = resources_.renderPass;
+        renderPassInfo.framebuffer = frame.framebuffer;
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = frame.extent;
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
+
+        vkCmdBeginRenderPass(frame.commandBuffer, &renderPassInfo, contents);
+    }
+
+    void VulkanRenderer::endRenderPass(const FrameContext& frame) const {
+        if (resources_.dynamicRenderingEnabled) {
+            endRendering(frame);
+            return;
+        }
+        vkCmdEndRenderPass(frame.commandBuffer);
+    }
+
+    void VulkanRenderer::setViewport(const VkCommandBuffer commandBuffer, const VkExtent2D extent) {
+        VkViewport viewport = {};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+
+        VkRect2D scissor = {};
+        scissor.offset = { 0, 0 };
+        scissor.extent = extent;
+
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    void VulkanRenderer::beginRendering(const FrameContext& frame, const VkClearColorValue& clearColor,
+                                        const VkSubpassContents contents) const {
+        const auto& res = resources_;
+
+        // Same synchronization as the render pass' external dependency: wait for the acquired image
+        // (color output stage) and for the previous frame's use of the shared depth buffer
+        std::array<VkImageMemoryBarrier, 2> barriers = {};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcAccessMask = 0;
+        barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = frame.image;
+        barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = res.depthImage;
+        barriers[1].subresourceRange = { VulkanTools::getDepthAspectMask(res.depthFormat), 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(frame.commandBuffer,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                             0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+        VkRenderingAttachmentInfo colorAttachment = {};
+        colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        colorAttachment.imageView = frame.imageView;
+        colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.clearValue.color = clearColor;
+
+        VkRenderingAttachmentInfo depthAttachment = {};
+        depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        depthAttachment.imageView = res.depthImageView;
+        depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.clearValue.depthStencil = { 1.0f, 0 };
+
+        VkRenderingInfo renderingInfo = {};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        renderingInfo.flags = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                            ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+        renderingInfo.renderArea.offset = { 0, 0 };
+        renderingInfo.renderArea.extent = frame.extent;
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachments = &colorAttachment;
+        renderingInfo.pDepthAttachment = &depthAttachment;
+
+        vkCmdBeginRendering(frame.commandBuffer, &renderingInfo);
+    }
+
+    void VulkanRenderer::endRendering(const FrameContext& frame) const {
+        vkCmdEndRendering(frame.commandBuffer);
+
+        // The render pass' final layout, and like its outgoing dependency, visible to later transfers
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barrier.newLayout = resources_.colorTargetLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = frame.image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(frame.commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    bool VulkanRenderer::endFrame(const FrameContext& frame) {
+        auto& res = resources_;
+        FrameResources& frameResources = frames_[frame.frameIndex];
+
+        if (vkEndCommandBuffer(frame.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer!");
+        }
+
+        const VkSemaphore renderFinished = renderFinished_[frame.imageIndex];
+        constexpr VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+        // Offscreen there is no image to wait for and nothing to present
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = res.offscreen ? 0 : 1;
+        submitInfo.pWaitSemaphores = &frameResources.imageAvailable;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frame.commandBuffer;
+        submitInfo.signalSemaphoreCount = res.offscreen ? 0 : 1;
+        submitInfo.pSignalSemaphores = &renderFinished;
+
+        if (vkQueueSubmit(res.graphicsQueue, 1, &submitInfo, frameResources.inFlight) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw command buffer!");
+        }
+        frameResources.submittedFrame = frame.frameNumber;
+
+        if (res.offscreen) {
+            currentFrame_ = (currentFrame_ + 1) % static_cast<uint32_t>(frames_.size());
+            return true;
+        }
+
+        VkPresentInfoKHR presentInfo = {};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = &renderFinished;
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = &res.swapchain;
+        presentInfo.pImageIndices = &frame.imageIndex;
+
+        // Frame numbers start at 0, present ids must be non-zero and increasing
+        const u64 presentId = frame.frameNumber + 1;
+        VkPresentIdKHR presentIdInfo = {};
+        presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        presentIdInfo.swapchainCount = 1;
+        presentIdInfo.pPresentIds = &presentId;
+        if (waitForPresent_) {
+            presentInfo.pNext = &presentIdInfo;
+        }
+
+        const VkResult presentResult = vkQueuePresentKHR(res.presentQueue, &presentInfo);
+        if (waitForPresent_ && (presentResult == VK_SUCCESS || presentResult == VK_SUBOPTIMAL_KHR)) {
+            lastPresentId_ = presentId;
+            lastPresentSwapchain_ = res.swapchain;
+            lastPresentInputTime_ = frameResources.inputTime;
+        }
+
+        currentFrame_ = (currentFrame_ + 1) % static_cast<uint32_t>(frames_.size());
+
+        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+            swapchainDirty_ = true;
+            return false;
+        }
+        if (presentResult != VK_SUCCESS) {
+            throw std::runtime_error("Failed to present swapchain image!");
+        }
+        return true;
+    }
+
+    void VulkanRenderer::recordParallel(const FrameContext& frame, const usize drawCount,
+                                        const SecondaryRecordCallback& record) {
+        if (drawCount == 0) {
+            return;
+        }
+
+        FrameResources& frameResources = frames_[frame.frameIndex];
+        const usize participants = frameResources.threadPools.size();
+
+        // A few chunks per thread let the pool balance uneven draws; tiny lists stay on one buffer
+        const usize maxChunks = (drawCount + MinDrawsPerSecondaryBuffer - 1) / MinDrawsPerSecondaryBuffer;
+        const usize chunkCount = std::min(maxChunks, participants * 2);
+        const usize chunkSize = (drawCount + chunkCount - 1) / chunkCount;
+
+        VkCommandBufferInheritanceInfo inheritanceInfo = {};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = resources_.renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = frame.framebuffer;
+
+        // With dynamic rendering the secondary buffers inherit the attachment formats instead
+        VkCommandBufferInheritanceRenderingInfo renderingInheritance = {};
+        renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+        renderingInheritance.colorAttachmentCount = 1;
+        renderingInheritance.pColorAttachmentFormats = &resources_.swapchainImageFormat;
+        renderingInheritance.depthAttachmentFormat = resources_.depthFormat;
+        renderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        if (resources_.dynamicRenderingEnabled) {
+            inheritanceInfo.pNext = &renderingInheritance;
+        }
+
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        secondaryBuffers_.assign(chunkCount, VK_NULL_HANDLE);
+        jobSystem_->parallelFor(chunkCount, 1, [&](const usize firstChunk, const usize lastChunk) {
+            // Each thread only touches its own pool, so no locking is needed
+            ThreadCommandPool& threadPool = frameResources.threadPools[jobSystem_->getThreadIndex()];
+
+            for (usize chunk = firstChunk; chunk < lastChunk; ++chunk) {
+                const VkCommandBuffer commandBuffer = acquireSecondaryBuffer(threadPool);
+                if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to begin recording secondary command buffer!");
+                }
+                setViewport(commandBuffer, frame.extent);
+
+                const usize begin = chunk * chunkSize;
+                record(commandBuffer, begin, std::min(begin + chunkSize, drawCount));
+
+                if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to record secondary command buffer!");
+                }
+                secondaryBuffers_[chunk] = commandBuffer;
+            }
+        });
+
+        vkCmdExecuteCommands(frame.commandBuffer, static_cast<uint32_t>(secondaryBuffers_.size()), secondaryBuffers_.data());
+    }
+
+    bool VulkanRenderer::drawFrame(const VkClearColorValue& clearColor, const RecordCallback& record) {
+        const auto frame = beginFrame();
+        if (!frame) {
+            return false;
+        }
+
+        beginRenderPass(*frame, clearColor);
+        if (record) {
+            record(*frame);
+        }
+        endRenderPass(*frame);
+
+        return endFrame(*frame);
+    }
+
+    bool VulkanRenderer::drawFrameParallel(const VkClearColorValue& clearColor, const usize drawCount,
+                                           const SecondaryRecordCallback& record) {
+        const auto frame = beginFrame();
+        if (!frame) {
+            return false;
+        }
+
+        beginRenderPass(*frame, clearColor, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        recordParallel(*frame, drawCount, record);
+        endRenderPass(*frame);
+
+        return endFrame(*frame);
+    }
+
+    VkCommandBuffer VulkanRenderer::acquireSecondaryBuffer(ThreadCommandPool& pool) const {
+        if (pool.used == pool.commandBuffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            if (vkAllocateCommandBuffers(resources_.logicalDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate secondary command buffer!");
+            }
+            pool.commandBuffers.push_back(commandBuffer);
+        }
+        return pool.commandBuffers[pool.used++];
+    }
+
+    void VulkanRenderer::recreateSwapchain() {
+        auto& res = resources_;
+
+        // Retired swapchains otherwise pile up if the new ones never hand out every image
+        if (swapchain_.getRetiredCount() >= MaxRetiredSwapchains) {
+            log_debug("{} retired swapchains pending; waiting for the device to release them.",
+                      swapchain_.getRetiredCount());
+            vkDeviceWaitIdle(res.logicalDevice);
+            releaseRetired(UINT64_MAX, UINT64_MAX);
+        }
+
+        // Frames begun so far may still use the current per-image objects
+        RetiredTargets retired;
+        retired.framebuffers = std::move(res.swapchainFramebuffers);
+        retired.renderFinished = std::move(renderFinished_);
+        retired.frameNumber = frameNumber_;
+        retiredTargets_.push_back(std::move(retired));
+        res.swapchainFramebuffers.clear();
+        renderFinished_.clear();
+
+        const VkExtent2D extent = window_ != nullptr
+            ? VkExtent2D { static_cast<uint32_t>(framebufferSize_.width), static_cast<uint32_t>(framebufferSize_.height) }
+            : res.swapchainExtent;
+        swapchain_.recreateSwapchain(extent, frameNumber_);
+        if (!res.dynamicRenderingEnabled) {
+            createFramebuffers();
+        }
+        createRenderFinishedSemaphores();
+        swapchainDirty_ = false;
+
+        imagesAcquired_.assign(res.swapchainImages.size(), false);
+        unacquiredImages_ = imagesAcquired_.size();
+        swapchainFrameNumber_ = frameNumber_;
+    }
+
+    void VulkanRenderer::noteAcquired(const uint32_t imageIndex) {
+        if (unacquiredImages_ == 0 || imagesAcquired_[imageIndex]) {
+            return;
+        }
+        imagesAcquired_[imageIndex] = true;
+        // Every image came back, so no present from before the recreation is still queued
+        if (--unacquiredImages_ == 0) {
+            presentedFrames_ = swapchainFrameNumber_;
+        }
+    }
+
+    void VulkanRenderer::releaseRetired(const u64 completedFrames, const u64 presentedFrames) {
+        const auto& res = resources_;
+        swapchain_.releaseRetired(presentedFrames);
+
+        std::erase_if(retiredTargets_, [&](RetiredTargets& retired) {
+            if (retired.frameNumber <= completedFrames) {
+                for (const auto framebuffer : retired.framebuffers) {
+                    vkDestroyFramebuffer(res.logicalDevice, framebuffer, nullptr);
+                }
+                retired.framebuffers.clear();
+            }
+            if (retired.frameNumber <= presentedFrames) {
+                for (const auto semaphore : retired.renderFinished) {
+                    vkDestroySemaphore(res.logicalDevice, semaphore, nullptr);
+                }
+                retired.renderFinished.clear();
+            }
+            return retired.framebuffers.empty() && retired.renderFinished.empty();
+        });
+    }
+
+    void VulkanRenderer::addLatencySample(const core::FramePacer::Clock::time_point inputTime, const bool presentMeasured) {
+        const f64 milliseconds =
+            std::chrono::duration<f64, std::milli>(core::FramePacer::Clock::now() - inputTime).count();
+
+        auto& stats = latencyStatistics_;
+        stats.lastMilliseconds = milliseconds;
+        stats.averageMilliseconds = stats.sampleCount == 0
+                                  ? milliseconds
+                                  : stats.averageMilliseconds + (milliseconds - stats.averageMilliseconds) / 16.0;
+        stats.presentMeasured = presentMeasured;
+        ++stats.sampleCount;
+    }
+
+    void VulkanRenderer::createFramebuffers() const {
+        auto& res = resources_;
+
+        res.swapchainFramebuffers.resize(res.swapchainImageViews.size(), VK_NULL_HANDLE);
+        for (size_t i = 0; i < res.swapchainImageViews.size(); i++) {
+            const std::array<VkImageView, 2> attachments = { res.swapchainImageViews[i], res.depthImageView };
+
+            VkFramebufferCreateInfo framebufferInfo = {};
+            framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferInfo.renderPass = res.renderPass;
+            framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+            framebufferInfo.pAttachments = attachments.data();
+            framebufferInfo.width = res.swapchainExtent.width;
+            framebufferInfo.height = res.swapchainExtent.height;
+            framebufferInfo.layers = 1;
+
+            if (vkCreateFramebuffer(res.logicalDevice, &framebufferInfo, nullptr, &res.swapchainFramebuffers[i]) != VK_SUCCESS) {
+                destroyFramebuffers();
+                throw std::runtime_error("Failed to create framebuffer for swapchain image " + std::to_string(i));
+            }
+        }
+
+        log_trace("Created {} framebuffers.", res.swapchainFramebuffers.size());
+    }
+
+    void VulkanRenderer::destroyFramebuffers() const {
+        auto& res = resources_;
+        for (const auto framebuffer : res.swapchainFramebuffers) {
+            if (framebuffer != VK_NULL_HANDLE) {
+                vkDestroyFramebuffer(res.logicalDevice, framebuffer, nullptr);
+            }
+        }
+        res.swapchainFramebuffers.clear();
+    }
+
+    void VulkanRenderer::createFrameResources(const uint32_t framesInFlight) {
+        const auto& res = resources_;
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT; // Reset as a whole every frame
+        poolInfo.queueFamilyIndex = res.graphicsQueueFamily;
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT; // The first wait on each slot returns immediately
+
+        frames_.resize(framesInFlight);
+        for (auto& frame : frames_) {
+            if (vkCreateCommandPool(res.logicalDevice, &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create command pool!");
+            }
+
+            VkCommandBufferAllocateInfo allocInfo = {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.commandPool = frame.commandPool;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+            if (vkAllocateCommandBuffers(res.logicalDevice, &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate command buffer!");
+            }
+
+            frame.threadPools.resize(jobSystem_->getThreadCount());
+            for (auto& threadPool : frame.threadPools) {
+                if (vkCreateCommandPool(res.logicalDevice, &poolInfo, nullptr, &threadPool.commandPool) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create recording command pool!");
+                }
+            }
+
+            if (vkCreateSemaphore(res.logicalDevice, &semaphoreInfo, nullptr, &frame.imageAvailable) != VK_SUCCESS ||
+                vkCreateFence(res.logicalDevice, &fenceInfo, nullptr, &frame.inFlight) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create frame synchronization objects!");
+            }
+        }
+
+        createRenderFinishedSemaphores();
+        currentFrame_ = 0;
+    }
+
+    void VulkanRenderer::createRenderFinishedSemaphores() {
+        const auto& res = resources_;
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        renderFinished_.resize(res.swapchainImages.size(), VK_NULL_HANDLE);
+        for (auto& semaphore : renderFinished_) {
+            if (vkCreateSemaphore(res.logicalDevice, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create frame synchronization objects!");
+            }
+        }
+    }
+
+    void VulkanRenderer::destroyFrameResources() {
+        const auto& res = resources_;
+
+        for (const auto& frame : frames_) {
+            if (frame.inFlight != VK_NULL_HANDLE) {
+                vkDestroyFence(res.logicalDevice, frame.inFlight, nullptr);
+            }
+            if (frame.imageAvailable != VK_NULL_HANDLE) {
+                vkDestroySemaphore(res.logicalDevice, frame.imageAvailable, nullptr);
+            }
+            if (frame.commandPool != VK_NULL_HANDLE) {
+                // Frees the command buffer as well
+                vkDestroyCommandPool(res.logicalDevice, frame.commandPool, nullptr);
+            }
+            for (const auto& threadPool : frame.threadPools) {
+                if (threadPool.commandPool != VK_NULL_HANDLE) {
+                    vkDestroyCommandPool(res.logicalDevice, threadPool.commandPool, nullptr);
+                }
+            }
+        }
+        frames_.clear();
+        secondaryBuffers_.clear();
+
+        for (const auto semaphore : renderFinished_) {
+            if (semaphore != VK_NULL_HANDLE) {
+                vkDestroySemaphore(res.logicalDevice, semaphore, nullptr);
+            }
+        }
+        renderFinished_.clear();
+
+        log_trace("Destroyed renderer frame resources.");
+    }
+}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "graphics/vulkan_resources.hpp"
+#include "graphics/graphic_types.hpp"
+#include "graphics/vulkan_configuration.hpp"
+#include "core/frame_pacer.hpp"
+#include "core/job_system.hpp"
+#include <functional>
+
+namespace time_kill::core {
+    class Window;
+}
+
+namespace time_kill::graphics {
+    class VulkanSwapchain;
+
+    //! State of the frame that is currently being recorded, returned by VulkanRenderer::beginFrame.
+    struct FrameContext {
+        uint32_t frameIndex = 0;                         //!< Frame-in-flight slot, 0 .. framesInFlight - 1
+        uint32_t imageIndex = 0;                         //!< Acquired swapchain image
+        u64 frameNumber = 0;                             //!< Frames begun since the renderer was created
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;  //!< Primary command buffer, already in recording state
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;      //!< VK_NULL_HANDLE with dynamic rendering
+        VkImage image = VK_NULL_HANDLE;                  //!< Acquired swapchain image
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkExtent2D extent = {};
+    };
+
+    //! Input-to-display latency of recent frames, measured from waitForNextFrame (or beginFrame if the
+    //! app doesn't call it) of a frame.
+    struct LatencyStatistics {
+        f64 lastMilliseconds = 0.0;
+        f64 averageMilliseconds = 0.0;  //!< Exponential moving average over roughly the last 16 frames
+        u64 sampleCount = 0;
+
+        //! True if measured up to the present via VK_KHR_present_wait. Otherwise it is estimated up to
+        //! the point the CPU saw the frame's fence signaled, which leaves out the wait for scan-out.
+        bool presentMeasured = false;
+    };
+
+    //! Drives the frame loop: acquire -> record -> submit -> present.
+    //!
+    //! Every frame-in-flight slot owns a command pool, a primary command buffer, an "image available"
+    //! semaphore and a fence; every swapchain image owns a framebuffer and a "render finished" semaphore.
+    //! beginFrame only blocks on the fence of the slot it is about to reuse, so the CPU waits for the
+    //! GPU only when all frames in flight are still busy.
+    //!
+    //! Draw lists can be recorded in parallel on the job system: every slot also owns one command pool
+    //! per job system thread, from which that thread allocates secondary command buffers. The pools are reset once per
+    //! frame in beginFrame and their buffers are reused, so steady-state recording allocates nothing.
+    //!
+    //! With dynamic rendering (VulkanResources::dynamicRenderingEnabled) there are no framebuffers;
+    //! beginRenderPass transitions the acquired image and calls vkCmdBeginRendering instead.
+    //!
+    //! The swapchain is recreated by beginFrame when the window's framebuffer size changed or the
+    //! previous acquire/present reported it out of date or suboptimal, without waiting for the device
+    //! to idle: the old swapchain, framebuffers and semaphores are retired. Framebuffers are destroyed
+    //! once every frame begun before the recreation has signaled its fence. The fences do not cover
+    //! the presents waiting on the render-finished semaphores, so those and the old swapchain are
+    //! kept until the new swapchain has handed out each of its images once, which the presentation
+    //! engine can only do after it has taken the earlier presents off the queue. That may never happen
+    //! while resizes keep coming (MAILBOX in particular need not hand out every image), so once
+    //! MaxRetiredSwapchains are pending the next recreation waits for the device to idle and releases
+    //! them all.
+    //!
+    //! Offscreen (VulkanResources::offscreen) every frame-in-flight slot renders to its own image;
+    //! nothing is acquired or presented, and endFrame only submits.
+    //!
+    //! The LatencyPolicy decides the number of frames in flight and what waitForNextFrame does: pace
+    //! the loop to a target frame rate and, with present wait, hold the CPU back until the previous
+    //! frame is on screen so input is sampled as late as possible.
+    class VulkanRenderer {
+    public:
+        using RecordCallback = std::function<void(const FrameContext& frame)>;
+
+        //! Records draws [begin, end) of a draw list into `commandBuffer`, a secondary command buffer that
+        //! continues the frame's render pass, with viewport and scissor already set. Called concurrently
+        //! from several threads.
+        using SecondaryRecordCallback = std::function<void(VkCommandBuffer commandBuffer, usize begin, usize end)>;
+
+        //! Smallest number of draws worth a secondary command buffer of its own.
+        static constexpr usize MinDrawsPerSecondaryBuffer = 64;
+
+        VulkanRenderer(VulkanResources& resources, VulkanSwapchain& swapchain);
+        ~VulkanRenderer();
+
+        VulkanRenderer(const VulkanRenderer&) = delete;
+        VulkanRenderer& operator=(const VulkanRenderer&) = delete;
+
+        //! Creates framebuffers, command pools, command buffers and synchronization objects.
+        //! Requires the swapchain and, unless dynamic rendering is enabled, the render pass.
+        //! Parallel recording runs on `jobSystem`; it and `window` must outlive the renderer. Without a
+        //! window (headless) the targets keep their size.
+        void createRenderer(const core::Window* window, const LatencyPolicy& latencyPolicy,
+                            core::JobSystem& jobSystem = core::JobSystem::getInstance());
+        void destroyRenderer();
+
+        //! Call at the top of the frame loop, right before polling input: waits for the previous frame
+        //! to be presented (if the policy asks for it and the device supports present wait), then for
+        //! the frame pacer. The frame's latency is measured from the return of this call.
+        void waitForNextFrame();
+
+        //! Waits until the next frame slot is free, recreates the swapchain if needed, acquires a
+        //! swapchain image and begins the slot's command buffer. Returns an empty optional if no image
+        //! could be acquired (e.g. the window is minimized); no frame is begun then.
+        [[nodiscard]] Optional<FrameContext> beginFrame();
+
+        //! Begins the render pass on the frame's framebuffer (or dynamic rendering on the frame's
+        //! image), clearing color and depth. Pass VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS before
+        //! calling recordParallel.
+        void beginRenderPass(const FrameContext& frame, const VkClearColorValue& clearColor,
+                             VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) const;
+        void endRenderPass(const FrameContext& frame) const;
+
+        //! Sets viewport and scissor to cover `extent`. beginRenderPass does this for the primary
+        //! command buffer and recordParallel for every secondary one, since they don't inherit it.
+        static void setViewport(VkCommandBuffer commandBuffer, VkExtent2D extent);
+
+        //! Ends the command buffer, submits it and presents the image. Returns false if the swapchain
+        //! is out of date or suboptimal; the next beginFrame recreates it.
+        bool endFrame(const FrameContext& frame);
+
+        //! Splits a draw list of `drawCount` draws into contiguous chunks, records each chunk into its own
+        //! secondary command buffer on the job system and executes them in order in the frame's primary
+        //! command buffer. The render pass must have been begun with secondary contents. Must be called
+        //! from the thread that drives the frame loop.
+        void recordParallel(const FrameContext& frame, usize drawCount, const SecondaryRecordCallback& record);
+
+        //! Convenience wrapper around beginFrame/beginRenderPass/endRenderPass/endFrame; `record` is
+        //! called inside the render pass. Returns false if the frame was skipped or the swapchain needs
+        //! to be recreated.
+        bool drawFrame(const VkClearColorValue& clearColor, const RecordCallback& record = {});
+
+        //! Same as drawFrame, but records the draw list in parallel through recordParallel.
+        bool drawFrameParallel(const VkClearColorValue& clearColor, usize drawCount,
+                               const SecondaryRecordCallback& record);
+
+        //! Makes the next beginFrame recreate the swapchain, e.g. from a window resize callback.
+        void requestSwapchainRecreation() { swapchainDirty_ = true; }
+
+        [[nodiscard]] uint32_t getFramesInFlight() const { return static_cast<uint32_t>(frames_.size()); }
+        [[nodiscard]] u64 getFrameNumber() const { return frameNumber_; }
+
+        //! Frames numbered below this have finished on the GPU.
+        [[nodiscard]] u64 getCompletedFrameCount() const { return completedFrames_; }
+        [[nodiscard]] usize getRecordingThreadCount() const { return jobSystem_ ? jobSystem_->getThreadCount() : 1; }
+
+        [[nodiscard]] const LatencyStatistics& getLatencyStatistics() const { return latencyStatistics_; }
+        [[nodiscard]] core::FramePacer& getFramePacer() { return framePacer_; }
+
+    private:
+        //! Secondary command buffers of one recording thread in one frame slot.
+        struct ThreadCommandPool {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            Vector<VkCommandBuffer> commandBuffers; // Allocated on demand, kept across frames
+            usize used = 0;                         // Handed out since the last pool reset
+        };
+
+        struct FrameResources {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            VkSemaphore imageAvailable = VK_NULL_HANDLE;
+            VkFence inFlight = VK_NULL_HANDLE;
+            Vector<ThreadCommandPool> threadPools; // Indexed by JobSystem::getThreadIndex
+            Optional<u64> submittedFrame;          // Frame number last submitted from this slot
+            core::FramePacer::Clock::time_point inputTime; // When the submitted frame sampled input
+        };
+
+        //! Per-image objects of a replaced swapchain, destroyed once older frames finished.
+        struct RetiredTargets {
+            Vector<VkFramebuffer> framebuffers;    // Released with the frame fences
+            Vector<VkSemaphore> renderFinished;    // Released once their presents are done
+            u64 frameNumber = 0;                   // Frames numbered below may still use them
+        };
+
+        VkCommandBuffer acquireSecondaryBuffer(ThreadCommandPool& pool) const;
+
+        //! Dynamic rendering counterparts of beginRenderPass/endRenderPass, including the layout
+        //! transitions the render pass would otherwise do.
+        void beginRendering(const FrameContext& frame, const VkClearColorValue& clearColor, VkSubpassContents contents) const;
+        void endRendering(const FrameContext& frame) const;
+
+        //! Recreates the swapchain and the per-image objects, retiring the old ones.
+        void recreateSwapchain();
+        //! Destroys what only frames below `completedFrames`, or presents of frames below
+        //! `presentedFrames`, could still use.
+        void releaseRetired(u64 completedFrames, u64 presentedFrames);
+        //! Tracks the first acquire of every image of a recreated swapchain.
+        void noteAcquired(uint32_t imageIndex);
+        void addLatencySample(core::FramePacer::Clock::time_point inputTime, bool presentMeasured);
+
+        void createFramebuffers() const;
+        void destroyFramebuffers() const;
+        void createRenderFinishedSemaphores();
+        void createFrameResources(uint32_t framesInFlight);
+        void destroyFrameResources();
+
+        VulkanResources& resources_;
+        VulkanSwapchain& swapchain_;
+        const core::Window* window_ = nullptr;
+        Vector<FrameResources> frames_;
+        Vector<VkSemaphore> renderFinished_; // Indexed by swapchain image
+        core::JobSystem* jobSystem_ = nullptr;
+        Vector<VkCommandBuffer> secondaryBuffers_; // Per chunk, reused by recordParallel
+        uint32_t currentFrame_ = 0;
+        u64 frameNumber_ = 0;
+        u64 completedFrames_ = 0;
+        bool swapchainDirty_ = false;
+        FramebufferSize framebufferSize_;    // Last size seen, to notice resizes
+        static constexpr usize MaxRetiredSwapchains = 4; // Beyond this, recreating waits for the device
+        Vector<RetiredTargets> retiredTargets_;
+        Vector<bool> imagesAcquired_;        // Per image of the current swapchain, since it was created
+        usize unacquiredImages_ = 0;
+        u64 swapchainFrameNumber_ = 0;       // frameNumber_ when the current swapchain was created
+        u64 presentedFrames_ = 0;            // Presents of frames below are no longer queued
+
+        //=== Latency
+        static constexpr u64 PresentWaitTimeout = 100'000'000; // ns; a frame never shown must not hang the loop
+
+        core::FramePacer framePacer_;
+        bool waitForPresent_ = false;
+        PFN_vkWaitForPresentKHR vkWaitForPresent_ = nullptr;
+        Optional<core::FramePacer::Clock::time_point> pendingInputTime_; // Set by waitForNextFrame
+        u64 lastPresentId_ = 0;                                           // 0: nothing presented yet
+        VkSwapchainKHR lastPresentSwapchain_ = VK_NULL_HANDLE;
+        core::FramePacer::Clock::time_point lastPresentInputTime_;
+        LatencyStatistics latencyStatistics_;
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "prerequisites.hpp"
+#include "vulkan_memory_allocator.hpp"
 #include <vulkan/vulkan.h>
 
 namespace time_kill::graphics {
@@ -15,24 +16,41 @@ namespace time_kill::graphics {
         VkDevice logicalDevice = VK_NULL_HANDLE;
         VkQueue graphicsQueue = VK_NULL_HANDLE;
         VkQueue presentQueue = VK_NULL_HANDLE;
+        uint32_t graphicsQueueFamily = 0;
+        uint32_t presentQueueFamily = 0;
+        bool memoryBudgetSupported = false;              // VK_EXT_memory_budget is enabled
+        bool pipelineCreationFeedbackSupported = false;  // Vulkan 1.3 or VK_EXT_pipeline_creation_feedback
+        bool dynamicRenderingEnabled = false;            // Frames use vkCmdBeginRendering; there is no render pass
+        bool extendedDynamicStateSupported = false;      // Vulkan 1.3; cull mode, topology, depth state may be dynamic
+        bool presentWaitSupported = false;               // VK_KHR_present_id and VK_KHR_present_wait are enabled
+        bool offscreen = false;                          // No surface: frames render to offscreen images, nothing is presented
+        bool pipelineStatisticsSupported = false;        // The pipelineStatisticsQuery feature is enabled
+        uint32_t timestampValidBits = 0;                 // Of the graphics queue; 0 if it cannot write timestamps
+        f32 timestampPeriod = 0.0f;                      // Nanoseconds per timestamp tick
 
-        //=== Swapchain-related resources
+        //=== Swapchain-related resources (offscreen: swapchainImages are plain images, swapchain is null)
         VkSwapchainKHR swapchain = VK_NULL_HANDLE;
         VkFormat swapchainImageFormat = VK_FORMAT_UNDEFINED;
         VkExtent2D swapchainExtent = {};
         Vector<VkImage> swapchainImages;
         Vector<VkImageView> swapchainImageViews;
+        VkImageLayout colorTargetLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // Layout frames leave the color target in
+        bool colorTargetReadable = false;                // Color target images allow transfer reads (frame readback)
 
         //=== Depth Buffer
         VkFormat depthFormat = VK_FORMAT_UNDEFINED;
         VkImage depthImage = VK_NULL_HANDLE;
-        VkDeviceMemory depthImageMemory = VK_NULL_HANDLE;
+        MemoryAllocation depthImageAllocation;
         VkImageView depthImageView = VK_NULL_HANDLE;
 
-        //=== Render Pass
+        //=== Render Pass (VK_NULL_HANDLE with dynamic rendering)
         VkRenderPass renderPass = VK_NULL_HANDLE;
 
+        //=== Framebuffers (one per swapchain image; none with dynamic rendering)
+        Vector<VkFramebuffer> swapchainFramebuffers;
+
         //=== Graphics Pipeline
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
         VkPipeline graphicsPipeline = VK_NULL_HANDLE;
         VkPipelineLayout graphicsPipelineLayout = VK_NULL_HANDLE;
     };
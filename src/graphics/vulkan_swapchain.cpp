@@ -1,32 +1,30 @@
 #include "vulkan_swapchain.hpp"
 #include "vulkan_context.hpp"
 #include "vulkan_mappings.hpp"
+#include "vulkan_tools.hpp"
 #include "core/logger.hpp"
-#include "core/window.hpp"
 #include <algorithm>
 
 namespace time_kill::graphics {
     void logSurfaceFormat(const VulkanMappings& mappings, const Vector<VkSurfaceFormatKHR>& formats) {
         for (const auto&[format, _] : formats) {
-            core::Logger::getInstance().debug(
-                std::format("- {}", mappings.getFormatDescription(format))
-            );
+            log_debug("- {}", mappings.getFormatDescription(format));
         }
     }
 
     void logPresentModes(const VulkanMappings& mappings, const Vector<VkPresentModeKHR>& present_modes) {
         for (const auto& present_mode : present_modes) {
-            core::Logger::getInstance().debug(
-                std::format("- {}", mappings.getPresentModeDescription(present_mode))
-            );
+            log_debug("- {}", mappings.getPresentModeDescription(present_mode));
         }
     }
 
-    VulkanSwapchain::VulkanSwapchain(VulkanResources& resources) : resources_(resources) {}
+    VulkanSwapchain::VulkanSwapchain(VulkanResources& resources, VulkanMemoryAllocator& memoryAllocator,
+                                     const LatencyPolicy& latencyPolicy)
+        : resources_(resources), memoryAllocator_(memoryAllocator), latencyPolicy_(latencyPolicy) {}
 
-    void VulkanSwapchain::createSwapchain(const core::Window& window) const {
+    void VulkanSwapchain::createSwapchain(const VkExtent2D extent) {
         auto& res = resources_;
-        if (res.swapchain != VK_NULL_HANDLE) {
+        if (res.swapchain != VK_NULL_HANDLE || !res.swapchainImages.empty()) {
             destroySwapchain();
         }
 
@@ -37,70 +35,188 @@ namespace time_kill::graphics {
         if (res.logicalDevice == nullptr)
             throw std::runtime_error("Unable to create swapchain; logical device is null!");
 
-        const VulkanMappings mappings {};
+        querySurfaceSupport();
+        res.colorTargetLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        buildSwapchain(extent, VK_NULL_HANDLE);
 
-        // Query swapchain support
-        VkSurfaceCapabilitiesKHR surfaceCapabilities;
-        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(res.physicalDevice, res.surface, &surfaceCapabilities);
+        // Create the depth buffer shared by all framebuffers
+        pickDepthFormat();
+        createDepthResources();
+    }
+
+    void VulkanSwapchain::createOffscreenTargets(const VkExtent2D extent, const VkFormat format, const uint32_t imageCount) {
+        auto& res = resources_;
+        if (res.swapchain != VK_NULL_HANDLE || !res.swapchainImages.empty()) {
+            destroySwapchain();
+        }
+
+        if (res.logicalDevice == nullptr)
+            throw std::runtime_error("Unable to create offscreen targets; logical device is null!");
+        if (extent.width == 0 || extent.height == 0 || imageCount == 0)
+            throw std::runtime_error("Unable to create offscreen targets; size and image count must not be zero!");
+
+        res.swapchainExtent = extent;
+        res.swapchainImageFormat = format;
+        res.colorTargetLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        res.colorTargetReadable = true;
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { extent.width, extent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        res.swapchainImages.resize(imageCount, VK_NULL_HANDLE);
+        offscreenAllocations_.resize(imageCount);
+        try {
+            for (uint32_t i = 0; i < imageCount; i++) {
+                if (vkCreateImage(res.logicalDevice, &imageInfo, nullptr, &res.swapchainImages[i]) != VK_SUCCESS) {
+                    throw std::runtime_error("Failed to create offscreen image!");
+                }
+                offscreenAllocations_[i] = memoryAllocator_.allocateForImage(res.swapchainImages[i], MemoryUsage::GpuOnly);
+            }
+            createImageViews();
+        } catch (const std::exception&) {
+            destroyOffscreenImages();
+            throw;
+        }
+
+        pickDepthFormat();
+        createDepthResources();
+
+        log_debug("Created {} offscreen targets ({}x{}).", imageCount, extent.width, extent.height);
+    }
+
+    void VulkanSwapchain::recreateSwapchain(const VkExtent2D extent, const u64 frameNumber) {
+        auto& res = resources_;
+        if (res.swapchain == VK_NULL_HANDLE) {
+            createSwapchain(extent);
+            return;
+        }
+
+        // Frames in flight still render to the old images; keep everything they use alive
+        RetiredSwapchain retired;
+        retired.swapchain = res.swapchain;
+        retired.imageViews = std::move(res.swapchainImageViews);
+        retired.depthImage = res.depthImage;
+        retired.depthImageAllocation = res.depthImageAllocation;
+        retired.depthImageView = res.depthImageView;
+        retired.frameNumber = frameNumber;
+        retired_.push_back(std::move(retired));
+
+        res.swapchain = VK_NULL_HANDLE;
+        res.swapchainImages.clear();
+        res.swapchainImageViews.clear();
+        res.depthImage = VK_NULL_HANDLE;
+        res.depthImageAllocation = {};
+        res.depthImageView = VK_NULL_HANDLE;
+
+        buildSwapchain(extent, retired_.back().swapchain);
+        createDepthResources();
+
+        log_debug("Recreated swapchain ({}x{}); {} retired swapchains pending.",
+                  res.swapchainExtent.width, res.swapchainExtent.height, retired_.size());
+    }
+
+    void VulkanSwapchain::releaseRetired(const u64 presentedFrames) {
+        std::erase_if(retired_, [&](RetiredSwapchain& retired) {
+            if (retired.frameNumber > presentedFrames) {
+                return false;
+            }
+            destroyRetired(retired);
+            return true;
+        });
+    }
+
+    void VulkanSwapchain::querySurfaceSupport() {
+        const auto& res = resources_;
+        if (!surfaceFormats_.empty() && !presentModes_.empty()) {
+            return;
+        }
+
+        const VulkanMappings mappings {};
 
         // Query surface format
-        Vector<VkSurfaceFormatKHR> surfaceFormats;
-        uint32_t surfaceFormatCount;
+        uint32_t surfaceFormatCount = 0;
         vkGetPhysicalDeviceSurfaceFormatsKHR(res.physicalDevice, res.surface, &surfaceFormatCount, nullptr);
         if (surfaceFormatCount != 0) {
-            surfaceFormats.resize(surfaceFormatCount);
-            vkGetPhysicalDeviceSurfaceFormatsKHR(res.physicalDevice, res.surface, &surfaceFormatCount, surfaceFormats.data());
+            surfaceFormats_.resize(surfaceFormatCount);
+            vkGetPhysicalDeviceSurfaceFormatsKHR(res.physicalDevice, res.surface, &surfaceFormatCount, surfaceFormats_.data());
             if (log_is_trace_enabled()) {
-                log_debug(std::format("Found {} surface formats:", surfaceFormatCount));
-                logSurfaceFormat(mappings, surfaceFormats);
+                log_debug("Found {} surface formats:", surfaceFormatCount);
+                logSurfaceFormat(mappings, surfaceFormats_);
             } else {
-                log_debug(std::format("Found {} surface formats", surfaceFormatCount));
+                log_debug("Found {} surface formats", surfaceFormatCount);
             }
         } else {
             throw std::runtime_error("Failed to get surface formats!");
         }
 
         // Query presentation modes
-        Vector<VkPresentModeKHR> presentModes; 
-        uint32_t presentModeCount;
+        uint32_t presentModeCount = 0;
         vkGetPhysicalDeviceSurfacePresentModesKHR(res.physicalDevice, res.surface, &presentModeCount, nullptr);
-        if(presentModeCount != 0) {
-            presentModes.resize(presentModeCount);
-            vkGetPhysicalDeviceSurfacePresentModesKHR(res.physicalDevice, res.surface, &presentModeCount, presentModes.data());
+        if (presentModeCount != 0) {
+            presentModes_.resize(presentModeCount);
+            vkGetPhysicalDeviceSurfacePresentModesKHR(res.physicalDevice, res.surface, &presentModeCount, presentModes_.data());
             if (log_is_trace_enabled()) {
-                log_debug(std::format("Found {} present modes:", presentModeCount));
-                logPresentModes(mappings, presentModes);
+                log_debug("Found {} present modes:", presentModeCount);
+                logPresentModes(mappings, presentModes_);
             } else {
-                log_debug(std::format("Found {} present modes", presentModeCount));
+                log_debug("Found {} present modes", presentModeCount);
             }
         } else {
+            surfaceFormats_.clear();
             throw std::runtime_error("Failed to get presentation modes!");
         }
+    }
+
+    void VulkanSwapchain::buildSwapchain(const VkExtent2D extent, const VkSwapchainKHR oldSwapchain) {
+        auto& res = resources_;
+        const VulkanMappings mappings {};
+
+        // The capabilities carry the current extent, so they are queried every time
+        VkSurfaceCapabilitiesKHR surfaceCapabilities;
+        vkGetPhysicalDeviceSurfaceCapabilitiesKHR(res.physicalDevice, res.surface, &surfaceCapabilities);
 
         // Choose the best settings for the swapchain
-        auto [format, colorSpace] = chooseSwapSurfaceFormat(surfaceFormats);
-        const VkPresentModeKHR presentMode = chooseSwapPresentMode(presentModes);
-        res.swapchainExtent = chooseSwapExtent(surfaceCapabilities, window);
+        auto [format, colorSpace] = chooseSwapSurfaceFormat(surfaceFormats_);
+        const VkPresentModeKHR presentMode = chooseSwapPresentMode(presentModes_, latencyPolicy_.presentModes);
+        res.swapchainExtent = chooseSwapExtent(surfaceCapabilities, extent);
 
-        if (log_is_debug_enabled()) {
-            log_debug(std::format("Picked format: {}", mappings.getFormatDescription(format)));
-            log_debug(std::format("Picked present mode: {}", mappings.getPresentModeDescription(presentMode)));
+        if (oldSwapchain == VK_NULL_HANDLE && log_is_debug_enabled()) {
+            log_debug("Picked format: {}", mappings.getFormatDescription(format));
+            log_debug("Picked present mode: {}", mappings.getPresentModeDescription(presentMode));
         }
 
         // Create the swapchain
         VkSwapchainCreateInfoKHR createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
         createInfo.surface = res.surface;
-        createInfo.minImageCount = surfaceCapabilities.minImageCount + 1;
+        createInfo.minImageCount = surfaceCapabilities.minImageCount + latencyPolicy_.extraSwapchainImages;
+        if (surfaceCapabilities.maxImageCount > 0) {
+            createInfo.minImageCount = std::min(createInfo.minImageCount, surfaceCapabilities.maxImageCount);
+        }
         createInfo.imageFormat = format;
         createInfo.imageColorSpace = colorSpace;
         createInfo.imageExtent = res.swapchainExtent;
         createInfo.imageArrayLayers = 1;
         createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        if (surfaceCapabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) {
+            createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT; // Lets frames be read back
+        }
+        res.colorTargetReadable = (createInfo.imageUsage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
         createInfo.preTransform = surfaceCapabilities.currentTransform;
         createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         createInfo.presentMode = presentMode;
         createInfo.clipped = VK_TRUE;
+        createInfo.oldSwapchain = oldSwapchain; // Lets the driver reuse resources and hand over presentation
 
         VkSwapchainKHR swapchain = nullptr;
         if (vkCreateSwapchainKHR(res.logicalDevice, &createInfo, nullptr, &swapchain) != VK_SUCCESS) {
@@ -110,6 +226,7 @@ namespace time_kill::graphics {
             throw std::runtime_error("Failed to create swapchain! (swapchain is null)");
         }
         res.swapchain = swapchain;
+        presentMode_ = presentMode;
 
         log_debug("Successfully created swapchain!");
 
@@ -117,21 +234,16 @@ namespace time_kill::graphics {
         res.swapchainImageFormat = createInfo.imageFormat;
 
         // Retrieve swapchain images
-        vkGetSwapchainImagesKHR(res.logicalDevice, res.swapchain, &surfaceFormatCount, nullptr);
-        res.swapchainImages.resize(surfaceFormatCount);
-        vkGetSwapchainImagesKHR(res.logicalDevice, res.swapchain, &surfaceFormatCount, res.swapchainImages.data());
+        uint32_t imageCount = 0;
+        vkGetSwapchainImagesKHR(res.logicalDevice, res.swapchain, &imageCount, nullptr);
+        res.swapchainImages.resize(imageCount);
+        vkGetSwapchainImagesKHR(res.logicalDevice, res.swapchain, &imageCount, res.swapchainImages.data());
 
         // Create image views
         createImageViews();
-
-        // Find suitable depth format
-        res.depthFormat = findDepthFormat();
-        if (res.depthFormat != VK_FORMAT_UNDEFINED && log_is_debug_enabled()) {
-            log_debug(std::format("Picked depth format: {}", mappings.getDepthFormatDescription(res.depthFormat)));
-        }
     }
 
-    void VulkanSwapchain::destroySwapchain() const {
+    void VulkanSwapchain::destroySwapchain() {
         auto& res = resources_;
 
         if (res.logicalDevice == VK_NULL_HANDLE) {
@@ -141,15 +253,20 @@ namespace time_kill::graphics {
 
         vkDeviceWaitIdle(res.logicalDevice);
 
+        releaseRetired(UINT64_MAX);
+        destroyDepthResources();
+
         if (!res.swapchainImages.empty()) {
             for (auto const imageView : res.swapchainImageViews) {
                 vkDestroyImageView(res.logicalDevice, imageView, nullptr);
             }
             res.swapchainImageViews.clear();
-            log_debug(std::format("Destroyed {} image views.", res.swapchainImages.size()));
+            log_debug("Destroyed {} image views.", res.swapchainImages.size());
         } else {
             log_debug("No image views to destroy.");
         }
+        destroyOffscreenImages();
+        res.swapchainImages.clear();
 
         if (res.swapchain != VK_NULL_HANDLE) {
             vkDestroySwapchainKHR(res.logicalDevice, res.swapchain, nullptr);
@@ -162,6 +279,44 @@ namespace time_kill::graphics {
         res.swapchain = VK_NULL_HANDLE;
     }
 
+    void VulkanSwapchain::destroyRetired(RetiredSwapchain& retired) const {
+        const auto& res = resources_;
+        for (const auto imageView : retired.imageViews) {
+            vkDestroyImageView(res.logicalDevice, imageView, nullptr);
+        }
+        if (retired.depthImageView != VK_NULL_HANDLE) {
+            vkDestroyImageView(res.logicalDevice, retired.depthImageView, nullptr);
+        }
+        if (retired.depthImage != VK_NULL_HANDLE) {
+            vkDestroyImage(res.logicalDevice, retired.depthImage, nullptr);
+        }
+        memoryAllocator_.free(retired.depthImageAllocation);
+        if (retired.swapchain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(res.logicalDevice, retired.swapchain, nullptr);
+        }
+        log_trace("Released retired swapchain of frame {}.", retired.frameNumber);
+    }
+
+    void VulkanSwapchain::destroyOffscreenImages() {
+        auto& res = resources_;
+        if (offscreenAllocations_.empty()) {
+            return;
+        }
+
+        // Swapchain images belong to the swapchain; only offscreen images are destroyed here
+        for (auto& image : res.swapchainImages) {
+            if (image != VK_NULL_HANDLE) {
+                vkDestroyImage(res.logicalDevice, image, nullptr);
+                image = VK_NULL_HANDLE;
+            }
+        }
+        for (auto& allocation : offscreenAllocations_) {
+            memoryAllocator_.free(allocation);
+        }
+        offscreenAllocations_.clear();
+        res.swapchainImages.clear();
+    }
+
     void VulkanSwapchain::createImageViews() const {
         auto& res = resources_;
         if (res.logicalDevice == VK_NULL_HANDLE) {
@@ -196,12 +351,82 @@ namespace time_kill::graphics {
                 for (size_t j = 0; j < i; j++) {
                     vkDestroyImageView(res.logicalDevice, res.swapchainImageViews[j], nullptr);
                 }
-                log_error(std::format("Failed to create image view for image {}", i));
+                log_error("Failed to create image view for image {}", i);
                 throw std::runtime_error("Failed to create image views!");
             }
         }
 
-        log_debug(std::format("Successfully created {} image views.", imageCount));
+        log_debug("Successfully created {} image views.", imageCount);
+    }
+
+    void VulkanSwapchain::pickDepthFormat() const {
+        // Find suitable depth format; it does not change when the swapchain is recreated
+        auto& res = resources_;
+        res.depthFormat = findDepthFormat();
+        if (res.depthFormat != VK_FORMAT_UNDEFINED && log_is_debug_enabled()) {
+            const VulkanMappings mappings {};
+            log_debug("Picked depth format: {}", mappings.getDepthFormatDescription(res.depthFormat));
+        }
+    }
+
+    void VulkanSwapchain::createDepthResources() const {
+        auto& res = resources_;
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent = { res.swapchainExtent.width, res.swapchainExtent.height, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = res.depthFormat;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(res.logicalDevice, &imageInfo, nullptr, &res.depthImage) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create depth image!");
+        }
+
+        try {
+            res.depthImageAllocation = memoryAllocator_.allocateForImage(res.depthImage, MemoryUsage::GpuOnly);
+        } catch (const std::exception&) {
+            destroyDepthResources();
+            throw;
+        }
+
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = res.depthImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = res.depthFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(res.logicalDevice, &viewInfo, nullptr, &res.depthImageView) != VK_SUCCESS) {
+            destroyDepthResources();
+            throw std::runtime_error("Failed to create depth image view!");
+        }
+
+        log_trace("Created depth buffer ({}x{}).", res.swapchainExtent.width, res.swapchainExtent.height);
+    }
+
+    void VulkanSwapchain::destroyDepthResources() const {
+        auto& res = resources_;
+
+        if (res.depthImageView != VK_NULL_HANDLE) {
+            vkDestroyImageView(res.logicalDevice, res.depthImageView, nullptr);
+            res.depthImageView = VK_NULL_HANDLE;
+        }
+        if (res.depthImage != VK_NULL_HANDLE) {
+            vkDestroyImage(res.logicalDevice, res.depthImage, nullptr);
+            res.depthImage = VK_NULL_HANDLE;
+        }
+        memoryAllocator_.free(res.depthImageAllocation);
     }
 
     VkSurfaceFormatKHR VulkanSwapchain::chooseSwapSurfaceFormat(const Vector<VkSurfaceFormatKHR>& availableFormats) {
@@ -223,37 +448,28 @@ namespace time_kill::graphics {
         return availableFormats[0];
     }
 
-    VkPresentModeKHR VulkanSwapchain::chooseSwapPresentMode(const Vector<VkPresentModeKHR>& availablePresentModes) {
-        // Preferred mode: MAILBOX (Triple Buffering)
-        constexpr VkPresentModeKHR preferredMode = VK_PRESENT_MODE_MAILBOX_KHR;
-
-        // Check whether the preferred mode is available
-        for (const auto& availablePresentMode : availablePresentModes) {
-            if (availablePresentMode == preferredMode) {
-                return availablePresentMode;
+    VkPresentModeKHR VulkanSwapchain::chooseSwapPresentMode(const Vector<VkPresentModeKHR>& availablePresentModes,
+                                                             const Vector<VkPresentModeKHR>& preferredPresentModes) {
+        // Take the first preferred mode the surface supports
+        for (const auto preferredMode : preferredPresentModes) {
+            if (std::ranges::find(availablePresentModes, preferredMode) != availablePresentModes.end()) {
+                return preferredMode;
             }
         }
 
-        // If the preferred mode is not available, use FIFO (V-Sync)
+        // If none of them is available, use FIFO (V-Sync); every surface supports it
         return VK_PRESENT_MODE_FIFO_KHR;
     }
 
-    VkExtent2D VulkanSwapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, const core::Window& window) {
+    VkExtent2D VulkanSwapchain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, const VkExtent2D extent) {
         // If the current size is defined, use it
         if (capabilities.currentExtent.width != UINT32_MAX) {
             return capabilities.currentExtent;
         }
 
-        // Otherwise, select the size based on the window size
-        int width = 0, height = 0;
-        window.getFramebufferSize(width, height);
-
-        VkExtent2D actualExtent = {
-            static_cast<uint32_t>(width),
-            static_cast<uint32_t>(height)
-        };
-
-        // Limit the size to the minimum and maximum value
+        // Otherwise, use the requested size (window framebuffer or headless target size),
+        // limited to the minimum and maximum value
+        VkExtent2D actualExtent = extent;
         actualExtent.width = std::clamp(actualExtent.width, capabilities.minImageExtent.width,capabilities.maxImageExtent.width);
         actualExtent.height = std::clamp(actualExtent.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
 
@@ -1,29 +1,85 @@
 #pragma once
 
 #include "graphics/vulkan_resources.hpp"
-
-namespace time_kill::core {
-    class Window;
-}
+#include "graphics/vulkan_configuration.hpp"
 
 namespace time_kill::graphics {
+    //! Creates the swapchain, its image views and the depth buffer.
+    //!
+    //! Surface formats and present modes are queried once and cached; they don't change for a surface
+    //! in practice. Resizes go through recreateSwapchain, which hands the current swapchain to the
+    //! driver as oldSwapchain and retires the old resources instead of waiting for the device to idle.
+    //!
+    //! Present mode and image count follow the LatencyPolicy given at construction.
+    //!
+    //! Without a surface, createOffscreenTargets creates plain color images in place of the swapchain
+    //! images, so framebuffers, pipelines and the renderer work the same headless.
     class VulkanSwapchain {
     public:
-        explicit VulkanSwapchain(VulkanResources& resources);
+        VulkanSwapchain(VulkanResources& resources, VulkanMemoryAllocator& memoryAllocator,
+                        const LatencyPolicy& latencyPolicy = {});
         ~VulkanSwapchain() = default;
 
-        void createSwapchain(const core::Window& window) const;
-        void destroySwapchain() const;
+        //! `extent` is used if the surface leaves the size to the swapchain, e.g. the window's
+        //! framebuffer size; otherwise the surface's current size wins.
+        void createSwapchain(VkExtent2D extent);
+
+        //! Creates `imageCount` offscreen color images (and the depth buffer) instead of a swapchain.
+        //! They end every frame in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, ready to be copied.
+        void createOffscreenTargets(VkExtent2D extent, VkFormat format, uint32_t imageCount);
+
+        //! Waits for the device and destroys the swapchain (or offscreen images) and everything retired.
+        void destroySwapchain();
+
+        //! Creates a new swapchain for the current window size. The previous swapchain, its image
+        //! views and the depth buffer are retired: frames numbered below `frameNumber` may still use
+        //! them, so they are destroyed by releaseRetired once the presents of those frames are done.
+        void recreateSwapchain(VkExtent2D extent, u64 frameNumber);
+
+        //! Destroys the retired resources that only frames below `presentedFrames` could use. Their
+        //! presents must be off the queue too, not just their command buffers finished: a swapchain
+        //! can't be destroyed while the presentation engine still holds one of its images.
+        void releaseRetired(u64 presentedFrames);
+
+        [[nodiscard]] usize getRetiredCount() const { return retired_.size(); }
+        [[nodiscard]] VkPresentModeKHR getPresentMode() const { return presentMode_; }
 
     private:
+        struct RetiredSwapchain {
+            VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+            Vector<VkImageView> imageViews;
+            VkImage depthImage = VK_NULL_HANDLE;
+            MemoryAllocation depthImageAllocation;
+            VkImageView depthImageView = VK_NULL_HANDLE;
+            u64 frameNumber = 0;    // Frames numbered below may still use the resources
+        };
+
+        //! Queries surface formats and present modes unless they are cached already.
+        void querySurfaceSupport();
+        void buildSwapchain(VkExtent2D extent, VkSwapchainKHR oldSwapchain);
+        void destroyRetired(RetiredSwapchain& retired) const;
+
         void createImageViews() const;
+        void destroyOffscreenImages();
+        void pickDepthFormat() const;
+        void createDepthResources() const;
+        void destroyDepthResources() const;
 
         static VkSurfaceFormatKHR chooseSwapSurfaceFormat(const Vector<VkSurfaceFormatKHR>& availableFormats);
-        static VkPresentModeKHR chooseSwapPresentMode(const Vector<VkPresentModeKHR>& availablePresentModes);
-        static VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, const core::Window& window);
+        static VkPresentModeKHR chooseSwapPresentMode(const Vector<VkPresentModeKHR>& availablePresentModes,
+                                                      const Vector<VkPresentModeKHR>& preferredPresentModes);
+        static VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, VkExtent2D extent);
 
         [[nodiscard]] VkFormat findDepthFormat() const;
 
         VulkanResources& resources_;
+        VulkanMemoryAllocator& memoryAllocator_;
+        LatencyPolicy latencyPolicy_;
+        VkPresentModeKHR presentMode_ = VK_PRESENT_MODE_FIFO_KHR;
+
+        Vector<VkSurfaceFormatKHR> surfaceFormats_;
+        Vector<VkPresentModeKHR> presentModes_;
+        Vector<RetiredSwapchain> retired_;
+        Vector<MemoryAllocation> offscreenAllocations_; // One per offscreen image
     };
 } // time_kill
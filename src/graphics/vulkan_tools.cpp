@@ -1,8 +1,8 @@
 #include "vulkan_tools.hpp"
 #include "core/logger.hpp"
+#include <algorithm>
 #include <filesystem>
-#include <spirv_reflect.h>
-#include <unordered_set>
+#include <fstream>
 
 namespace time_kill::graphics {
     bool checkValidationLayerSupport(const std::vector<const char*>& validationLayers) {
@@ -54,10 +54,19 @@ namespace time_kill::graphics {
                 indices.graphicsFamily = std::make_optional(i);
             }
 
+            // Without a surface nothing is presented, so there is no present family to find
+            if (surface == VK_NULL_HANDLE) {
+                if (indices.graphicsFamily.has_value()) {
+                    break;
+                }
+                continue;
+            }
+
             VkBool32 presentSupport = false;
             vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 
-            if (glfwGetPhysicalDevicePresentationSupport(instance, device, i) == GLFW_TRUE) {
+            // Ask the surface itself; GLFW's query is unavailable for a headless surface
+            if (presentSupport == VK_TRUE) {
                 indices.presentFamily = std::make_optional(i);
             }
 
@@ -75,14 +84,75 @@ namespace time_kill::graphics {
         return deviceProperties.deviceName;
     }
 
+    uint32_t VulkanTools::findMemoryType(VkPhysicalDevice_T* device,
+                                         const uint32_t typeFilter,
+                                         const VkMemoryPropertyFlags properties) {
+        VkPhysicalDeviceMemoryProperties memoryProperties = {};
+        vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("Failed to find a suitable memory type!");
+    }
+
+    VkImageAspectFlags VulkanTools::getDepthAspectMask(const VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_S8_UINT:
+                return VK_IMAGE_ASPECT_STENCIL_BIT;
+            case VK_FORMAT_D16_UNORM_S8_UINT:
+            case VK_FORMAT_D24_UNORM_S8_UINT:
+            case VK_FORMAT_D32_SFLOAT_S8_UINT:
+                return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+            default:
+                return VK_IMAGE_ASPECT_DEPTH_BIT;
+        }
+    }
+
+    bool VulkanTools::isDeviceExtensionSupported(VkPhysicalDevice_T* device, const StringView extension) {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        Vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        return std::ranges::any_of(availableExtensions, [extension](const VkExtensionProperties& properties) {
+            return extension == properties.extensionName;
+        });
+    }
+
+    bool VulkanTools::isInstanceExtensionSupported(const StringView extension) {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+        Vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+
+        return std::ranges::any_of(availableExtensions, [extension](const VkExtensionProperties& properties) {
+            return extension == properties.extensionName;
+        });
+    }
+
     void VulkanTools::queueWaitIdle(VkQueue_T* queue) {
         if (queue != VK_NULL_HANDLE) {
             vkQueueWaitIdle(queue);
         }
     }
 
-    Vector<String> VulkanTools::getSpirvFiles(const VulkanConfiguration& configuration, const bool recursive) {
-        Vector<String> spirvFiles;
+    String VulkanTools::resolvePath(const VulkanConfiguration& configuration, const String& path) {
+        namespace fs = std::filesystem;
+        const fs::path resolved(path);
+        if (path.empty() || !resolved.is_relative() || configuration.getRootDirectory().empty()) {
+            return path;
+        }
+        return (fs::path(configuration.getRootDirectory()) / resolved).string();
+    }
+
+    Vector<String> VulkanTools::getShaderDirectories(const VulkanConfiguration& configuration) {
+        Vector<String> directories;
         namespace fs = std::filesystem;
 
         // Determine base directory
@@ -102,10 +172,20 @@ namespace time_kill::graphics {
             fs::path shaderPath = rootDir.empty() ? fs::path(dir) : fs::path(rootDir) / dir;
 
             if (!fs::exists(shaderPath) || !fs::is_directory(shaderPath)) {
-                log_warn(std::format("Shader directory '{}' does not exist!", shaderPath.string()));
+                log_warn("Shader directory '{}' does not exist!", shaderPath.string());
                 continue;
             }
+            directories.push_back(shaderPath.string());
+        }
+
+        return directories;
+    }
+
+    Vector<String> VulkanTools::getSpirvFiles(const VulkanConfiguration& configuration, const bool recursive) {
+        Vector<String> spirvFiles;
+        namespace fs = std::filesystem;
 
+        for (const auto& shaderPath : getShaderDirectories(configuration)) {
             // Recursive or non-recursive search
             if (recursive) {
                 for (const auto& entry : fs::recursive_directory_iterator(shaderPath)) {
@@ -125,6 +205,44 @@ namespace time_kill::graphics {
         return spirvFiles;
     }
 
+    Vector<u32> VulkanTools::readSpirvFile(const String& filename) {
+        std::ifstream file(filename, std::ios::ate | std::ios::binary);
+
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open SPIR_V file: " + filename);
+        }
+
+        const size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize % 4 != 0) {
+            throw std::runtime_error("SPIR-V file size is invalid: " + filename);
+        }
+
+        Vector<u32> buffer(fileSize / sizeof(u32));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(fileSize));
+        file.close();
+
+        log_trace("Loaded SPIR-V file: {}, size: {} bytes", filename, fileSize);
+
+        return buffer;
+    }
+
+    VkShaderModule VulkanTools::createShaderModule(const std::span<const u32> code,
+                                                   const VkDevice device,
+                                                   const String& filename) {
+        VkShaderModuleCreateInfo createInfo = {};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size_bytes();
+        createInfo.pCode = code.data();
+
+        VkShaderModule shaderModule = VK_NULL_HANDLE;
+        if (vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader module: " + filename);
+        }
+
+        return shaderModule;
+    }
+
     VkShaderStageFlagBits VulkanTools::getShaderStage(const String& filename) {
         if (filename.ends_with(".vert.spv")) return VK_SHADER_STAGE_VERTEX_BIT;
         if (filename.ends_with(".frag.spv")) return VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -143,72 +261,4 @@ namespace time_kill::graphics {
 
         throw std::runtime_error("Unknown shader type: " + filename);
     }
-
-    template <typename T, typename F>
-    Vector<T*> spvReflectEnumerateVariables(SpvReflectShaderModule& module, F enumerateFunc) {
-        u32 count = 0;
-        enumerateFunc(&module, &count, nullptr);
-
-        Vector<T*> variables;
-        variables.reserve(count);
-        enumerateFunc(&module, &count, variables.data());
-
-        return variables;
-    }
-
-    void throwDuplicateLocationError(const String& filename, const u32 location, const bool input) {
-        std::ostringstream oss;
-        oss << "SPIRV-Reflect: Duplicate " << (input ? "input" : "output")
-            << " attribute location detected!\n"
-            << "File: " << filename << "\n"
-            << "Location: " << location << "\n";
-        throw std::runtime_error(oss.str());
-    }
-
-    Vector<VkVertexInputAttributeDescription> VulkanTools::parseVertexInputAttributes(
-        const Vector<char>& spirvCode,
-        const String& filename
-    ) {
-        SpvReflectShaderModule module;
-        if (const SpvReflectResult result =
-            spvReflectCreateShaderModule(spirvCode.size(), spirvCode.data(), &module);
-            result != SPV_REFLECT_RESULT_SUCCESS) {
-            throw std::runtime_error("Failed to reflect SPIR-V vertex shader: " + filename);
-        }
-
-        // Get input and output variables
-        const auto inputVars =
-            spvReflectEnumerateVariables<SpvReflectInterfaceVariable>(module, spvReflectEnumerateInputVariables);
-        const auto outputVars =
-            spvReflectEnumerateVariables<SpvReflectInterfaceVariable>(module, spvReflectEnumerateOutputVariables);
-
-        Vector<VkVertexInputAttributeDescription> attributes;
-        std::unordered_set<u32> inputLocations;
-        std::unordered_set<u32> outputLocations;
-
-        auto checkDuplicate = [&](const auto& vars, auto& locationSet, const bool isInput) {
-            for (const auto& var : vars) {
-                if (var->built_in != -1) continue;
-                if (!locationSet.insert(var->location).second) {
-                    spvReflectDestroyShaderModule(&module);
-                    throwDuplicateLocationError(filename, var->location, isInput);
-                }
-
-                if (isInput) {
-                    VkVertexInputAttributeDescription attribute = {};
-                    attribute.location = var->location;
-                    attribute.binding = 0;
-                    attribute.format = static_cast<VkFormat>(var->format);
-                    attribute.offset = 0;
-                    attributes.push_back(attribute);
-                }
-            }
-        };
-
-        checkDuplicate(inputVars, inputLocations, true);
-        checkDuplicate(outputVars, outputLocations, false);
-
-        spvReflectDestroyShaderModule(&module);
-        return attributes;
-    }
 }
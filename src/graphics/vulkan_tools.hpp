@@ -2,6 +2,7 @@
 
 #include "core/window.hpp"
 #include "vulkan_configuration.hpp"
+#include <span>
 #include <vulkan/vulkan.h>
 
 namespace time_kill::graphics {
@@ -29,8 +30,26 @@ namespace time_kill::graphics {
         );
 
         static String getDeviceName(VkPhysicalDevice_T* device);
+
+        //! Returns the index of a memory type that is allowed by `typeFilter` (a memoryTypeBits mask)
+        //! and has all of `properties`. Throws if there is none.
+        static uint32_t findMemoryType(VkPhysicalDevice_T* device, uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        static bool isDeviceExtensionSupported(VkPhysicalDevice_T* device, StringView extension);
+        static bool isInstanceExtensionSupported(StringView extension);
+
+        //! Aspects of a depth/stencil format that layout transitions must name.
+        static VkImageAspectFlags getDepthAspectMask(VkFormat format);
         static void queueWaitIdle(VkQueue_T* queue);
 
+        //! Returns `path` prefixed with the configured root directory if it is relative. Empty paths
+        //! (which disable the file they name) and absolute paths are returned unchanged.
+        static String resolvePath(const VulkanConfiguration& configuration, const String& path);
+
+        //! Returns the configured shader directories that exist, prefixed with the root directory.
+        //! If no shader directories are defined, the default path "assets/shaders/" is used; missing
+        //! directories are skipped with a warning.
+        static Vector<String> getShaderDirectories(const VulkanConfiguration& configuration);
+
         //! Retrieves all SPIR-V shader files from the specified shader directories.
         //!
         //! This method scans through the shader directories defined in the given VulkanConfiguration
@@ -47,9 +66,8 @@ namespace time_kill::graphics {
 
         static VkShaderStageFlagBits getShaderStage(const String& filename);
 
-        static Vector<VkVertexInputAttributeDescription> parseVertexInputAttributes(
-            const Vector<char>& spirvCode,
-            const String& filename
-        );
+        //! Reads a SPIR-V file; throws if it cannot be read or its size is not a multiple of 4.
+        static Vector<u32> readSpirvFile(const String& filename);
+        static VkShaderModule createShaderModule(std::span<const u32> code, VkDevice device, const String& filename);
     };
 }
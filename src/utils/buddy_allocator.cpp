@@ -0,0 +1,102 @@
+#include "buddy_allocator.hpp"
+#include <bit>
+#include <ranges>
+
+namespace time_kill::utils {
+    BuddyAllocator::BuddyAllocator(const u64 size, const u64 minBlockSize)
+        : size_(std::bit_floor(size)),
+          minBlockSize_(std::bit_ceil(std::max<u64>(minBlockSize, 1))) {
+        if (size_ < minBlockSize_) {
+            throw std::runtime_error("Buddy allocator size must be at least its minimum block size!");
+        }
+
+        const u32 maxOrder = static_cast<u32>(std::countr_zero(size_) - std::countr_zero(minBlockSize_));
+        freeLists_.resize(maxOrder + 1);
+        freeLists_[maxOrder].insert(0);
+    }
+
+    Optional<u64> BuddyAllocator::allocate(const u64 size, const u64 alignment) {
+        if (size == 0 || size > size_ || alignment > size_) {
+            return std::nullopt;
+        }
+
+        // A block is aligned to its own size, so asking for the alignment as size covers both
+        const u32 order = orderFor(std::max(size, alignment));
+
+        // Smallest order with a free block
+        u32 current = order;
+        while (current < freeLists_.size() && freeLists_[current].empty()) {
+            ++current;
+        }
+        if (current >= freeLists_.size()) {
+            return std::nullopt;
+        }
+
+        const u64 offset = *freeLists_[current].begin();
+        freeLists_[current].erase(freeLists_[current].begin());
+
+        // Split down to the requested order; the upper halves become free buddies
+        while (current > order) {
+            --current;
+            freeLists_[current].insert(offset + blockSize(current));
+        }
+
+        allocated_.emplace(offset, order);
+        used_ += blockSize(order);
+        return offset;
+    }
+
+    void BuddyAllocator::free(const u64 offset) {
+        const auto it = allocated_.find(offset);
+        if (it == allocated_.end()) {
+            throw std::runtime_error("Buddy allocator: freeing unknown offset " + std::to_string(offset));
+        }
+
+        u32 order = it->second;
+        allocated_.erase(it);
+        used_ -= blockSize(order);
+
+        // Merge with the buddy as long as it is free as a whole
+        u64 block = offset;
+        while (order + 1 < freeLists_.size()) {
+            const u64 buddy = block ^ blockSize(order);
+            auto& freeList = freeLists_[order];
+            const auto buddyIt = freeList.find(buddy);
+            if (buddyIt == freeList.end()) {
+                break;
+            }
+            freeList.erase(buddyIt);
+            block = std::min(block, buddy);
+            ++order;
+        }
+        freeLists_[order].insert(block);
+    }
+
+    u64 BuddyAllocator::getBlockSize(const u64 offset) const {
+        const auto it = allocated_.find(offset);
+        return it != allocated_.end() ? blockSize(it->second) : 0;
+    }
+
+    u64 BuddyAllocator::getLargestFreeBlock() const {
+        for (usize order = freeLists_.size(); order > 0; --order) {
+            if (!freeLists_[order - 1].empty()) {
+                return blockSize(static_cast<u32>(order - 1));
+            }
+        }
+        return 0;
+    }
+
+    Vector<u64> BuddyAllocator::getAllocatedOffsets() const {
+        Vector<u64> offsets;
+        offsets.reserve(allocated_.size());
+        for (const auto& offset : allocated_ | std::views::keys) {
+            offsets.push_back(offset);
+        }
+        return offsets;
+    }
+
+    u32 BuddyAllocator::orderFor(const u64 size) const {
+        const u64 rounded = std::bit_ceil(std::max(size, minBlockSize_));
+        return static_cast<u32>(std::countr_zero(rounded) - std::countr_zero(minBlockSize_));
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <set>
+#include <unordered_map>
+
+namespace time_kill::utils {
+    //! Binary buddy allocator over an abstract range [0, size). It only hands out offsets; the caller
+    //! owns the memory they refer to.
+    //!
+    //! Every allocation is rounded up to a power of two (at least `minBlockSize`) and placed at an
+    //! offset that is a multiple of its rounded size, so any power-of-two alignment up to that size
+    //! comes for free. Freed blocks are merged with their buddy, keeping fragmentation bounded.
+    //! Free blocks are handed out lowest offset first, which keeps live allocations packed.
+    class BuddyAllocator {
+    public:
+        BuddyAllocator() = default;
+
+        //! `size` and `minBlockSize` are rounded down / up to powers of two.
+        BuddyAllocator(u64 size, u64 minBlockSize);
+
+        //! Returns the offset of a block of at least `size` bytes aligned to `alignment` (a power of
+        //! two), or nothing if no free block is large enough.
+        [[nodiscard]] Optional<u64> allocate(u64 size, u64 alignment = 1);
+
+        //! Frees the block at `offset`, which must come from allocate().
+        void free(u64 offset);
+
+        //! Rounded size of the live block at `offset`, 0 if there is none.
+        [[nodiscard]] u64 getBlockSize(u64 offset) const;
+
+        [[nodiscard]] u64 getSize() const { return size_; }
+        [[nodiscard]] u64 getUsed() const { return used_; }
+        [[nodiscard]] usize getAllocationCount() const { return allocated_.size(); }
+        [[nodiscard]] bool isEmpty() const { return allocated_.empty(); }
+
+        //! Size of the largest block that can currently be allocated.
+        [[nodiscard]] u64 getLargestFreeBlock() const;
+
+        //! Offsets of all live blocks, in no particular order.
+        [[nodiscard]] Vector<u64> getAllocatedOffsets() const;
+
+    private:
+        [[nodiscard]] u32 orderFor(u64 size) const;
+        [[nodiscard]] u64 blockSize(const u32 order) const { return minBlockSize_ << order; }
+
+        u64 size_ = 0;
+        u64 minBlockSize_ = 1;
+        u64 used_ = 0;
+        Vector<std::set<u64>> freeLists_;           // Free block offsets per order, order 0 = minBlockSize
+        std::unordered_map<u64, u32> allocated_;    // Live block offset -> order
+    };
+}
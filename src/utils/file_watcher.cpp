@@ -0,0 +1,148 @@
+#include "file_watcher.hpp"
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace time_kill::utils {
+    namespace fs = std::filesystem;
+
+    FileWatcher::~FileWatcher() {
+        unwatchAll();
+    }
+
+#if defined(__linux__)
+    void FileWatcher::watch(const String& directory) {
+        if (inotifyDescriptor_ < 0) {
+            inotifyDescriptor_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (inotifyDescriptor_ < 0) {
+                throw std::runtime_error(String("Failed to initialize inotify: ") + std::strerror(errno));
+            }
+        }
+
+        addWatch(directory);
+        for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+            if (entry.is_directory()) {
+                addWatch(entry.path().string());
+            }
+        }
+    }
+
+    void FileWatcher::unwatchAll() {
+        if (inotifyDescriptor_ >= 0) {
+            ::close(inotifyDescriptor_);  // Removes all watches
+            inotifyDescriptor_ = -1;
+        }
+        directories_.clear();
+    }
+
+    bool FileWatcher::isWatching() const {
+        return !directories_.empty();
+    }
+
+    Vector<String> FileWatcher::poll() {
+        Vector<String> changed;
+        if (inotifyDescriptor_ < 0) {
+            return changed;
+        }
+
+        alignas(inotify_event) std::array<char, 4096> buffer;
+        while (true) {
+            const ssize_t length = ::read(inotifyDescriptor_, buffer.data(), buffer.size());
+            if (length <= 0) {
+                break; // EAGAIN: no more events
+            }
+
+            for (ssize_t offset = 0; offset < length;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                const auto directory = directories_.find(event->wd);
+                if (directory == directories_.end() || event->len == 0) {
+                    continue;
+                }
+                const String path = (fs::path(directory->second) / event->name).string();
+
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        try {
+                            watch(path);
+                        } catch (const std::exception&) {
+                            // Removed again before it could be watched
+                        }
+                    }
+                } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    changed.push_back(path);
+                }
+            }
+        }
+
+        // Editors often write a file several times in a row
+        std::ranges::sort(changed);
+        changed.erase(std::ranges::unique(changed).begin(), changed.end());
+        return changed;
+    }
+
+    void FileWatcher::addWatch(const String& directory) {
+        const int watchDescriptor = inotify_add_watch(inotifyDescriptor_, directory.c_str(),
+                                                      IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+        if (watchDescriptor < 0) {
+            throw std::runtime_error("Failed to watch directory '" + directory + "': " + std::strerror(errno));
+        }
+        directories_[watchDescriptor] = directory;
+    }
+#else
+    void FileWatcher::watch(const String& directory) {
+        if (!fs::is_directory(directory)) {
+            throw std::runtime_error("Failed to watch directory '" + directory + "': not a directory");
+        }
+        roots_.push_back(directory);
+        scan(directory, nullptr);
+    }
+
+    void FileWatcher::unwatchAll() {
+        roots_.clear();
+        timestamps_.clear();
+    }
+
+    bool FileWatcher::isWatching() const {
+        return !roots_.empty();
+    }
+
+    Vector<String> FileWatcher::poll() {
+        Vector<String> changed;
+        for (const auto& root : roots_) {
+            scan(root, &changed);
+        }
+        return changed;
+    }
+
+    void FileWatcher::scan(const String& root, Vector<String>* changed) {
+        std::error_code error;
+        for (const auto& entry : fs::recursive_directory_iterator(root, error)) {
+            if (!entry.is_regular_file(error)) {
+                continue;
+            }
+            const auto time = entry.last_write_time(error);
+            if (error) {
+                continue;
+            }
+            auto [it, inserted] = timestamps_.try_emplace(entry.path().string(), time);
+            if (!inserted && it->second != time) {
+                it->second = time;
+                if (changed != nullptr) {
+                    changed->push_back(it->first);
+                }
+            } else if (inserted && changed != nullptr) {
+                changed->push_back(it->first);
+            }
+        }
+    }
+#endif
+}
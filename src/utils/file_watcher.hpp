@@ -0,0 +1,47 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <unordered_map>
+
+#if !defined(__linux__)
+#include <filesystem>
+#endif
+
+namespace time_kill::utils {
+    //! Reports files that were written in a set of watched directory trees.
+    //!
+    //! On Linux this is inotify: a file is reported once the writer closes it or when it is moved or
+    //! renamed into a watched directory, so half-written files are never reported. New subdirectories
+    //! are watched as they appear. Other platforms fall back to comparing modification times on every
+    //! poll(), which is fine for the few dozen files of a shader directory.
+    class FileWatcher {
+    public:
+        FileWatcher() = default;
+        ~FileWatcher();
+
+        FileWatcher(const FileWatcher&) = delete;
+        FileWatcher& operator=(const FileWatcher&) = delete;
+
+        //! Watches `directory` and all its subdirectories. Throws if it cannot be watched.
+        void watch(const String& directory);
+        void unwatchAll();
+
+        [[nodiscard]] bool isWatching() const;
+
+        //! Returns the paths of the files changed since the last call, each at most once. Never blocks.
+        [[nodiscard]] Vector<String> poll();
+
+    private:
+#if defined(__linux__)
+        void addWatch(const String& directory);
+
+        int inotifyDescriptor_ = -1;
+        std::unordered_map<int, String> directories_; // Watch descriptor -> directory
+#else
+        void scan(const String& root, Vector<String>* changed);
+
+        Vector<String> roots_;
+        std::unordered_map<String, std::filesystem::file_time_type> timestamps_;
+#endif
+    };
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <span>
+#include <type_traits>
+
+namespace time_kill::utils {
+    constexpr u64 Fnv1aBasis = 0xcbf29ce484222325ull;
+
+    //! 64-bit FNV-1a hash, optionally continuing from a previous hash.
+    inline u64 fnv1a(const void* data, const usize size, u64 hash = Fnv1aBasis) {
+        const auto* bytes = static_cast<const u8*>(data);
+        for (usize i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    //! Incrementally hashes plain values, strings and arrays of plain values. Structs must not contain
+    //! padding (or must be zero-initialized) to hash deterministically.
+    class Hasher {
+    public:
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        Hasher& add(const T& value) {
+            hash_ = fnv1a(&value, sizeof(T), hash_);
+            return *this;
+        }
+
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        Hasher& add(const std::span<const T> values) {
+            add(values.size());
+            hash_ = fnv1a(values.data(), values.size_bytes(), hash_);
+            return *this;
+        }
+
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        Hasher& add(const Vector<T>& values) {
+            return add(std::span<const T>(values));
+        }
+
+        Hasher& add(const StringView text) {
+            return add(std::span<const char>(text.data(), text.size()));
+        }
+
+        Hasher& add(const String& text) {
+            return add(StringView(text));
+        }
+
+        [[nodiscard]] u64 get() const { return hash_; }
+
+    private:
+        u64 hash_ = Fnv1aBasis;
+    };
+}
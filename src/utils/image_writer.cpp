@@ -0,0 +1,166 @@
+#include "image_writer.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+
+namespace time_kill::utils {
+    namespace {
+        constexpr std::array<u32, 256> makeCrcTable() {
+            std::array<u32, 256> table = {};
+            for (u32 n = 0; n < 256; ++n) {
+                u32 c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            return table;
+        }
+
+        constexpr auto CrcTable = makeCrcTable();
+
+        u32 updateCrc(u32 crc, const u8* data, const usize size) {
+            for (usize i = 0; i < size; ++i) {
+                crc = CrcTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+            }
+            return crc;
+        }
+
+        //! Running Adler-32 of the zlib stream.
+        struct Adler32 {
+            u32 a = 1;
+            u32 b = 0;
+
+            void update(const u8* data, const usize size) {
+                for (usize i = 0; i < size; ++i) {
+                    a = (a + data[i]) % 65521;
+                    b = (b + a) % 65521;
+                }
+            }
+
+            [[nodiscard]] u32 value() const { return (b << 16) | a; }
+        };
+
+        void putU32(u8* out, const u32 value) {
+            out[0] = static_cast<u8>(value >> 24);
+            out[1] = static_cast<u8>(value >> 16);
+            out[2] = static_cast<u8>(value >> 8);
+            out[3] = static_cast<u8>(value);
+        }
+
+        //! Writes a PNG chunk whose data is produced piecewise by `writeData`, which gets a callback
+        //! to emit bytes through (so the CRC covers them).
+        template<typename WriteData>
+        void writeChunk(std::ostream& out, const char (&type)[5], const u32 length, WriteData&& writeData) {
+            u8 header[8];
+            putU32(header, length);
+            std::memcpy(header + 4, type, 4);
+            out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+            u32 crc = updateCrc(0xffffffffu, header + 4, 4);
+            writeData([&](const u8* data, const usize size) {
+                out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+                crc = updateCrc(crc, data, size);
+            });
+
+            u8 footer[4];
+            putU32(footer, crc ^ 0xffffffffu);
+            out.write(reinterpret_cast<const char*>(footer), sizeof(footer));
+        }
+    }
+
+    void writePpm(std::ostream& out, const u32 width, const u32 height, const std::span<const u8> rgb) {
+        if (rgb.size() < usize(width) * height * 3) {
+            throw std::invalid_argument("PPM image data is smaller than the image");
+        }
+
+        const String header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        out.write(header.data(), static_cast<std::streamsize>(header.size()));
+        out.write(reinterpret_cast<const char*>(rgb.data()), static_cast<std::streamsize>(usize(width) * height * 3));
+        if (!out) {
+            throw std::runtime_error("Failed to write PPM image");
+        }
+    }
+
+    void writePng(std::ostream& out, const u32 width, const u32 height, const std::span<const u8> rgba) {
+        const usize rowSize = usize(width) * 4;
+        if (rgba.size() < rowSize * height) {
+            throw std::invalid_argument("PNG image data is smaller than the image");
+        }
+
+        // Stored deflate blocks hold at most 65535 bytes; every row is prefixed by filter type 0
+        constexpr usize MaxBlockSize = 65535;
+        const usize rawSize = (rowSize + 1) * height;
+        const usize blockCount = rawSize == 0 ? 1 : (rawSize + MaxBlockSize - 1) / MaxBlockSize;
+        const usize idatSize = 2 + blockCount * 5 + rawSize + 4;
+        if (idatSize > 0x7fffffffu) {
+            throw std::invalid_argument("Image is too large for a single PNG chunk");
+        }
+
+        constexpr u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        out.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+        writeChunk(out, "IHDR", 13, [&](const auto& emit) {
+            u8 ihdr[13] = {};
+            putU32(ihdr, width);
+            putU32(ihdr + 4, height);
+            ihdr[8] = 8;    // Bit depth
+            ihdr[9] = 6;    // Color type RGBA
+            emit(ihdr, sizeof(ihdr));
+        });
+
+        writeChunk(out, "IDAT", static_cast<u32>(idatSize), [&](const auto& emit) {
+            constexpr u8 zlibHeader[2] = { 0x78, 0x01 };
+            emit(zlibHeader, sizeof(zlibHeader));
+
+            Adler32 adler;
+            usize remaining = rawSize;
+            usize row = 0;
+            usize rowOffset = 0;    // 0: the filter byte of `row` is next
+            constexpr u8 filter = 0;
+            do {
+                const auto blockSize = static_cast<u16>(std::min(remaining, MaxBlockSize));
+                remaining -= blockSize;
+                const u8 blockHeader[5] = {
+                    static_cast<u8>(remaining == 0 ? 1 : 0),
+                    static_cast<u8>(blockSize), static_cast<u8>(blockSize >> 8),
+                    static_cast<u8>(~blockSize), static_cast<u8>(~blockSize >> 8)
+                };
+                emit(blockHeader, sizeof(blockHeader));
+
+                // Block contents: rows with their filter byte, split wherever the block ends
+                usize left = blockSize;
+                while (left > 0) {
+                    if (rowOffset == 0) {
+                        emit(&filter, 1);
+                        adler.update(&filter, 1);
+                        --left;
+                        rowOffset = 1;
+                        continue;
+                    }
+                    const usize count = std::min(left, rowSize + 1 - rowOffset);
+                    const u8* data = rgba.data() + row * rowSize + (rowOffset - 1);
+                    emit(data, count);
+                    adler.update(data, count);
+                    left -= count;
+                    rowOffset += count;
+                    if (rowOffset == rowSize + 1) {
+                        ++row;
+                        rowOffset = 0;
+                    }
+                }
+            } while (remaining > 0);
+
+            u8 checksum[4];
+            putU32(checksum, adler.value());
+            emit(checksum, sizeof(checksum));
+        });
+
+        writeChunk(out, "IEND", 0, [](const auto&) {});
+
+        if (!out) {
+            throw std::runtime_error("Failed to write PNG image");
+        }
+    }
+}
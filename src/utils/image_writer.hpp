@@ -0,0 +1,15 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <ostream>
+#include <span>
+
+namespace time_kill::utils {
+    //! Writes 8-bit RGB pixels, tightly packed and top row first, as binary PPM (P6).
+    void writePpm(std::ostream& out, u32 width, u32 height, std::span<const u8> rgb);
+
+    //! Writes 8-bit RGBA pixels, tightly packed and top row first, as PNG. The image data goes into
+    //! uncompressed deflate blocks: no zlib dependency and no compression cost per frame, at the
+    //! price of files about as large as the raw pixels.
+    void writePng(std::ostream& out, u32 width, u32 height, std::span<const u8> rgba);
+}
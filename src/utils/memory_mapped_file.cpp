@@ -0,0 +1,220 @@
+#include "memory_mapped_file.hpp"
+#include <utility>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace time_kill::utils {
+    MemoryMappedFile::~MemoryMappedFile() {
+        close();
+    }
+
+    MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            writable_ = std::exchange(other.writable_, false);
+            path_ = std::move(other.path_);
+#if defined(_WIN32) || defined(_WIN64)
+            fileHandle_ = std::exchange(other.fileHandle_, nullptr);
+            mappingHandle_ = std::exchange(other.mappingHandle_, nullptr);
+#else
+            fileDescriptor_ = std::exchange(other.fileDescriptor_, -1);
+#endif
+        }
+        return *this;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    void MemoryMappedFile::openReadOnly(const String& path) {
+        close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to open file for mapping: " + path);
+        }
+
+        LARGE_INTEGER fileSize = {};
+        GetFileSizeEx(file, &fileSize);
+        if (fileSize.QuadPart == 0) {
+            CloseHandle(file);
+            throw std::runtime_error("Cannot map empty file: " + path);
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view == nullptr) {
+            if (mapping != nullptr) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+
+        fileHandle_ = file;
+        mappingHandle_ = mapping;
+        data_ = static_cast<std::byte*>(view);
+        size_ = static_cast<usize>(fileSize.QuadPart);
+        writable_ = false;
+        path_ = path;
+    }
+
+    void MemoryMappedFile::create(const String& path, const usize size) {
+        close();
+
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                  CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Failed to create file for mapping: " + path);
+        }
+
+        LARGE_INTEGER mappingSize = {};
+        mappingSize.QuadPart = static_cast<LONGLONG>(size);
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE,
+                                           static_cast<DWORD>(mappingSize.HighPart), mappingSize.LowPart, nullptr);
+        void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+        if (view == nullptr) {
+            if (mapping != nullptr) {
+                CloseHandle(mapping);
+            }
+            CloseHandle(file);
+            throw std::runtime_error("Failed to map file: " + path);
+        }
+
+        fileHandle_ = file;
+        mappingHandle_ = mapping;
+        data_ = static_cast<std::byte*>(view);
+        size_ = size;
+        writable_ = true;
+        path_ = path;
+    }
+
+    void MemoryMappedFile::close(const Optional<usize> finalSize) {
+        if (data_ != nullptr) {
+            if (writable_) {
+                FlushViewOfFile(data_, 0);
+            }
+            UnmapViewOfFile(data_);
+        }
+        if (mappingHandle_ != nullptr) {
+            CloseHandle(mappingHandle_);
+        }
+        if (fileHandle_ != nullptr) {
+            if (writable_ && finalSize.has_value()) {
+                LARGE_INTEGER position = {};
+                position.QuadPart = static_cast<LONGLONG>(*finalSize);
+                SetFilePointerEx(fileHandle_, position, nullptr, FILE_BEGIN);
+                SetEndOfFile(fileHandle_);
+            }
+            CloseHandle(fileHandle_);
+        }
+        reset();
+    }
+
+    void MemoryMappedFile::flushAsync() const {
+        if (data_ != nullptr && writable_) {
+            FlushViewOfFile(data_, 0);
+        }
+    }
+
+    void MemoryMappedFile::reset() noexcept {
+        data_ = nullptr;
+        size_ = 0;
+        writable_ = false;
+        fileHandle_ = nullptr;
+        mappingHandle_ = nullptr;
+        path_.clear();
+    }
+#else
+    void MemoryMappedFile::openReadOnly(const String& path) {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open file for mapping: " + path + " (" + std::strerror(errno) + ")");
+        }
+
+        struct stat info = {};
+        if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map empty or unreadable file: " + path);
+        }
+
+        void* view = ::mmap(nullptr, static_cast<usize>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map file: " + path + " (" + std::strerror(errno) + ")");
+        }
+
+        fileDescriptor_ = fd;
+        data_ = static_cast<std::byte*>(view);
+        size_ = static_cast<usize>(info.st_size);
+        writable_ = false;
+        path_ = path;
+    }
+
+    void MemoryMappedFile::create(const String& path, const usize size) {
+        close();
+
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to create file for mapping: " + path + " (" + std::strerror(errno) + ")");
+        }
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to resize file for mapping: " + path + " (" + std::strerror(errno) + ")");
+        }
+
+        void* view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Failed to map file: " + path + " (" + std::strerror(errno) + ")");
+        }
+
+        fileDescriptor_ = fd;
+        data_ = static_cast<std::byte*>(view);
+        size_ = size;
+        writable_ = true;
+        path_ = path;
+    }
+
+    void MemoryMappedFile::close(const Optional<usize> finalSize) {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+        if (fileDescriptor_ >= 0) {
+            if (writable_ && finalSize.has_value()) {
+                [[maybe_unused]] const int result = ::ftruncate(fileDescriptor_, static_cast<off_t>(*finalSize));
+            }
+            ::close(fileDescriptor_);
+        }
+        reset();
+    }
+
+    void MemoryMappedFile::flushAsync() const {
+        if (data_ != nullptr && writable_) {
+            ::msync(data_, size_, MS_ASYNC);
+        }
+    }
+
+    void MemoryMappedFile::reset() noexcept {
+        data_ = nullptr;
+        size_ = 0;
+        writable_ = false;
+        fileDescriptor_ = -1;
+        path_.clear();
+    }
+#endif
+}
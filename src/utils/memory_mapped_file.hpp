@@ -0,0 +1,51 @@
+#pragma once
+
+#include "prerequisites.hpp"
+#include <cstddef>
+
+namespace time_kill::utils {
+    //! Thin RAII wrapper around a memory-mapped file (mmap on POSIX, file mappings on Windows).
+    class MemoryMappedFile {
+    public:
+        MemoryMappedFile() = default;
+        ~MemoryMappedFile();
+
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+        MemoryMappedFile(MemoryMappedFile&& other) noexcept;
+        MemoryMappedFile& operator=(MemoryMappedFile&& other) noexcept;
+
+        //! Maps an existing file read-only. Throws if the file cannot be opened or mapped.
+        void openReadOnly(const String& path);
+
+        //! Creates (or truncates) a file of `size` bytes and maps it writable.
+        void create(const String& path, usize size);
+
+        //! Unmaps and closes the file. A writable file is truncated to `finalSize` if one is given.
+        void close(Optional<usize> finalSize = std::nullopt);
+
+        //! Schedules dirty pages of a writable mapping to be written back (does not block).
+        void flushAsync() const;
+
+        [[nodiscard]] bool isOpen() const { return data_ != nullptr; }
+        [[nodiscard]] bool isWritable() const { return writable_; }
+        [[nodiscard]] std::byte* data() { return data_; }
+        [[nodiscard]] const std::byte* data() const { return data_; }
+        [[nodiscard]] usize size() const { return size_; }
+        [[nodiscard]] const String& path() const { return path_; }
+
+    private:
+        void reset() noexcept;
+
+        std::byte* data_ = nullptr;
+        usize size_ = 0;
+        bool writable_ = false;
+        String path_;
+#if defined(_WIN32) || defined(_WIN64)
+        void* fileHandle_ = nullptr;
+        void* mappingHandle_ = nullptr;
+#else
+        int fileDescriptor_ = -1;
+#endif
+    };
+}
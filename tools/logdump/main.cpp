@@ -0,0 +1,136 @@
+#include "core/binary_log_reader.hpp"
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace time_kill;
+using namespace time_kill::core;
+
+namespace {
+    constexpr auto USAGE =
+        "Usage: time_kill_logdump [options] <file>...\n"
+        "Decodes binary log files written by the time_kill logger back into text.\n"
+        "\n"
+        "Options:\n"
+        "  --level=<TRACE|DEBUG|INFO|WARN|ERROR>  Only print records at or above this level\n"
+        "  --from=<YYYY-MM-DD HH:MM:SS>           Only print records at or after this local time\n"
+        "  --to=<YYYY-MM-DD HH:MM:SS>             Only print records before this local time\n"
+        "  --date-format=<dmy|mdy|ymd>            Date format of the output (default: dmy)\n"
+        "  --thread-ids                           Prefix every message with its thread id\n";
+
+    struct Options {
+        LogLevel minLevel = LogLevel::TRACE;
+        Optional<std::chrono::system_clock::time_point> from;
+        Optional<std::chrono::system_clock::time_point> to;
+        DateFormat dateFormat = DateFormat::DD_MM_YYYY;
+        DateSeparator separator = DateSeparator::Hyphen;
+        bool threadIds = false;
+        Vector<String> files;
+    };
+
+    Optional<LogLevel> parseLevel(const StringView text) {
+        if (text == "TRACE") return LogLevel::TRACE;
+        if (text == "DEBUG") return LogLevel::DEBUG;
+        if (text == "INFO")  return LogLevel::INFO;
+        if (text == "WARN")  return LogLevel::WARN;
+        if (text == "ERROR") return LogLevel::ERROR;
+        return std::nullopt;
+    }
+
+    Optional<std::chrono::system_clock::time_point> parseLocalTime(const String& text) {
+        std::tm tm = {};
+        std::istringstream stream(text);
+        stream >> std::get_time(&tm, "%Y-%m-%d %H:%M:%S");
+        if (stream.fail()) {
+            return std::nullopt;
+        }
+        tm.tm_isdst = -1;
+        return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+    }
+
+    Optional<Options> parseOptions(const int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const String arg = argv[i];
+            const auto value = [&](const StringView prefix) { return arg.substr(prefix.size()); };
+
+            if (arg.starts_with("--level=")) {
+                const auto level = parseLevel(value("--level="));
+                if (!level) {
+                    std::cerr << "Unknown level: " << value("--level=") << "\n";
+                    return std::nullopt;
+                }
+                options.minLevel = *level;
+            } else if (arg.starts_with("--from=") || arg.starts_with("--to=")) {
+                const bool isFrom = arg.starts_with("--from=");
+                const auto time = parseLocalTime(value(isFrom ? "--from=" : "--to="));
+                if (!time) {
+                    std::cerr << "Invalid time (expected YYYY-MM-DD HH:MM:SS): " << arg << "\n";
+                    return std::nullopt;
+                }
+                (isFrom ? options.from : options.to) = time;
+            } else if (arg.starts_with("--date-format=")) {
+                const String format = value("--date-format=");
+                if (format == "dmy") {
+                    options.dateFormat = DateFormat::DD_MM_YYYY;
+                } else if (format == "mdy") {
+                    options.dateFormat = DateFormat::MM_DD_YYYY;
+                    options.separator = DateSeparator::Slash;
+                } else if (format == "ymd") {
+                    options.dateFormat = DateFormat::YYYY_MM_DD;
+                } else {
+                    std::cerr << "Unknown date format: " << format << "\n";
+                    return std::nullopt;
+                }
+            } else if (arg == "--thread-ids") {
+                options.threadIds = true;
+            } else if (arg == "--help" || arg == "-h") {
+                return std::nullopt;
+            } else if (arg.starts_with("--")) {
+                std::cerr << "Unknown option: " << arg << "\n";
+                return std::nullopt;
+            } else {
+                options.files.push_back(arg);
+            }
+        }
+
+        if (options.files.empty()) {
+            return std::nullopt;
+        }
+        return options;
+    }
+}
+
+int main(const int argc, char** argv) {
+    const auto options = parseOptions(argc, argv);
+    if (!options) {
+        std::cerr << USAGE;
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    for (const auto& file : options->files) {
+        try {
+            const BinaryLogReader reader(file);
+            reader.forEach([&](const DecodedLogRecord& record) {
+                if (record.level < options->minLevel) return true;
+                if (options->from && record.time < *options->from) return true;
+                if (options->to && record.time >= *options->to) return true;
+
+                if (options->threadIds) {
+                    DecodedLogRecord withThread = record;
+                    withThread.message = "(" + std::to_string(record.threadId) + ") " + record.message;
+                    std::cout << BinaryLogReader::formatLine(withThread, options->dateFormat, options->separator) << "\n";
+                } else {
+                    std::cout << BinaryLogReader::formatLine(record, options->dateFormat, options->separator) << "\n";
+                }
+                return true;
+            });
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,143 @@
+#include "graphics/shader_bundle_format.hpp"
+#include "graphics/shader_reflection.hpp"
+#include "graphics/vulkan_tools.hpp"
+#include "utils/hash.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using namespace time_kill;
+using namespace time_kill::graphics;
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr auto USAGE =
+        "Usage: time_kill_shaderpack <shader directory> <output bundle>\n"
+        "Packs all compiled SPIR-V shaders (*.spv) below the directory into one shader bundle with a\n"
+        "table of contents, aligned SPIR-V blobs, precomputed reflection data and content hashes.\n";
+
+    struct PackedShader {
+        String name;
+        VkShaderStageFlagBits stage = VK_SHADER_STAGE_VERTEX_BIT;
+        Vector<u32> code;
+        ShaderReflection reflection;
+        Vector<u8> reflectionData;
+    };
+
+    Vector<PackedShader> collectShaders(const fs::path& directory) {
+        Vector<PackedShader> shaders;
+        for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".spv") {
+                continue;
+            }
+
+            PackedShader shader;
+            shader.name = fs::relative(entry.path(), directory).generic_string();
+            shader.stage = VulkanTools::getShaderStage(shader.name);
+            shader.code = VulkanTools::readSpirvFile(entry.path().string());
+            shader.reflection = ShaderReflection::reflect(shader.code, shader.name);
+            shader.reflectionData = shader.reflection.serialize();
+            shaders.push_back(std::move(shader));
+        }
+
+        // The reader looks shaders up by binary search
+        std::ranges::sort(shaders, {}, &PackedShader::name);
+        return shaders;
+    }
+
+    Vector<u8> buildBundle(const Vector<PackedShader>& shaders) {
+        using namespace shaderbundle;
+
+        // Layout: header | entries | names | reflection data | aligned blobs
+        u64 offset = sizeof(FileHeader) + shaders.size() * sizeof(Entry);
+        Vector<Entry> entries(shaders.size());
+        for (usize i = 0; i < shaders.size(); ++i) {
+            entries[i].nameOffset = static_cast<u32>(offset);
+            entries[i].nameLength = static_cast<u32>(shaders[i].name.size());
+            offset += shaders[i].name.size();
+        }
+        for (usize i = 0; i < shaders.size(); ++i) {
+            entries[i].reflectionOffset = offset;
+            entries[i].reflectionSize = static_cast<u32>(shaders[i].reflectionData.size());
+            offset += shaders[i].reflectionData.size();
+        }
+
+        FileHeader header;
+        header.entryCount = static_cast<u32>(shaders.size());
+        header.entrySize = sizeof(Entry);
+        utils::Hasher contentHash;
+        for (usize i = 0; i < shaders.size(); ++i) {
+            offset = alignBlobOffset(offset);
+            entries[i].stage = shaders[i].stage;
+            entries[i].codeOffset = offset;
+            entries[i].codeSize = shaders[i].code.size() * sizeof(u32);
+            entries[i].contentHash = utils::fnv1a(shaders[i].code.data(), entries[i].codeSize);
+            contentHash.add(entries[i].contentHash);
+            offset += entries[i].codeSize;
+        }
+        header.fileSize = offset;
+        header.contentHash = contentHash.get();
+
+        Vector<u8> bundle(header.fileSize, 0);
+        const auto write = [&bundle](const u64 at, const void* data, const usize size) {
+            std::memcpy(bundle.data() + at, data, size);
+        };
+
+        write(0, &header, sizeof(header));
+        write(sizeof(FileHeader), entries.data(), entries.size() * sizeof(Entry));
+        for (usize i = 0; i < shaders.size(); ++i) {
+            write(entries[i].nameOffset, shaders[i].name.data(), shaders[i].name.size());
+            write(entries[i].reflectionOffset, shaders[i].reflectionData.data(), shaders[i].reflectionData.size());
+            write(entries[i].codeOffset, shaders[i].code.data(), entries[i].codeSize);
+        }
+        return bundle;
+    }
+}
+
+int main(const int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << USAGE;
+        return 1;
+    }
+
+    try {
+        const fs::path directory(argv[1]);
+        const fs::path output(argv[2]);
+        if (!fs::is_directory(directory)) {
+            std::cerr << "Not a directory: " << directory.string() << "\n";
+            return 1;
+        }
+
+        const auto shaders = collectShaders(directory);
+        const auto bundle = buildBundle(shaders);
+
+        // Replace the bundle atomically; a running engine may have the old one mapped
+        fs::path temporary = output;
+        temporary += ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(bundle.data()), static_cast<std::streamsize>(bundle.size()));
+            if (!file) {
+                std::cerr << "Failed to write " << temporary.string() << "\n";
+                return 1;
+            }
+        }
+        fs::rename(temporary, output);
+
+        std::cout << "Packed " << shaders.size() << " shaders (" << bundle.size() << " bytes) into "
+                  << output.string() << "\n";
+        for (const auto& shader : shaders) {
+            std::cout << "  " << shader.name << " (" << shader.code.size() * sizeof(u32) << " bytes, "
+                      << shader.reflection.vertexInputs.size() << " vertex inputs, "
+                      << shader.reflection.descriptorBindings.size() << " descriptor bindings, "
+                      << shader.reflection.specializationConstants.size() << " specialization constants)\n";
+        }
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}